@@ -179,6 +179,27 @@
 #define L2CAP_TIMEOUT_MULTIPLIER        0x1F4
 
 /* USER CODE BEGIN Specific_Parameters */
+/* Connection parameter policy, see conn_policy.h. The supervision timeout
+   (10 ms units) must exceed 2 x (1 + latency) x the idle interval max */
+#define CONN_POLICY_ACTIVE_INTERVAL       CONN_P(7.5)   /* 7.5ms */
+#define CONN_POLICY_ACTIVE_LATENCY        0
+#define CONN_POLICY_IDLE_INTERVAL_MIN     CONN_P(300)   /* 300ms */
+#define CONN_POLICY_IDLE_INTERVAL_MAX     CONN_P(400)   /* 400ms */
+#define CONN_POLICY_IDLE_LATENCY          4
+#define CONN_POLICY_SUPERVISION_TIMEOUT   600           /* 6s */
+#define CONN_POLICY_IDLE_TIMEOUT_MS       5000U
+
+/* HCI asynchronous events reported per hci_user_evt_proc() run, and the
+   time after which a run gives the other tasks a turn anyway */
+#define CFG_TLBLE_EVT_BATCH_MAX           8
+#define CFG_TLBLE_EVT_BATCH_BUDGET_US     2000
+/* ACI commands hci_send_req_async() can hold */
+#define CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH  4
+/* Histogram of the BLE event latency, see TL_MM_GetEvtLatency() */
+#define CFG_TL_EVT_LATENCY_STATS          1
+/* Time for the sequencer to run hci_user_evt_proc() once an event arrives
+   on an empty queue, ms. B_LED_C writes reach the lamps through it */
+#define CFG_TLBLE_EVT_DEADLINE_MS         2
 
 /* USER CODE END Specific_Parameters */
 
@@ -474,7 +495,14 @@
  *  When set to 1, the low power mode is enable
  *  When set to 0, the device stays in RUN mode
  */
-#define CFG_LPM_SUPPORTED    0
+#define CFG_LPM_SUPPORTED    1
+
+/**
+ * Stop mode is entered from the idle loop only when the next timer server
+ * expiry is at least this number of ticks away, otherwise Sleep mode is used
+ * (Stop2 exit and HSE restart cost more than they save)
+ */
+#define CFG_LPM_STOP_MIN_TICKS    4
 
 /******************************************************************************
  * RTC interface
@@ -558,6 +586,10 @@
 /** tick timer values */
 #define CFG_TS_TICK_VAL           DIVR( (CFG_RTCCLK_DIV * 1000000), LSE_VALUE )
 #define CFG_TS_TICK_VAL_PS        DIVR( ((uint64_t)CFG_RTCCLK_DIV * 1e12), (uint64_t)LSE_VALUE )
+#define CFG_TS_TICKS_PER_SEC      (LSE_VALUE / CFG_RTCCLK_DIV)
+
+/** ms to timer server ticks, rounded down; ms * CFG_TS_TICKS_PER_SEC must not overflow */
+#define HW_TS_MS_TO_TICKS(ms)     (((ms) * CFG_TS_TICKS_PER_SEC) / 1000U)
 
 typedef enum
 {
@@ -605,10 +637,13 @@ typedef enum
 #define CFG_DEBUG_TRACE             1
 #endif
 
+/**
+ * The traces do not force the low power mode off: Stop mode is only held off
+ * while a trace transfer runs (CFG_LPM_APP_TRACE) and while the console is in
+ * use (CFG_LPM_APP_CONSOLE), see app_debug.c and console.c
+ */
 #if (CFG_DEBUG_TRACE != 0)
-#undef CFG_LPM_SUPPORTED
 #undef CFG_DEBUGGER_SUPPORTED
-#define CFG_LPM_SUPPORTED           0
 #define CFG_DEBUGGER_SUPPORTED      1
 #endif
 
@@ -622,6 +657,13 @@ typedef enum
 #define CFG_DEBUG_TRACE_LIGHT     1
 #define CFG_DEBUG_TRACE_FULL      0
 
+/**
+ * When set to 1, the traces are not formatted on the target: a binary record of the format string
+ * offset and the arguments is sent instead, to be decoded on the host with tools/dbg_trace_decode.py
+ * and the ELF file of the build
+ */
+#define CFG_DEBUG_TRACE_BINARY    1
+
 #if (( CFG_DEBUG_TRACE != 0 ) && ( CFG_DEBUG_TRACE_LIGHT == 0 ) && (CFG_DEBUG_TRACE_FULL == 0))
 #undef CFG_DEBUG_TRACE_FULL
 #undef CFG_DEBUG_TRACE_LIGHT
@@ -644,6 +686,7 @@ typedef enum
 /**
  * max buffer Size to queue data traces and max data trace allowed.
  * Only Used if DBG_TRACE_USE_CIRCULAR_QUEUE is defined
+ * DBG_TRACE_MSG_QUEUE_SIZE shall be a power of two
  */
 #define DBG_TRACE_MSG_QUEUE_SIZE 4096
 #define MAX_DBG_TRACE_MSG_SIZE   1024
@@ -678,6 +721,8 @@ typedef enum
   CFG_TASK_HCI_ASYNCH_EVT_ID,
   /* USER CODE BEGIN CFG_Task_Id_With_HCI_Cmd_t */
   CFG_TASK_SW1_BUTTON_PUSHED_ID,
+  CFG_TASK_TELEMETRY_TX_ID,
+  CFG_TASK_CONN_POLICY_ID,
 //  CFG_TASK_SW2_BUTTON_PUSHED_ID,
 //  CFG_TASK_SW3_BUTTON_PUSHED_ID,
   /* USER CODE END CFG_Task_Id_With_HCI_Cmd_t */
@@ -690,7 +735,7 @@ typedef enum
   CFG_FIRST_TASK_ID_WITH_NO_HCICMD = CFG_LAST_TASK_ID_WITH_HCICMD - 1,        /**< Shall be FIRST in the list */
   CFG_TASK_SYSTEM_HCI_ASYNCH_EVT_ID,
   /* USER CODE BEGIN CFG_Task_Id_With_NO_HCI_Cmd_t */
-
+  CFG_TASK_CONSOLE_ID,
   /* USER CODE END CFG_Task_Id_With_NO_HCI_Cmd_t */
   CFG_LAST_TASK_ID_WITH_NO_HCICMD                                            /**< Shall be LAST in the list */
 } CFG_Task_Id_With_NO_HCI_Cmd_t;
@@ -705,6 +750,7 @@ typedef enum
 {
   CFG_SCH_PRIO_0,
   /* USER CODE BEGIN CFG_SCH_Prio_Id_t */
+  CFG_SCH_PRIO_1,   /**< Background: button, telemetry, run when PRIO_0 is idle */
 
   /* USER CODE END CFG_SCH_Prio_Id_t */
   CFG_SCH_PRIO_NBR
@@ -734,6 +780,9 @@ typedef enum
   CFG_LPM_APP,
   CFG_LPM_APP_BLE,
   /* USER CODE BEGIN CFG_LPM_Id_t */
+  CFG_LPM_APP_IDLE,
+  CFG_LPM_APP_TRACE,
+  CFG_LPM_APP_CONSOLE,
 
   /* USER CODE END CFG_LPM_Id_t */
 } CFG_LPM_Id_t;
@@ -0,0 +1,50 @@
+/**
+  ******************************************************************************
+  * @file           : conn_policy.h
+  * @brief          : Connection parameters following the client activity.
+  ******************************************************************************
+  * While the client writes B_LED_C the link is asked for the shortest
+  * connection interval with no peripheral latency, so a command reaches the
+  * lamps within one interval. Once the client has been quiet for
+  * CONN_POLICY_IDLE_TIMEOUT_MS the link is asked to fall back to a long
+  * interval with peripheral latency. The parameters are set in app_conf.h.
+  *
+  * Only one L2CAP connection parameter update request is outstanding at a
+  * time; a change of mode while one is pending is requested once it ends.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CONN_POLICY_H
+#define __CONN_POLICY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Requests;    /*!< L2CAP update requests sent */
+  uint32_t Rejected;    /*!< Requests rejected by the central or timed out */
+  uint32_t ToActive;    /*!< Updates completed into the active parameters */
+  uint32_t ToIdle;      /*!< Updates completed into the idle parameters */
+} CONN_POLICY_StatsTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void CONN_POLICY_Init(void);
+void CONN_POLICY_Connected(uint16_t ConnectionHandle);
+void CONN_POLICY_Disconnected(void);
+void CONN_POLICY_Activity(void);
+void CONN_POLICY_Updated(uint16_t Interval, uint16_t Latency);
+void CONN_POLICY_Response(uint8_t Accepted);
+const CONN_POLICY_StatsTypeDef *CONN_POLICY_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CONN_POLICY_H */
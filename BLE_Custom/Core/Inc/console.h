@@ -0,0 +1,66 @@
+/**
+  ******************************************************************************
+  * @file           : console.h
+  * @brief          : Command console on the debug trace UART.
+  ******************************************************************************
+  * The UART is received by a circular DMA. The idle line, half and full
+  * transfer interrupts only note how far the DMA wrote and set the console
+  * task, so the interrupt time does not depend on the traffic and commands
+  * can be sent back to back at the full UART rate.
+  *
+  * The task cuts the received bytes into lines on CR or LF. A line is a
+  * command name followed by up to CONSOLE_MAX_ARGS arguments separated by
+  * spaces; names are matched ignoring case against the table in console.c.
+  * "help" lists the commands.
+  *
+  * The UART does not receive in Stop mode, so Stop is held off while the
+  * console is in use, until CONSOLE_ACTIVE_MS after the last byte. When Stop
+  * is allowed, a falling edge on the RX pin wakes the core through its EXTI
+  * line: the first character typed then is lost, the following ones are
+  * received.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CONSOLE_H
+#define __CONSOLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* DMA reception buffer in bytes, power of two. The task has to run before
+   the DMA laps it: 256 bytes last 22 ms at 115200 baud */
+#define CONSOLE_RX_SIZE           256U
+/* Longest line, longer ones are discarded */
+#define CONSOLE_LINE_SIZE         128U
+#define CONSOLE_MAX_ARGS          4U
+/* Stop mode stays off this long after the last received byte */
+#define CONSOLE_ACTIVE_MS         30000U
+/* USART1_RX (PB7), also used as an EXTI line to wake up from Stop mode */
+#define CONSOLE_WAKE_PIN          GPIO_PIN_7
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Lines;       /*!< Lines received */
+  uint32_t Unknown;     /*!< Lines with no matching command */
+  uint32_t TooLong;     /*!< Lines discarded for exceeding CONSOLE_LINE_SIZE */
+  uint32_t Restarts;    /*!< Receptions restarted after a UART error */
+  uint32_t Wakeups;     /*!< Wake ups from Stop mode by the RX pin */
+} CONSOLE_StatsTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void CONSOLE_Init(void);
+void CONSOLE_Wakeup(void);
+const CONSOLE_StatsTypeDef *CONSOLE_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CONSOLE_H */
@@ -103,8 +103,10 @@
 /**
  * The user may define the maximum number of virtual timers supported.
  * It shall not exceed 255
+ * Starting or stopping one of n running timers costs O(log n) with the interrupts masked
+ * (host/bench_hw_ts.c measures it from 1 to CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER running timers)
  */
-#define CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER  6
+#define CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER  32
 
 /**
  * The user may define the priority in the NVIC of the RTC_WKUP interrupt handler that is used to manage the
@@ -164,6 +166,7 @@
 
 #define CFG_HW_USART1_ENABLED           1
 #define CFG_HW_USART1_DMA_TX_SUPPORTED  1
+#define CFG_HW_USART1_DMA_RX_SUPPORTED  1
 
 /**
  * LPUART1
@@ -253,4 +256,12 @@
 #define CFG_HW_USART1_TX_DMA_IRQn             DMA2_Channel4_IRQn
 #define CFG_HW_USART1_DMA_TX_IRQHandler       DMA2_Channel4_IRQHandler
 
+#define CFG_HW_USART1_DMA_RX_PREEMPTPRIORITY  0x0F
+#define CFG_HW_USART1_DMA_RX_SUBPRIORITY      0
+
+#define CFG_HW_USART1_RX_DMA_REQ              DMA_REQUEST_USART1_RX
+#define CFG_HW_USART1_RX_DMA_CHANNEL          DMA2_Channel5
+#define CFG_HW_USART1_RX_DMA_IRQn             DMA2_Channel5_IRQn
+#define CFG_HW_USART1_DMA_RX_IRQHandler       DMA2_Channel5_IRQHandler
+
 #endif /*HW_CONF_H */
@@ -73,11 +73,18 @@ extern "C" {
     hw_uart_to,
   } hw_status_t;
 
+  /**
+   * Position given to the HW_UART_ReceiveToIdle_DMA() callback when a reception error stopped the DMA.
+   * The reception has to be started again
+   */
+#define HW_UART_RX_STOPPED    0xFFFFU
+
   void HW_UART_Init(hw_uart_id_t hw_uart_id);
   void HW_UART_Receive_IT(hw_uart_id_t hw_uart_id, uint8_t *pData, uint16_t Size, void (*Callback)(void));
   void HW_UART_Transmit_IT(hw_uart_id_t hw_uart_id, uint8_t *pData, uint16_t Size,  void (*Callback)(void));
   hw_status_t HW_UART_Transmit(hw_uart_id_t hw_uart_id, uint8_t *p_data, uint16_t size,  uint32_t timeout);
   hw_status_t HW_UART_Transmit_DMA(hw_uart_id_t hw_uart_id, uint8_t *p_data, uint16_t size, void (*Callback)(void));
+  hw_status_t HW_UART_ReceiveToIdle_DMA(hw_uart_id_t hw_uart_id, uint8_t *p_data, uint16_t size, void (*Callback)(uint16_t));
   void HW_UART_Interrupt_Handler(hw_uart_id_t hw_uart_id);
   void HW_UART_DMA_Interrupt_Handler(hw_uart_id_t hw_uart_id);
 
@@ -0,0 +1,37 @@
+/**
+  ******************************************************************************
+  * @file           : lamps.h
+  * @brief          : Traffic light lamp outputs.
+  ******************************************************************************
+  * A 3-bit state (bit0 = green, bit1 = yellow, bit2 = red) is mapped to one
+  * precomputed BSRR word per GPIO port, so every port switches all of its
+  * lamps with a single store. Every write is also queued as a telemetry
+  * record. Safe to call from interrupts.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LAMPS_H
+#define __LAMPS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define LAMPS_STATE_GREEN   0x01U
+#define LAMPS_STATE_YELLOW  0x02U
+#define LAMPS_STATE_RED     0x04U
+#define LAMPS_STATE_MASK    0x07U
+
+/* Exported functions prototypes ---------------------------------------------*/
+void Lamps_Write(uint8_t state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LAMPS_H */
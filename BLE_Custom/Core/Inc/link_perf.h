@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file           : link_perf.h
+  * @brief          : Data length and PHY upgrade, link figures on LINK_C.
+  ******************************************************************************
+  * On connection the peripheral asks for 251-byte LL PDUs and the 2M PHY.
+  * The figures in force are kept up to date from the HCI events and
+  * published as the LINK_C value (all fields little endian):
+  *
+  *   offset 0   TX PHY, 1 = 1M, 2 = 2M, 3 = coded
+  *   offset 1   RX PHY
+  *   offset 2   max TX octets per LL PDU (2 bytes)
+  *   offset 4   max RX octets per LL PDU (2 bytes)
+  *   offset 6   connection interval, 1.25 ms units (2 bytes)
+  *   offset 8   ATT_MTU (2 bytes)
+  *   offset 10  estimated ATT payload rate peripheral to central, B/s (4 bytes)
+  *   offset 14  estimated ATT payload rate central to peripheral, B/s (4 bytes)
+  *
+  * The rates assume back to back data PDUs answered by empty PDUs for the
+  * whole connection interval, so they are an upper bound for bulk transfers.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LINK_PERF_H
+#define __LINK_PERF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define LINK_PERF_VALUE_SIZE      18U
+
+/* Largest LL data PDU payload and its transmit time on the 1M PHY */
+#define LINK_PERF_MAX_OCTETS      251U
+#define LINK_PERF_MAX_TIME_US     2120U
+
+/* Exported functions prototypes ---------------------------------------------*/
+void LINK_PERF_Connected(uint16_t ConnectionHandle, uint16_t Interval);
+void LINK_PERF_Disconnected(void);
+void LINK_PERF_SetInterval(uint16_t Interval);
+void LINK_PERF_SetPhy(uint8_t TxPhy, uint8_t RxPhy);
+void LINK_PERF_SetDataLength(uint16_t MaxTxOctets, uint16_t MaxRxOctets);
+void LINK_PERF_SetMtu(uint16_t Mtu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LINK_PERF_H */
@@ -26,6 +26,18 @@ extern "C" {
 #endif
 
 /* Includes ------------------------------------------------------------------*/
+#include "stm32_lpm.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Time spent in each low power mode, indexed by UTIL_LPM_Mode_t
+  * @note  The time in Off mode is not known, as the device restarts from reset
+  */
+typedef struct
+{
+  uint32_t Entries[UTIL_LPM_OFFMODE + 1];
+  uint32_t TimeMs[UTIL_LPM_OFFMODE + 1];
+} PWR_LpmStatsTypeDef;
 
 /**
   * @brief Enters Low Power Off Mode
@@ -71,6 +83,13 @@ void PWR_EnterSleepMode( void );
   */
 void PWR_ExitSleepMode( void );
 
+/**
+  * @brief Returns the low power mode counters
+  * @param none
+  * @retval counters, updated on every low power mode exit
+  */
+const PWR_LpmStatsTypeDef *PWR_GetLpmStats( void );
+
 #ifdef __cplusplus
 }
 #endif
@@ -68,6 +68,8 @@ void IPCC_C1_TX_IRQHandler(void);
 void HSEM_IRQHandler(void);
 void DMA2_Channel4_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void DMA2_Channel5_IRQHandler(void);
+void EXTI9_5_IRQHandler(void);
 
 /* USER CODE END EFP */
 
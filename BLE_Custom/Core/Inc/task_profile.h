@@ -0,0 +1,39 @@
+/**
+  ******************************************************************************
+  * @file           : task_profile.h
+  * @brief          : Sequencer task profile dump.
+  ******************************************************************************
+  * With UTIL_SEQ_CONF_PROFILER set in utilities_conf.h the sequencer counts,
+  * for every task, its runs, its run time and the time from UTIL_SEQ_SetTask
+  * to the run. TASK_PROFILE_Init starts the DWT cycle counter the profile is
+  * taken with; UTIL_SEQ_Init would do it but the application does not call
+  * it. TASK_PROFILE_Dump prints one line per task that ran on the
+  * debug trace and restarts the counters:
+  *
+  *   name  runs  total ms  avg us  max us  avg wait us  max wait us
+  *
+  * The run time of a task leaves out the tasks run from it while it waits
+  * for CPU2 (UTIL_SEQ_WaitEvt).
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TASK_PROFILE_H
+#define __TASK_PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported functions prototypes ---------------------------------------------*/
+void TASK_PROFILE_Init(void);
+void TASK_PROFILE_Dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TASK_PROFILE_H */
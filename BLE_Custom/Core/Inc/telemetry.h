@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * @file           : telemetry.h
+  * @brief          : Telemetry records notified on LONG_C in MTU sized frames.
+  ******************************************************************************
+  * Records are queued from any context and packed back to back into frames
+  * (all fields little endian):
+  *
+  *   offset 0   frame sequence number, incremented for every frame sent
+  *   offset 1   records, each { type (1 byte), length L (1 byte), L bytes }
+  *
+  * A frame never exceeds ATT_MTU - 3 nor TELEMETRY_FRAME_MAX, so it fits a
+  * single notification. Frames are sent until the controller runs out of
+  * TX buffers; sending resumes on ACI_GATT_TX_POOL_AVAILABLE or on a
+  * notification complete event instead of dropping the frame.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TELEMETRY_H
+#define __TELEMETRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Largest frame: one LE data PDU with data length extension (251 bytes less
+   the L2CAP and ATT headers), below the aci_gatt_update_char_value limit */
+#define TELEMETRY_FRAME_MAX       244U
+/* ATT_MTU in force until the client exchanges a larger one */
+#define TELEMETRY_DEFAULT_ATT_MTU 23U
+#define TELEMETRY_FRAME_HEADER    1U
+#define TELEMETRY_RECORD_HEADER   2U
+#define TELEMETRY_RECORD_MAX      (TELEMETRY_FRAME_MAX - TELEMETRY_FRAME_HEADER - TELEMETRY_RECORD_HEADER)
+/* Record queue in bytes, power of two */
+#define TELEMETRY_QUEUE_SIZE      2048U
+
+/* Record types */
+#define TELEMETRY_REC_LAMPS       0x01U   /*!< tick (4 bytes), lamp state (1 byte) */
+#define TELEMETRY_REC_BUTTON      0x02U   /*!< tick (4 bytes), switch status (1 byte) */
+#define TELEMETRY_REC_REJECT      0x03U   /*!< tick (4 bytes), opcode of the refused B_LED_C write (1 byte) */
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Records;     /*!< Records queued */
+  uint32_t Dropped;     /*!< Records lost because the queue was full */
+  uint32_t Oversized;   /*!< Records discarded as too long for the MTU */
+  uint32_t Frames;      /*!< Frames handed to the controller */
+  uint32_t Bytes;       /*!< Frame bytes handed to the controller */
+  uint32_t PoolFull;    /*!< Sends deferred until TX buffers were released */
+  uint32_t Failed;      /*!< Frames discarded on any other error */
+} TELEMETRY_StatsTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void TELEMETRY_Init(void);
+void TELEMETRY_Enable(uint8_t enable);
+void TELEMETRY_SetMtu(uint16_t mtu);
+uint8_t TELEMETRY_Put(uint8_t type, const uint8_t *data, uint8_t len);
+void TELEMETRY_PutTicked(uint8_t type, uint8_t value);
+void TELEMETRY_TxReady(void);
+const TELEMETRY_StatsTypeDef *TELEMETRY_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TELEMETRY_H */
@@ -57,6 +57,14 @@ extern "C" {
 #define UTIL_SEQ_CONF_TASK_NBR                  (32)
 #define UTIL_SEQ_CONF_PRIO_NBR                  CFG_SCH_PRIO_NBR
 #define UTIL_SEQ_MEMSET8( dest, value, size )   UTILS_MEMSET8( dest, value, size )
+/* Per task run count, run time and dispatch latency, see UTIL_SEQ_GetTaskProfile() */
+#define UTIL_SEQ_CONF_PROFILER                  (1)
+#define UTIL_SEQ_PROFILER_INIT( )               do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;\
+                                                     DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while(0)
+#define UTIL_SEQ_PROFILER_GET_CYCLES( )         (DWT->CYCCNT)
+/* Earliest deadline first within a priority, deadlines in ms, see UTIL_SEQ_SetTaskDeadline() */
+#define UTIL_SEQ_CONF_EDF                       (1)
+#define UTIL_SEQ_EDF_GET_TIME( )                HAL_GetTick( )
 
 #ifdef __cplusplus
 }
@@ -27,6 +27,7 @@
 #include "shci.h"
 #include "tl.h"
 #include "dbg_trace.h"
+#include "stm32_lpm.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -161,6 +162,11 @@ static const APPD_GpioConfig_t aRfConfigList[GPIO_NBR_OF_RF_SIGNALS] =
     { GPIOB, LL_GPIO_PIN_10, 0, 0},     /* DTB18 - FSM4 */
 };
 #endif
+
+#if(CFG_DEBUG_TRACE != 0)
+/* Completion callback of the trace transfer in progress */
+static void (*DbgOutputTxCb)(void);
+#endif
 /* USER CODE END PV */
 
 /* Global variables ----------------------------------------------------------*/
@@ -171,6 +177,9 @@ static const APPD_GpioConfig_t aRfConfigList[GPIO_NBR_OF_RF_SIGNALS] =
 /* USER CODE BEGIN PFP */
 static void APPD_SetCPU2GpioConfig( void );
 static void APPD_BleDtbCfg( void );
+#if(CFG_DEBUG_TRACE != 0)
+static void DbgOutputTxCplt( void );
+#endif
 /* USER CODE END PFP */
 
 /* Functions Definition ------------------------------------------------------*/
@@ -407,10 +416,26 @@ void DbgOutputInit( void )
   return;
 }
 
+/**
+ * The UART stops with the clocks in Stop mode: Stop is held off from the start
+ * of a trace transfer to its completion. The trace callback may start the next
+ * transfer, so Stop is allowed again before calling it.
+ */
+static void DbgOutputTxCplt( void )
+{
+  UTIL_LPM_SetStopMode(1U << CFG_LPM_APP_TRACE, UTIL_LPM_ENABLE);
+  DbgOutputTxCb();
+}
+
 void DbgOutputTraces(  uint8_t *p_data, uint16_t size, void (*cb)(void) )
 {
 /* USER CODE BEGIN DbgOutputTraces */
-  HW_UART_Transmit_DMA(CFG_DEBUG_TRACE_UART, p_data, size, cb);
+  DbgOutputTxCb = cb;
+  UTIL_LPM_SetStopMode(1U << CFG_LPM_APP_TRACE, UTIL_LPM_DISABLE);
+  if (HW_UART_Transmit_DMA(CFG_DEBUG_TRACE_UART, p_data, size, DbgOutputTxCplt) != hw_uart_ok)
+  {
+    UTIL_LPM_SetStopMode(1U << CFG_LPM_APP_TRACE, UTIL_LPM_ENABLE);
+  }
 
 /* USER CODE END DbgOutputTraces */
   return;
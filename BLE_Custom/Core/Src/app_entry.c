@@ -35,14 +35,14 @@
 
 /* Private includes -----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "console.h"
+#include "task_profile.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
 extern RTC_HandleTypeDef hrtc;
 
 /* USER CODE BEGIN PTD */
-EXTI_HandleTypeDef exti_handle;
 
 /* USER CODE END PTD */
 
@@ -50,9 +50,6 @@ EXTI_HandleTypeDef exti_handle;
 #define POOL_SIZE (CFG_TLBLE_EVT_QUEUE_LENGTH*4U*DIVC((sizeof(TL_PacketHeader_t) + TL_BLE_EVENT_FRAME_SIZE), 4U))
 
 /* USER CODE BEGIN PD */
-/* Section specific to button management using UART */
-#define C_SIZE_CMD_STRING       256U
-#define RX_BUFFER_SIZE          8U
 
 /* USER CODE END PD */
 
@@ -68,10 +65,6 @@ PLACE_IN_SECTION("MB_MEM2") ALIGN(4) static uint8_t SystemSpareEvtBuffer[sizeof(
 PLACE_IN_SECTION("MB_MEM2") ALIGN(4) static uint8_t BleSpareEvtBuffer[sizeof(TL_PacketHeader_t) + TL_EVT_HDR_SIZE + 255];
 
 /* USER CODE BEGIN PV */
-/* Section specific to button management using UART */
-static uint8_t aRxBuffer[RX_BUFFER_SIZE];
-static uint8_t CommandString[C_SIZE_CMD_STRING];
-static uint16_t indexReceiveChar = 0;
 
 /* USER CODE END PV */
 
@@ -95,11 +88,6 @@ static void Init_Rtc(void);
 static void Led_Init( void );
 static void Button_Init( void );
 
-/* Section specific to button management using UART */
-static void RxUART_Init(void);
-static void RxCpltCallback(void);
-static void UartCmdExecute(void);
-
 /* USER CODE END PFP */
 
 /* Functions Definition ------------------------------------------------------*/
@@ -144,7 +132,9 @@ void MX_APPE_Init(void)
 
   Button_Init();
   
-  RxUART_Init();
+  CONSOLE_Init();
+
+  TASK_PROFILE_Init();
 
 /* USER CODE END APPE_Init_1 */
   appe_Tl_Init();	/* Initialize all transport layers */
@@ -612,6 +602,18 @@ void MX_APPE_Process(void)
 void UTIL_SEQ_Idle(void)
 {
 #if (CFG_LPM_SUPPORTED == 1)
+  /**
+   * The RTC wakeup timer of the timer server is the next deadline of the application:
+   * Stop mode is allowed only when it is far enough
+   */
+  if (HW_TS_RTC_ReadLeftTicksToCount() < CFG_LPM_STOP_MIN_TICKS)
+  {
+    UTIL_LPM_SetStopMode(1U << CFG_LPM_APP_IDLE, UTIL_LPM_DISABLE);
+  }
+  else
+  {
+    UTIL_LPM_SetStopMode(1U << CFG_LPM_APP_IDLE, UTIL_LPM_ENABLE);
+  }
   UTIL_LPM_EnterLowPower();
 #endif /* CFG_LPM_SUPPORTED == 1 */
   return;
@@ -652,6 +654,10 @@ void HAL_GPIO_EXTI_Callback( uint16_t GPIO_Pin )
       APP_BLE_Key_Button3_Action();
       break; 
 
+    case CONSOLE_WAKE_PIN:
+      CONSOLE_Wakeup();
+      break;
+
     default:
       break;
 
@@ -659,61 +665,4 @@ void HAL_GPIO_EXTI_Callback( uint16_t GPIO_Pin )
   return;
 }
 
-static void RxUART_Init(void)
-{
-  HW_UART_Receive_IT((hw_uart_id_t)CFG_DEBUG_TRACE_UART, aRxBuffer, 1U, RxCpltCallback);
-}
-
-static void RxCpltCallback(void)
-{
-  /* Filling buffer and wait for '\r' char */
-  if (indexReceiveChar < C_SIZE_CMD_STRING)
-  {
-    if (aRxBuffer[0] == '\r')
-    {
-      APP_DBG_MSG("received %s\n", CommandString);
-
-      UartCmdExecute();
-
-      /* Clear receive buffer and character counter*/
-      indexReceiveChar = 0;
-      memset(CommandString, 0, C_SIZE_CMD_STRING);
-    }
-    else
-    {
-      CommandString[indexReceiveChar++] = aRxBuffer[0];
-    }
-  }
-
-  /* Once a character has been sent, put back the device in reception mode */
-  HW_UART_Receive_IT((hw_uart_id_t)CFG_DEBUG_TRACE_UART, aRxBuffer, 1U, RxCpltCallback);
-}
-
-static void UartCmdExecute(void)
-{
-  /* Parse received CommandString */
-  if(strcmp((char const*)CommandString, "SW1") == 0)
-  {
-    APP_DBG_MSG("SW1 OK\n");
-    exti_handle.Line = EXTI_LINE_4;
-    HAL_EXTI_GenerateSWI(&exti_handle);
-  }
-  else if (strcmp((char const*)CommandString, "SW2") == 0)
-  {
-    APP_DBG_MSG("SW2 OK\n");
-    exti_handle.Line = EXTI_LINE_0;
-    HAL_EXTI_GenerateSWI(&exti_handle);
-  }
-  else if (strcmp((char const*)CommandString, "SW3") == 0)
-  {
-    APP_DBG_MSG("SW3 OK\n");
-    exti_handle.Line = EXTI_LINE_1;
-    HAL_EXTI_GenerateSWI(&exti_handle);
-  }
-  else
-  {
-    APP_DBG_MSG("NOT RECOGNIZED COMMAND : %s\n", CommandString);
-  }
-}
-
 /* USER CODE END FD_WRAP_FUNCTIONS */
@@ -0,0 +1,238 @@
+/**
+  ******************************************************************************
+  * @file           : conn_policy.c
+  * @brief          : Connection parameters following the client activity.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "conn_policy.h"
+#include "app_common.h"
+#include "dbg_trace.h"
+#include "ble.h"
+#include "hw_if.h"
+#include "stm32_seq.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef enum
+{
+  CONN_POLICY_MODE_NONE,      /*!< Parameters chosen by the central */
+  CONN_POLICY_MODE_ACTIVE,
+  CONN_POLICY_MODE_IDLE,
+} CONN_POLICY_ModeTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static uint16_t policy_handle;
+static uint8_t policy_connected;
+
+/* Mode asked for by the activity, mode of the parameters in force and mode
+   of the outstanding request */
+static CONN_POLICY_ModeTypeDef policy_wanted;
+static CONN_POLICY_ModeTypeDef policy_current;
+static CONN_POLICY_ModeTypeDef policy_requested;
+static uint8_t policy_pending;
+
+static uint32_t policy_last_activity;
+static uint8_t policy_timer_id;
+
+static CONN_POLICY_StatsTypeDef policy_stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static void CONN_POLICY_TimerCb(void);
+static void CONN_POLICY_Task(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Send the L2CAP update request for the wanted mode, unless the
+  *         link already uses it or a request is outstanding.
+  */
+static void CONN_POLICY_Request(void)
+{
+  uint16_t interval_min, interval_max, latency;
+  tBleStatus ret;
+
+  if (!policy_connected || policy_pending ||
+      (policy_wanted == CONN_POLICY_MODE_NONE) || (policy_wanted == policy_current))
+  {
+    return;
+  }
+
+  if (policy_wanted == CONN_POLICY_MODE_ACTIVE)
+  {
+    interval_min = CONN_POLICY_ACTIVE_INTERVAL;
+    interval_max = CONN_POLICY_ACTIVE_INTERVAL;
+    latency = CONN_POLICY_ACTIVE_LATENCY;
+  }
+  else
+  {
+    interval_min = CONN_POLICY_IDLE_INTERVAL_MIN;
+    interval_max = CONN_POLICY_IDLE_INTERVAL_MAX;
+    latency = CONN_POLICY_IDLE_LATENCY;
+  }
+
+  ret = aci_l2cap_connection_parameter_update_req(policy_handle,
+                                                  interval_min, interval_max,
+                                                  latency, CONN_POLICY_SUPERVISION_TIMEOUT);
+  if (ret != BLE_STATUS_SUCCESS)
+  {
+    APP_DBG_MSG("  Fail   : aci_l2cap_connection_parameter_update_req, result: 0x%x \n\r", ret);
+    return;
+  }
+  policy_requested = policy_wanted;
+  policy_pending = 1U;
+  policy_stats.Requests++;
+}
+
+/**
+  * @brief  Timer server callback, runs in the RTC wakeup interrupt: check
+  *         for the idle timeout from the sequencer.
+  */
+static void CONN_POLICY_TimerCb(void)
+{
+  UTIL_SEQ_SetTask(1U << CFG_TASK_CONN_POLICY_ID, CFG_SCH_PRIO_0);
+}
+
+/**
+  * @brief  Policy task: fall back to the idle mode once the client has been
+  *         quiet long enough, and send the request for the wanted mode.
+  */
+static void CONN_POLICY_Task(void)
+{
+  uint32_t elapsed;
+
+  if (!policy_connected)
+  {
+    return;
+  }
+
+  if (policy_wanted != CONN_POLICY_MODE_IDLE)
+  {
+    elapsed = HAL_GetTick() - policy_last_activity;
+    if (elapsed >= CONN_POLICY_IDLE_TIMEOUT_MS)
+    {
+      policy_wanted = CONN_POLICY_MODE_IDLE;
+    }
+    else
+    {
+      /* Activity since the timer was started: wait for the rest */
+      HW_TS_Start(policy_timer_id, HW_TS_MS_TO_TICKS(CONN_POLICY_IDLE_TIMEOUT_MS - elapsed) + 1U);
+    }
+  }
+
+  CONN_POLICY_Request();
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Register the policy task and reserve the idle timer. Call after
+  *         the timer server is initialised.
+  */
+void CONN_POLICY_Init(void)
+{
+  UTIL_SEQ_RegTask(1U << CFG_TASK_CONN_POLICY_ID, UTIL_SEQ_RFU, CONN_POLICY_Task);
+  (void)HW_TS_Create(CFG_TIM_PROC_ID_ISR, &policy_timer_id, hw_ts_SingleShot, CONN_POLICY_TimerCb);
+}
+
+/**
+  * @brief  A central connected. Its parameters are kept until the client
+  *         becomes active or stays idle for the idle timeout.
+  * @param  ConnectionHandle: connection handle
+  */
+void CONN_POLICY_Connected(uint16_t ConnectionHandle)
+{
+  policy_handle = ConnectionHandle;
+  policy_connected = 1U;
+  policy_wanted = CONN_POLICY_MODE_NONE;
+  policy_current = CONN_POLICY_MODE_NONE;
+  policy_pending = 0U;
+  policy_last_activity = HAL_GetTick();
+  HW_TS_Start(policy_timer_id, HW_TS_MS_TO_TICKS(CONN_POLICY_IDLE_TIMEOUT_MS));
+}
+
+/**
+  * @brief  The link is gone.
+  */
+void CONN_POLICY_Disconnected(void)
+{
+  policy_connected = 0U;
+  policy_pending = 0U;
+  HW_TS_Stop(policy_timer_id);
+}
+
+/**
+  * @brief  The client wrote a command: switch to the active mode and restart
+  *         the idle timeout. Cheap enough to call on every write.
+  */
+void CONN_POLICY_Activity(void)
+{
+  policy_last_activity = HAL_GetTick();
+  if (!policy_connected || (policy_wanted == CONN_POLICY_MODE_ACTIVE))
+  {
+    return;
+  }
+  policy_wanted = CONN_POLICY_MODE_ACTIVE;
+  /* Later writes only move policy_last_activity; the timer callback
+     re-arms itself for the rest of the timeout */
+  HW_TS_Start(policy_timer_id, HW_TS_MS_TO_TICKS(CONN_POLICY_IDLE_TIMEOUT_MS));
+  UTIL_SEQ_SetTask(1U << CFG_TASK_CONN_POLICY_ID, CFG_SCH_PRIO_0);
+}
+
+/**
+  * @brief  HCI_LE_CONNECTION_UPDATE_COMPLETE received.
+  * @param  Interval: new connection interval, in 1.25 ms units
+  * @param  Latency: new peripheral latency
+  */
+void CONN_POLICY_Updated(uint16_t Interval, uint16_t Latency)
+{
+  if (policy_pending)
+  {
+    policy_pending = 0U;
+    policy_current = policy_requested;
+    if (policy_current == CONN_POLICY_MODE_ACTIVE)
+    {
+      policy_stats.ToActive++;
+    }
+    else
+    {
+      policy_stats.ToIdle++;
+    }
+  }
+  else
+  {
+    /* Changed by the central on its own */
+    policy_current = CONN_POLICY_MODE_NONE;
+  }
+  APP_DBG_MSG("  Connection policy: interval %d x 1.25 ms, latency %d\n\r", Interval, Latency);
+
+  UTIL_SEQ_SetTask(1U << CFG_TASK_CONN_POLICY_ID, CFG_SCH_PRIO_0);
+}
+
+/**
+  * @brief  ACI_L2CAP_CONNECTION_UPDATE_RESP or ACI_L2CAP_PROC_TIMEOUT
+  *         received. An accepted request completes with
+  *         CONN_POLICY_Updated.
+  * @param  Accepted: 1 if the central accepted the request
+  */
+void CONN_POLICY_Response(uint8_t Accepted)
+{
+  if (Accepted || !policy_pending)
+  {
+    return;
+  }
+  /* Keep what the central gave and do not insist until the mode changes */
+  policy_pending = 0U;
+  policy_current = policy_requested;
+  policy_stats.Rejected++;
+
+  UTIL_SEQ_SetTask(1U << CFG_TASK_CONN_POLICY_ID, CFG_SCH_PRIO_0);
+}
+
+/**
+  * @brief  Policy counters.
+  */
+const CONN_POLICY_StatsTypeDef *CONN_POLICY_GetStats(void)
+{
+  return &policy_stats;
+}
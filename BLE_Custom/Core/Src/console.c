@@ -0,0 +1,488 @@
+/**
+  ******************************************************************************
+  * @file           : console.c
+  * @brief          : Command console on the debug trace UART.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "console.h"
+#include "app_common.h"
+#include "dbg_trace.h"
+#include "hw_if.h"
+#include "stm32_seq.h"
+#include "stm32_lpm_if.h"
+#include "hci_tl.h"
+#include "tl.h"
+#include "lamps.h"
+#include "lamp_seq.h"
+#include "lamp_stream.h"
+#include "telemetry.h"
+#include "conn_policy.h"
+#include "task_profile.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  const char *Name;
+  const char *Usage;    /*!< Arguments, for help */
+  const char *Help;
+  uint32_t Args;        /*!< Number of arguments taken */
+  void (*Handler)(char *argv[]);
+} CONSOLE_CmdTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define CONSOLE_RX_MASK           (CONSOLE_RX_SIZE - 1U)
+#define CONSOLE_WAKE_EXTI_LINE    LL_EXTI_LINE_7
+
+/* Private function prototypes -----------------------------------------------*/
+static void CONSOLE_Help(char *argv[]);
+static void CONSOLE_Sw1(char *argv[]);
+static void CONSOLE_Sw2(char *argv[]);
+static void CONSOLE_Sw3(char *argv[]);
+static void CONSOLE_Lamp(char *argv[]);
+static void CONSOLE_Stats(char *argv[]);
+static void CONSOLE_Lpm(char *argv[]);
+static void CONSOLE_Prof(char *argv[]);
+
+/* Private variables ---------------------------------------------------------*/
+static const CONSOLE_CmdTypeDef console_cmds[] =
+{
+  { "help",  "",        "list the commands",                    0U, CONSOLE_Help  },
+  { "SW1",   "",        "push SW1",                             0U, CONSOLE_Sw1   },
+  { "SW2",   "",        "push SW2",                             0U, CONSOLE_Sw2   },
+  { "SW3",   "",        "push SW3",                             0U, CONSOLE_Sw3   },
+  { "lamp",  "<0..7>",  "set the lamps, stops sequence/stream", 1U, CONSOLE_Lamp  },
+  { "stats", "",        "BLE, telemetry and lamp counters",     0U, CONSOLE_Stats },
+  { "lpm",   "",        "low power mode entries and time",      0U, CONSOLE_Lpm   },
+  { "prof",  "",        "sequencer task profile, then clear",   0U, CONSOLE_Prof  },
+};
+
+static uint8_t console_rx_buf[CONSOLE_RX_SIZE];
+/* DMA write position given by the last reception event, read position of
+   the task */
+static volatile uint16_t console_rx_pos;
+static volatile uint8_t console_rx_stopped;
+static uint32_t console_rx_rd;
+
+static char console_line[CONSOLE_LINE_SIZE];
+static uint32_t console_line_len;
+static uint8_t console_line_discard;
+
+/* Stop mode is held off while set; tick of the last received byte */
+static volatile uint8_t console_active;
+static volatile uint32_t console_last_activity;
+static volatile uint8_t console_timer_expired;
+static uint8_t console_timer_id;
+
+static CONSOLE_StatsTypeDef console_stats;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Console in use: hold Stop mode off and mask the RX pin wake up
+  *         line, which would otherwise fire on every bit. Reception and wake
+  *         up interrupts, or initialisation.
+  */
+static void CONSOLE_Activity(void)
+{
+  console_last_activity = HAL_GetTick();
+  if (console_active)
+  {
+    /* The timer task waits for the rest of the period */
+    return;
+  }
+  console_active = 1U;
+  LL_EXTI_DisableIT_0_31(CONSOLE_WAKE_EXTI_LINE);
+  UTIL_LPM_SetStopMode(1U << CFG_LPM_APP_CONSOLE, UTIL_LPM_DISABLE);
+  HW_TS_Start(console_timer_id, HW_TS_MS_TO_TICKS(CONSOLE_ACTIVE_MS));
+}
+
+/**
+  * @brief  Activity period over: let the task decide.
+  */
+static void CONSOLE_TimerCb(void)
+{
+  console_timer_expired = 1U;
+  UTIL_SEQ_SetTask(1U << CFG_TASK_CONSOLE_ID, CFG_SCH_PRIO_1);
+}
+
+/**
+  * @brief  Allow Stop mode again once nothing was received for
+  *         CONSOLE_ACTIVE_MS, with the RX pin armed to wake the core.
+  */
+static void CONSOLE_CheckIdle(void)
+{
+  uint32_t elapsed;
+  uint32_t primask_bit;
+
+  console_timer_expired = 0U;
+  elapsed = HAL_GetTick() - console_last_activity;
+  if (elapsed < CONSOLE_ACTIVE_MS)
+  {
+    HW_TS_Start(console_timer_id, HW_TS_MS_TO_TICKS(CONSOLE_ACTIVE_MS - elapsed) + 1U);
+    return;
+  }
+
+  primask_bit = __get_PRIMASK();
+  __disable_irq();
+  console_active = 0U;
+  LL_EXTI_ClearFlag_0_31(CONSOLE_WAKE_EXTI_LINE);
+  LL_EXTI_EnableIT_0_31(CONSOLE_WAKE_EXTI_LINE);
+  UTIL_LPM_SetStopMode(1U << CFG_LPM_APP_CONSOLE, UTIL_LPM_ENABLE);
+  __set_PRIMASK(primask_bit);
+}
+
+/**
+  * @brief  Reception event, runs in the UART or DMA interrupt.
+  * @param  Position: DMA write position in console_rx_buf, or
+  *         HW_UART_RX_STOPPED
+  */
+static void CONSOLE_RxEvent(uint16_t Position)
+{
+  if (Position == HW_UART_RX_STOPPED)
+  {
+    console_rx_stopped = 1U;
+  }
+  else
+  {
+    console_rx_pos = Position;
+    CONSOLE_Activity();
+  }
+  UTIL_SEQ_SetTask(1U << CFG_TASK_CONSOLE_ID, CFG_SCH_PRIO_1);
+}
+
+/**
+  * @brief  Start the circular reception from the start of the buffer. A
+  *         partial line is dropped.
+  */
+static void CONSOLE_StartRx(void)
+{
+  console_rx_pos = 0U;
+  console_rx_rd = 0U;
+  console_line_len = 0U;
+  console_line_discard = 0U;
+  if (HW_UART_ReceiveToIdle_DMA((hw_uart_id_t)CFG_DEBUG_TRACE_UART, console_rx_buf, CONSOLE_RX_SIZE,
+                                CONSOLE_RxEvent) != hw_uart_ok)
+  {
+    APP_DBG_MSG("  Fail   : console reception not started\n\r");
+  }
+}
+
+/**
+  * @brief  Compare a command name ignoring case.
+  * @retval 1 if equal
+  */
+static uint8_t CONSOLE_NameIs(const char *a, const char *b)
+{
+  char ca, cb;
+
+  do
+  {
+    ca = *a++;
+    cb = *b++;
+    if ((ca >= 'a') && (ca <= 'z'))
+    {
+      ca -= 'a' - 'A';
+    }
+    if ((cb >= 'a') && (cb <= 'z'))
+    {
+      cb -= 'a' - 'A';
+    }
+    if (ca != cb)
+    {
+      return 0U;
+    }
+  } while (ca != '\0');
+
+  return 1U;
+}
+
+/**
+  * @brief  Parse a decimal or 0x prefixed hexadecimal number.
+  * @retval 1 if the whole argument is a number
+  */
+static uint8_t CONSOLE_ParseU32(const char *arg, uint32_t *p_value)
+{
+  char *end;
+
+  *p_value = strtoul(arg, &end, 0);
+  return (uint8_t)((end != arg) && (*end == '\0'));
+}
+
+/**
+  * @brief  Split a line into words and run the matching command.
+  * @param  line: NUL terminated line, modified
+  */
+static void CONSOLE_Execute(char *line)
+{
+  char *argv[CONSOLE_MAX_ARGS + 1U];
+  const CONSOLE_CmdTypeDef *p_cmd;
+  uint32_t argc = 0U;
+  uint32_t i;
+  char *p = line;
+
+  while (*p != '\0')
+  {
+    if ((*p == ' ') || (*p == '\t'))
+    {
+      *p++ = '\0';
+      continue;
+    }
+    if (argc == (CONSOLE_MAX_ARGS + 1U))
+    {
+      APP_DBG_MSG("  Console: more than %d arguments\n\r", CONSOLE_MAX_ARGS);
+      return;
+    }
+    argv[argc++] = p;
+    while ((*p != '\0') && (*p != ' ') && (*p != '\t'))
+    {
+      p++;
+    }
+  }
+  if (argc == 0U)
+  {
+    return;
+  }
+
+  for (i = 0U; i < (sizeof(console_cmds) / sizeof(console_cmds[0])); i++)
+  {
+    p_cmd = &console_cmds[i];
+    if (CONSOLE_NameIs(argv[0], p_cmd->Name))
+    {
+      if ((argc - 1U) != p_cmd->Args)
+      {
+        APP_DBG_MSG("  Usage: %s %s\n\r", p_cmd->Name, p_cmd->Usage);
+        return;
+      }
+      p_cmd->Handler(&argv[1]);
+      return;
+    }
+  }
+  console_stats.Unknown++;
+  APP_DBG_MSG("  Console: unknown command, try help\n\r");
+}
+
+/**
+  * @brief  Add one received byte to the line, and run the line on CR or LF.
+  */
+static void CONSOLE_PutChar(uint8_t c)
+{
+  if ((c == '\r') || (c == '\n'))
+  {
+    if (console_line_discard)
+    {
+      console_line_discard = 0U;
+      console_stats.TooLong++;
+    }
+    else if (console_line_len != 0U)
+    {
+      console_line[console_line_len] = '\0';
+      console_stats.Lines++;
+      CONSOLE_Execute(console_line);
+    }
+    console_line_len = 0U;
+  }
+  else if (console_line_len < (CONSOLE_LINE_SIZE - 1U))
+  {
+    console_line[console_line_len++] = (char)c;
+  }
+  else
+  {
+    console_line_discard = 1U;
+  }
+}
+
+/**
+  * @brief  Console task: take the bytes the DMA wrote since the last run.
+  */
+static void CONSOLE_Task(void)
+{
+  uint32_t pos;
+
+  if (console_timer_expired)
+  {
+    CONSOLE_CheckIdle();
+  }
+
+  if (console_rx_stopped)
+  {
+    console_rx_stopped = 0U;
+    console_stats.Restarts++;
+    CONSOLE_StartRx();
+    return;
+  }
+
+  /* The transfer complete event reports the end of the buffer */
+  pos = console_rx_pos & CONSOLE_RX_MASK;
+  while (console_rx_rd != pos)
+  {
+    CONSOLE_PutChar(console_rx_buf[console_rx_rd]);
+    console_rx_rd = (console_rx_rd + 1U) & CONSOLE_RX_MASK;
+  }
+}
+
+/**
+  * @brief  Raise the EXTI line of a switch, as if it was pushed.
+  */
+static void CONSOLE_Switch(uint32_t Line)
+{
+  EXTI_HandleTypeDef exti_handle = {0};
+
+  exti_handle.Line = Line;
+  HAL_EXTI_GenerateSWI(&exti_handle);
+}
+
+static void CONSOLE_Help(char *argv[])
+{
+  uint32_t i;
+
+  UNUSED(argv);
+  for (i = 0U; i < (sizeof(console_cmds) / sizeof(console_cmds[0])); i++)
+  {
+    APP_DBG_MSG("  %-6s %-8s %s\n\r", console_cmds[i].Name, console_cmds[i].Usage, console_cmds[i].Help);
+  }
+}
+
+static void CONSOLE_Sw1(char *argv[])
+{
+  UNUSED(argv);
+  CONSOLE_Switch(EXTI_LINE_4);
+}
+
+static void CONSOLE_Sw2(char *argv[])
+{
+  UNUSED(argv);
+  CONSOLE_Switch(EXTI_LINE_0);
+}
+
+static void CONSOLE_Sw3(char *argv[])
+{
+  UNUSED(argv);
+  CONSOLE_Switch(EXTI_LINE_1);
+}
+
+static void CONSOLE_Lamp(char *argv[])
+{
+  uint32_t state;
+
+  if (!CONSOLE_ParseU32(argv[0], &state) || (state > LAMPS_STATE_MASK))
+  {
+    APP_DBG_MSG("  Lamp state is 0..7: bit 0 green, 1 yellow, 2 red\n\r");
+    return;
+  }
+  LAMP_SEQ_Stop();
+  LAMP_STREAM_Reset();
+  Lamps_Write((uint8_t)state);
+}
+
+static void CONSOLE_Stats(char *argv[])
+{
+  const HCI_TL_EvtStats_t *p_hci = hci_get_evt_stats();
+  const TL_EvtLatencyStats_t *p_lat = TL_MM_GetEvtLatency();
+  const TELEMETRY_StatsTypeDef *p_tlm = TELEMETRY_GetStats();
+  const CONN_POLICY_StatsTypeDef *p_policy = CONN_POLICY_GetStats();
+  const LAMP_SEQ_StatsTypeDef *p_seq = LAMP_SEQ_GetStats();
+  const LAMP_STREAM_StatsTypeDef *p_stream = LAMP_STREAM_GetStats();
+  uint32_t i;
+
+  UNUSED(argv);
+  APP_DBG_MSG("  HCI events: %ld in %ld runs, %ld cut by budget, queue %d (max %d), batch max %d\n\r",
+              p_hci->EvtCount, p_hci->PassCount, p_hci->BudgetCount,
+              p_hci->QueueDepth, p_hci->QueueDepthMax, p_hci->BatchMax);
+  if (p_lat != NULL)
+  {
+    APP_DBG_MSG("  Event latency: %ld events, max %ld us, %ld untracked\n\r",
+                p_lat->Count, p_lat->MaxUs, p_lat->Untracked);
+    for (i = 0U; i < TL_EVT_LATENCY_BINS; i++)
+    {
+      if (p_lat->Hist[i] == 0U)
+      {
+        continue;
+      }
+      if (i == (TL_EVT_LATENCY_BINS - 1U))
+      {
+        APP_DBG_MSG("    >= %ld us: %ld\n\r", 1UL << (i - 1U), p_lat->Hist[i]);
+      }
+      else
+      {
+        APP_DBG_MSG("    < %ld us: %ld\n\r", 1UL << i, p_lat->Hist[i]);
+      }
+    }
+  }
+  APP_DBG_MSG("  Telemetry: %ld records, %ld dropped, %ld oversized, %ld frames, %ld bytes, %ld pool full, %ld failed\n\r",
+              p_tlm->Records, p_tlm->Dropped, p_tlm->Oversized, p_tlm->Frames,
+              p_tlm->Bytes, p_tlm->PoolFull, p_tlm->Failed);
+  APP_DBG_MSG("  Connection policy: %ld requests, %ld rejected, %ld to active, %ld to idle\n\r",
+              p_policy->Requests, p_policy->Rejected, p_policy->ToActive, p_policy->ToIdle);
+  APP_DBG_MSG("  Lamp sequence: %ld uploads, %ld rejected, %ld steps, %ld loops\n\r",
+              p_seq->Uploads, p_seq->Rejected, p_seq->Steps, p_seq->Loops);
+  APP_DBG_MSG("  Lamp stream: %ld frames, %ld gaps, %ld reordered, %ld malformed, %ld dropped\n\r",
+              p_stream->Frames, p_stream->SeqGaps, p_stream->Reordered, p_stream->Malformed,
+              p_stream->Dropped);
+  APP_DBG_MSG("  Console: %ld lines, %ld unknown, %ld too long, %ld restarts\n\r",
+              console_stats.Lines, console_stats.Unknown, console_stats.TooLong, console_stats.Restarts);
+}
+
+static void CONSOLE_Lpm(char *argv[])
+{
+  const PWR_LpmStatsTypeDef *p_lpm = PWR_GetLpmStats();
+
+  UNUSED(argv);
+  APP_DBG_MSG("  Sleep: %ld entries, %ld ms\n\r", p_lpm->Entries[UTIL_LPM_SLEEPMODE], p_lpm->TimeMs[UTIL_LPM_SLEEPMODE]);
+  APP_DBG_MSG("  Stop : %ld entries, %ld ms\n\r", p_lpm->Entries[UTIL_LPM_STOPMODE], p_lpm->TimeMs[UTIL_LPM_STOPMODE]);
+  APP_DBG_MSG("  Off  : %ld entries, %ld ms\n\r", p_lpm->Entries[UTIL_LPM_OFFMODE], p_lpm->TimeMs[UTIL_LPM_OFFMODE]);
+  APP_DBG_MSG("  Console RX wake ups: %ld\n\r", console_stats.Wakeups);
+}
+
+static void CONSOLE_Prof(char *argv[])
+{
+  UNUSED(argv);
+  TASK_PROFILE_Dump();
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Register the console task and start the reception. Call after
+  *         the timer server is initialised.
+  */
+void CONSOLE_Init(void)
+{
+  EXTI_HandleTypeDef exti_handle = {0};
+  EXTI_ConfigTypeDef exti_config = {0};
+
+  UTIL_SEQ_RegTask(1U << CFG_TASK_CONSOLE_ID, UTIL_SEQ_RFU, CONSOLE_Task);
+  (void)HW_TS_Create(CFG_TIM_PROC_ID_ISR, &console_timer_id, hw_ts_SingleShot, CONSOLE_TimerCb);
+
+  /* The pin stays in its UART alternate function, EXTI sees its input too.
+     CONSOLE_Activity() masks the line until the first activity period ends */
+  exti_config.Line = EXTI_LINE_7;
+  exti_config.Mode = EXTI_MODE_INTERRUPT;
+  exti_config.Trigger = EXTI_TRIGGER_FALLING;
+  exti_config.GPIOSel = EXTI_GPIOB;
+  (void)HAL_EXTI_SetConfigLine(&exti_handle, &exti_config);
+  HAL_NVIC_SetPriority(EXTI9_5_IRQn, 15, 0);
+  HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
+
+  CONSOLE_StartRx();
+  CONSOLE_Activity();
+}
+
+/**
+  * @brief  Falling edge on the RX pin while Stop mode was allowed. The core
+  *         is awake now; keep it so while the console is used.
+  */
+void CONSOLE_Wakeup(void)
+{
+  console_stats.Wakeups++;
+  CONSOLE_Activity();
+}
+
+/**
+  * @brief  Console counters.
+  */
+const CONSOLE_StatsTypeDef *CONSOLE_GetStats(void)
+{
+  return &console_stats;
+}
@@ -46,12 +46,11 @@ typedef struct
 {
   HW_TS_pTimerCb_t  pTimerCallBack;
   uint32_t        CounterInit;
-  uint32_t        CountLeft;
+  uint32_t        Expiry;
   TimerIDStatus_t     TimerIDStatus;
   HW_TS_Mode_t   TimerMode;
   uint32_t        TimerProcessID;
-  uint8_t         PreviousID;
-  uint8_t         NextID;
+  uint8_t         HeapIndex;
 }TimerContext_t;
 
 /* Private defines -----------------------------------------------------------*/
@@ -66,8 +65,23 @@ typedef struct
  */
 
 static volatile TimerContext_t aTimerContext[CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER];
+
+/**
+ * The running timers are kept in a binary min-heap ordered on their expiry time, so that
+ * starting or stopping a timer costs O(log n) with the interrupts masked.
+ * The expiry time is an absolute tick count on the TimeBase scale, which is advanced each time
+ * the wakeup timer is set up, so the timers do not need to be updated one by one.
+ */
+static volatile uint8_t aTimerHeap[CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER];
+static volatile uint8_t TimerHeapSize;
+static volatile uint32_t TimeBase;
+
 static volatile uint8_t CurrentRunningTimerID;
-static volatile uint8_t PreviousRunningTimerID;
+/**
+ * Timer the wakeup timer has been set up for, CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER when it
+ * has to be set up again
+ */
+static volatile uint8_t ScheduledTimerID;
 static volatile uint32_t SSRValueOnLastSetup;
 static volatile WakeupTimerLimitation_Status_t  WakeupTimerLimitation;
 
@@ -88,9 +102,11 @@ static void RestartWakeupCounter(uint16_t Value);
 static uint16_t ReturnTimeElapsed(void);
 static void RescheduleTimerList(void);
 static void UnlinkTimer(uint8_t TimerID, RequestReadSSR_t RequestReadSSR);
-static void LinkTimerBefore(uint8_t TimerID, uint8_t RefTimerID);
-static void LinkTimerAfter(uint8_t TimerID, uint8_t RefTimerID);
-static uint16_t linkTimer(uint8_t TimerID);
+static uint8_t TimerExpiresBefore(uint8_t TimerID, uint8_t RefTimerID);
+static void HeapPlace(uint8_t TimerID, uint32_t Index);
+static void HeapSiftUp(uint32_t Index);
+static void HeapSiftDown(uint32_t Index);
+static void linkTimer(uint8_t TimerID);
 static uint32_t ReadRtcSsrValue(void);
 
 __weak void HW_TS_RTC_CountUpdated_AppNot(void);
@@ -124,123 +140,126 @@ static uint32_t ReadRtcSsrValue(void)
 }
 
 /**
- * @brief  Insert a Timer in the list after the Timer ID specified
+ * @brief  Compare the expiry time of two timers
+ * @note   The expiry times are compared through their difference so that the wrap around of
+ *         TimeBase does not matter, as long as no timer is started for more than 2^31 ticks
+ * @param  TimerID:   The ID of the Timer
+ * @param  RefTimerID: The ID of the Timer to compare with
+ * @retval 1 when TimerID expires first, 0 otherwise
+ */
+static uint8_t TimerExpiresBefore(uint8_t TimerID, uint8_t RefTimerID)
+{
+  return (uint8_t)((int32_t)(aTimerContext[TimerID].Expiry - aTimerContext[RefTimerID].Expiry) < 0);
+}
+
+/**
+ * @brief  Store a Timer at a position of the heap
  * @param  TimerID:   The ID of the Timer
- * @param  RefTimerID: The ID of the Timer to be linked after
+ * @param  Index: The position in the heap
  * @retval None
  */
-static void LinkTimerAfter(uint8_t TimerID, uint8_t RefTimerID)
+static void HeapPlace(uint8_t TimerID, uint32_t Index)
 {
-  uint8_t next_id;
+  aTimerHeap[Index] = TimerID;
+  aTimerContext[TimerID].HeapIndex = (uint8_t)Index;
 
-  next_id = aTimerContext[RefTimerID].NextID;
+  return;
+}
 
-  if(next_id != CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER)
+/**
+ * @brief  Move a Timer towards the top of the heap until its parent expires first
+ * @param  Index: The position of the Timer in the heap
+ * @retval None
+ */
+static void HeapSiftUp(uint32_t Index)
+{
+  uint8_t timer_id;
+  uint32_t parent;
+
+  timer_id = aTimerHeap[Index];
+
+  while(Index != 0)
   {
-    aTimerContext[next_id].PreviousID = TimerID;
+    parent = (Index - 1) >> 1;
+    if(TimerExpiresBefore(timer_id, aTimerHeap[parent]) == 0)
+    {
+      break;
+    }
+    HeapPlace(aTimerHeap[parent], Index);
+    Index = parent;
   }
-  aTimerContext[TimerID].NextID = next_id;
-  aTimerContext[TimerID].PreviousID = RefTimerID ;
-  aTimerContext[RefTimerID].NextID = TimerID;
+  HeapPlace(timer_id, Index);
 
   return;
 }
 
 /**
- * @brief  Insert a Timer in the list before the ID specified
- * @param  TimerID:   The ID of the Timer
- * @param  RefTimerID: The ID of the Timer to be linked before
+ * @brief  Move a Timer towards the bottom of the heap until it expires before its children
+ * @param  Index: The position of the Timer in the heap
  * @retval None
  */
-static void LinkTimerBefore(uint8_t TimerID, uint8_t RefTimerID)
+static void HeapSiftDown(uint32_t Index)
 {
-  uint8_t previous_id;
+  uint8_t timer_id;
+  uint32_t child;
 
-  if(RefTimerID != CurrentRunningTimerID)
-  {
-    previous_id = aTimerContext[RefTimerID].PreviousID;
+  timer_id = aTimerHeap[Index];
+  child = (Index << 1) + 1;
 
-    aTimerContext[previous_id].NextID = TimerID;
-    aTimerContext[TimerID].NextID = RefTimerID;
-    aTimerContext[TimerID].PreviousID = previous_id ;
-    aTimerContext[RefTimerID].PreviousID = TimerID;
-  }
-  else
+  while(child < TimerHeapSize)
   {
-    aTimerContext[TimerID].NextID = RefTimerID;
-    aTimerContext[RefTimerID].PreviousID = TimerID;
+    if(((child + 1) < TimerHeapSize) && (TimerExpiresBefore(aTimerHeap[child + 1], aTimerHeap[child]) != 0))
+    {
+      child++;
+    }
+    if(TimerExpiresBefore(aTimerHeap[child], timer_id) == 0)
+    {
+      break;
+    }
+    HeapPlace(aTimerHeap[child], Index);
+    Index = child;
+    child = (Index << 1) + 1;
   }
+  HeapPlace(timer_id, Index);
 
   return;
 }
 
 /**
  * @brief  Insert a Timer in the list
+ * @note   CounterInit shall hold the number of ticks to count
  * @param  TimerID:   The ID of the Timer
  * @retval None
  */
-static uint16_t linkTimer(uint8_t TimerID)
+static void linkTimer(uint8_t TimerID)
 {
-  uint32_t time_left;
   uint16_t time_elapsed;
-  uint8_t timer_id_lookup;
-  uint8_t next_id;
 
-  if(CurrentRunningTimerID == CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER)
+  if(TimerHeapSize == 0)
   {
     /**
      * No timer in the list
      */
-    PreviousRunningTimerID = CurrentRunningTimerID;
-    CurrentRunningTimerID = TimerID;
-    aTimerContext[TimerID].NextID = CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER;
-
     SSRValueOnLastSetup = SSR_FORBIDDEN_VALUE;
     time_elapsed = 0;
   }
   else
   {
     time_elapsed = ReturnTimeElapsed();
+  }
 
-    /**
-     * update count of the timer to be linked
-     */
-    aTimerContext[TimerID].CountLeft += time_elapsed;
-    time_left = aTimerContext[TimerID].CountLeft;
+  /**
+   * TimeBase is the time of the last setup of the wakeup timer
+   */
+  aTimerContext[TimerID].Expiry = TimeBase + time_elapsed + aTimerContext[TimerID].CounterInit;
 
-    /**
-     * Search for index where the new timer shall be linked
-     */
-    if(aTimerContext[CurrentRunningTimerID].CountLeft <= time_left)
-    {
-      /**
-       * Search for the ID after the first one
-       */
-      timer_id_lookup = CurrentRunningTimerID;
-      next_id = aTimerContext[timer_id_lookup].NextID;
-      while((next_id != CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER) && (aTimerContext[next_id].CountLeft <= time_left))
-      {
-        timer_id_lookup = aTimerContext[timer_id_lookup].NextID;
-        next_id = aTimerContext[timer_id_lookup].NextID;
-      }
+  HeapPlace(TimerID, TimerHeapSize);
+  TimerHeapSize++;
+  HeapSiftUp(TimerHeapSize - 1);
 
-      /**
-       * Link after the ID
-       */
-      LinkTimerAfter(TimerID, timer_id_lookup);
-    }
-    else
-    {
-      /**
-       * Link before the first ID
-       */
-      LinkTimerBefore(TimerID, CurrentRunningTimerID);
-      PreviousRunningTimerID = CurrentRunningTimerID;
-      CurrentRunningTimerID = TimerID;
-    }
-  }
+  CurrentRunningTimerID = aTimerHeap[0];
 
-  return time_elapsed;
+  return;
 }
 
 /**
@@ -251,24 +270,36 @@ static uint16_t linkTimer(uint8_t TimerID)
  */
 static void UnlinkTimer(uint8_t TimerID, RequestReadSSR_t RequestReadSSR)
 {
-  uint8_t previous_id;
-  uint8_t next_id;
+  uint32_t index;
+  uint8_t last_id;
+
+  index = aTimerContext[TimerID].HeapIndex;
+  TimerHeapSize--;
 
-  if(TimerID == CurrentRunningTimerID)
+  if(index != TimerHeapSize)
   {
-    PreviousRunningTimerID = CurrentRunningTimerID;
-    CurrentRunningTimerID = aTimerContext[TimerID].NextID;
+    /**
+     * Fill the hole with the last Timer of the heap and restore the order around it
+     */
+    last_id = aTimerHeap[TimerHeapSize];
+    HeapPlace(last_id, index);
+    if((index != 0) && (TimerExpiresBefore(last_id, aTimerHeap[(index - 1) >> 1]) != 0))
+    {
+      HeapSiftUp(index);
+    }
+    else
+    {
+      HeapSiftDown(index);
+    }
+  }
+
+  if(TimerHeapSize != 0)
+  {
+    CurrentRunningTimerID = aTimerHeap[0];
   }
   else
   {
-    previous_id = aTimerContext[TimerID].PreviousID;
-    next_id = aTimerContext[TimerID].NextID;
-
-    aTimerContext[previous_id].NextID = aTimerContext[TimerID].NextID;
-    if(next_id != CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER)
-    {
-      aTimerContext[next_id].PreviousID = aTimerContext[TimerID].PreviousID;
-    }
+    CurrentRunningTimerID = CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER;
   }
 
   /**
@@ -387,15 +418,14 @@ static void RestartWakeupCounter(uint16_t Value)
 
 /**
  * @brief  Reschedule the list of timer
- * @note  1) Update the count left for each timer in the list
- *    2) Setup the wakeuptimer
+ * @note  1) Move TimeBase to the current time
+ *    2) Setup the wakeuptimer for the first timer to expire
  * @param  None
  * @retval None
  */
 static void RescheduleTimerList(void)
 {
-  uint8_t   localTimerID;
-  uint32_t  timecountleft;
+  int32_t   timecountleft;
   uint16_t  wakeup_timer_value;
   uint16_t  time_elapsed;
 
@@ -412,19 +442,20 @@ static void RescheduleTimerList(void)
   }
   __HAL_RTC_WAKEUPTIMER_DISABLE(&hrtc);   /**<  Disable the Wakeup Timer */
 
-  localTimerID = CurrentRunningTimerID;
+  ScheduledTimerID = CurrentRunningTimerID;
 
   /**
-   * Calculate what will be the value to write in the wakeuptimer
+   * Read how much has been counted
    */
-  timecountleft = aTimerContext[localTimerID].CountLeft;
+  time_elapsed = ReturnTimeElapsed();
+  TimeBase += time_elapsed;
 
   /**
-   * Read how much has been counted
+   * Calculate what will be the value to write in the wakeuptimer
    */
-  time_elapsed = ReturnTimeElapsed();
+  timecountleft = (int32_t)(aTimerContext[CurrentRunningTimerID].Expiry - TimeBase);
 
-  if(timecountleft < time_elapsed )
+  if(timecountleft <= 0)
   {
     /**
      * There is no tick left to count
@@ -434,7 +465,7 @@ static void RescheduleTimerList(void)
   }
   else
   {
-    if(timecountleft > (time_elapsed + MaxWakeupTimerSetup))
+    if(timecountleft > MaxWakeupTimerSetup)
     {
       /**
        * The number of tick left is greater than the Wakeuptimer maximum value
@@ -445,28 +476,12 @@ static void RescheduleTimerList(void)
     }
     else
     {
-      wakeup_timer_value = timecountleft - time_elapsed;
+      wakeup_timer_value = (uint16_t)timecountleft;
       WakeupTimerLimitation = WakeupTimerValue_LargeEnough;
     }
 
   }
 
-  /**
-   * update ticks left to be counted for each timer
-   */
-  while(localTimerID != CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER)
-  {
-    if (aTimerContext[localTimerID].CountLeft < time_elapsed)
-    {
-      aTimerContext[localTimerID].CountLeft = 0;
-    }
-    else
-    {
-      aTimerContext[localTimerID].CountLeft -= time_elapsed;
-    }
-    localTimerID = aTimerContext[localTimerID].NextID;
-  }
-
   /**
    * Write next count
    */
@@ -524,6 +539,11 @@ void HW_TS_RTC_Wakeup_Handler(void)
      */
     if(WakeupTimerLimitation != WakeupTimerValue_Overpassed)
     {
+      /**
+       * The wakeup timer is stopped, it shall be set up again for the next timer
+       */
+      ScheduledTimerID = CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER;
+
       if(aTimerContext[local_current_running_timer_id].TimerMode == hw_ts_Repeated)
       {
         UnlinkTimer(local_current_running_timer_id, SSR_Read_Not_Requested);
@@ -639,7 +659,10 @@ void HW_TS_Init(HW_TS_InitMode_t TimerInitMode, RTC_HandleTypeDef *phrtc)
       aTimerContext[loop].TimerIDStatus = TimerID_Free;
     }
 
+    TimerHeapSize = 0;
+    TimeBase = 0;
     CurrentRunningTimerID = CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER;   /**<  Set ID to non valid value */
+    ScheduledTimerID = CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER;
 
     __HAL_RTC_WAKEUPTIMER_DISABLE(&hrtc);                       /**<  Disable the Wakeup Timer */
     __HAL_RTC_WAKEUPTIMER_CLEAR_FLAG(&hrtc, RTC_FLAG_WUTF);     /**<  Clear flag in RTC module */
@@ -761,6 +784,7 @@ void HW_TS_Stop(uint8_t timer_id)
         while(__HAL_RTC_WAKEUPTIMER_GET_FLAG(&hrtc, RTC_FLAG_WUTWF) == SET);
       }
       __HAL_RTC_WAKEUPTIMER_DISABLE(&hrtc);   /**<  Disable the Wakeup Timer */
+      ScheduledTimerID = CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER;
 
       while(__HAL_RTC_WAKEUPTIMER_GET_FLAG(&hrtc, RTC_FLAG_WUTWF) == RESET);
 
@@ -775,7 +799,7 @@ void HW_TS_Stop(uint8_t timer_id)
       __HAL_RTC_WAKEUPTIMER_EXTI_CLEAR_FLAG(); /**<  Clear flag in EXTI module */
       HAL_NVIC_ClearPendingIRQ(CFG_HW_TS_RTC_WAKEUP_HANDLER_ID);   /**<  Clear pending bit in NVIC */
     }
-    else if(PreviousRunningTimerID != localcurrentrunningtimerid)
+    else if(ScheduledTimerID != localcurrentrunningtimerid)
     {
       RescheduleTimerList();
     }
@@ -795,7 +819,6 @@ void HW_TS_Stop(uint8_t timer_id)
 
 void HW_TS_Start(uint8_t timer_id, uint32_t timeout_ticks)
 {
-  uint16_t time_elapsed;
   uint8_t localcurrentrunningtimerid;
 
 #if (CFG_HW_TS_USE_PRIMASK_AS_CRITICAL_SECTION == 1)
@@ -819,21 +842,19 @@ void HW_TS_Start(uint8_t timer_id, uint32_t timeout_ticks)
 
   aTimerContext[timer_id].TimerIDStatus = TimerID_Running;
 
-  aTimerContext[timer_id].CountLeft = timeout_ticks;
   aTimerContext[timer_id].CounterInit = timeout_ticks;
 
-  time_elapsed =  linkTimer(timer_id);
+  linkTimer(timer_id);
 
   localcurrentrunningtimerid = CurrentRunningTimerID;
 
-  if(PreviousRunningTimerID != localcurrentrunningtimerid)
+  /**
+   * The wakeup timer is set up again only when the new timer is the first to expire
+   */
+  if(ScheduledTimerID != localcurrentrunningtimerid)
   {
     RescheduleTimerList();
   }
-  else
-  {
-    aTimerContext[timer_id].CountLeft -= time_elapsed;
-  }
 
   /* Enable the write protection for RTC registers */
   __HAL_RTC_WRITEPROTECTION_ENABLE( &hrtc );
@@ -56,6 +56,9 @@ extern UART_HandleTypeDef huart1;
 #endif
     void (*HW_huart1RxCb)(void);
     void (*HW_huart1TxCb)(void);
+#if (CFG_HW_USART1_DMA_RX_SUPPORTED == 1)
+    void (*HW_huart1RxEvtCb)(uint16_t);
+#endif
 #endif
 
 #if (CFG_HW_LPUART1_ENABLED == 1)
@@ -212,6 +215,55 @@ hw_status_t HW_UART_Transmit_DMA(hw_uart_id_t hw_uart_id, uint8_t *p_data, uint1
     return hw_status;
 }
 
+/**
+ * Circular DMA reception, ended only by a reception error.
+ * cb runs in interrupt context with the DMA write position in p_data on the idle line, half transfer
+ * and transfer complete events, or with HW_UART_RX_STOPPED once an error stopped the reception
+ */
+hw_status_t HW_UART_ReceiveToIdle_DMA(hw_uart_id_t hw_uart_id, uint8_t *p_data, uint16_t size, void (*cb)(uint16_t))
+{
+    HAL_StatusTypeDef hal_status = HAL_ERROR;
+    hw_status_t hw_status = hw_uart_ok;
+
+    switch (hw_uart_id)
+    {
+#if (CFG_HW_USART1_DMA_RX_SUPPORTED == 1)
+        case hw_uart1:
+            HW_huart1RxEvtCb = cb;
+            huart1.Instance = USART1;
+            hal_status = HAL_UARTEx_ReceiveToIdle_DMA(&huart1, p_data, size);
+            break;
+#endif
+
+        default:
+            break;
+    }
+
+    switch (hal_status)
+    {
+        case HAL_OK:
+            hw_status = hw_uart_ok;
+            break;
+
+        case HAL_ERROR:
+            hw_status = hw_uart_error;
+            break;
+
+        case HAL_BUSY:
+            hw_status = hw_uart_busy;
+            break;
+
+        case HAL_TIMEOUT:
+            hw_status = hw_uart_to;
+            break;
+
+        default:
+            break;
+    }
+
+    return hw_status;
+}
+
 void HW_UART_Interrupt_Handler(hw_uart_id_t hw_uart_id)
 {
     switch (hw_uart_id)
@@ -315,3 +367,44 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 
     return;
 }
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    switch ((uint32_t)huart->Instance)
+    {
+#if (CFG_HW_USART1_DMA_RX_SUPPORTED == 1)
+        case (uint32_t)USART1:
+            if(HW_huart1RxEvtCb)
+            {
+                HW_huart1RxEvtCb(Size);
+            }
+            break;
+#endif
+
+        default:
+            break;
+    }
+
+    return;
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    switch ((uint32_t)huart->Instance)
+    {
+#if (CFG_HW_USART1_DMA_RX_SUPPORTED == 1)
+        case (uint32_t)USART1:
+            /* Only blocking errors (overrun, DMA error) end the reception */
+            if((HW_huart1RxEvtCb) && (huart->RxState == HAL_UART_STATE_READY))
+            {
+                HW_huart1RxEvtCb(HW_UART_RX_STOPPED);
+            }
+            break;
+#endif
+
+        default:
+            break;
+    }
+
+    return;
+}
@@ -0,0 +1,192 @@
+/**
+  ******************************************************************************
+  * @file           : lamp_seq.c
+  * @brief          : Preloaded lamp sequences played back by the timer server.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "lamp_seq.h"
+#include "app_common.h"
+#include "hw_if.h"
+#include "lamps.h"
+
+/* Private variables ---------------------------------------------------------*/
+/* Active sequence, written only while the timer is stopped */
+static uint16_t seq_steps[LAMP_SEQ_MAX_STEPS];
+static uint32_t seq_count;
+static uint8_t seq_loop;
+
+/* Playback position, owned by the timer callback while it runs */
+static uint32_t seq_index;
+/* Sub-tick remainder in 1/1000 tick, carried over so step times do not drift */
+static uint32_t seq_tick_rem;
+
+static uint8_t seq_timer_id;
+static LAMP_SEQ_StatsTypeDef seq_stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static void LAMP_SEQ_TimerCb(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Start the timer for the given time, rounded to timer ticks.
+  * @param  ms: time until the next step
+  */
+static void LAMP_SEQ_Arm(uint32_t ms)
+{
+  uint32_t scaled = ms * CFG_TS_TICKS_PER_SEC + seq_tick_rem;
+
+  seq_tick_rem = scaled % 1000U;
+  HW_TS_Start(seq_timer_id, scaled / 1000U);
+}
+
+/**
+  * @brief  Start the active sequence at the given phase. The timer must be
+  *         stopped.
+  * @param  phase_ms: offset into the sequence
+  */
+static void LAMP_SEQ_Start(uint32_t phase_ms)
+{
+  uint32_t total_ms = 0U;
+  uint32_t step_ms = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < seq_count; i++)
+  {
+    total_ms += LAMP_SEQ_STEP_UNITS(seq_steps[i]) * LAMP_SEQ_TIME_UNIT_MS;
+  }
+
+  if (phase_ms >= total_ms)
+  {
+    if (!seq_loop)
+    {
+      /* Already past the end: just hold the final state */
+      seq_index = seq_count - 1U;
+      Lamps_Write(LAMP_SEQ_STEP_STATE(seq_steps[seq_index]));
+      seq_stats.Steps++;
+      return;
+    }
+    phase_ms %= total_ms;
+  }
+
+  for (i = 0U; ; i++)
+  {
+    step_ms = LAMP_SEQ_STEP_UNITS(seq_steps[i]) * LAMP_SEQ_TIME_UNIT_MS;
+    if (phase_ms < step_ms)
+    {
+      break;
+    }
+    phase_ms -= step_ms;
+  }
+
+  seq_index = i;
+  seq_tick_rem = 0U;
+  Lamps_Write(LAMP_SEQ_STEP_STATE(seq_steps[i]));
+  seq_stats.Steps++;
+  LAMP_SEQ_Arm(step_ms - phase_ms);
+}
+
+/**
+  * @brief  Timer server callback, runs in the RTC wakeup interrupt: advance
+  *         to the next step.
+  */
+static void LAMP_SEQ_TimerCb(void)
+{
+  uint32_t next = seq_index + 1U;
+
+  if (next >= seq_count)
+  {
+    if (!seq_loop)
+    {
+      return;
+    }
+    next = 0U;
+    seq_stats.Loops++;
+  }
+  seq_index = next;
+  Lamps_Write(LAMP_SEQ_STEP_STATE(seq_steps[next]));
+  seq_stats.Steps++;
+  LAMP_SEQ_Arm(LAMP_SEQ_STEP_UNITS(seq_steps[next]) * LAMP_SEQ_TIME_UNIT_MS);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Reserve the timer server slot. Call after the timer server is
+  *         initialised.
+  */
+void LAMP_SEQ_Init(void)
+{
+  (void)HW_TS_Create(CFG_TIM_PROC_ID_ISR, &seq_timer_id, hw_ts_SingleShot, LAMP_SEQ_TimerCb);
+}
+
+/**
+  * @brief  Replace the running sequence. Task context only.
+  * @param  buf: packed sequence
+  * @param  len: its length
+  * @retval 1 if the sequence was valid, 0 otherwise (the old one keeps running)
+  */
+uint8_t LAMP_SEQ_Load(const uint8_t *buf, uint32_t len)
+{
+  uint32_t count, i;
+  uint16_t step;
+
+  if (len < LAMP_SEQ_HEADER_SIZE)
+  {
+    seq_stats.Rejected++;
+    return 0U;
+  }
+  count = buf[1];
+  if ((count > LAMP_SEQ_MAX_STEPS) ||
+      (len != LAMP_SEQ_HEADER_SIZE + count * LAMP_SEQ_STEP_SIZE))
+  {
+    seq_stats.Rejected++;
+    return 0U;
+  }
+  for (i = 0U; i < count; i++)
+  {
+    /* Zero length steps would spin in the timer interrupt */
+    if (LAMP_SEQ_STEP_UNITS(buf[LAMP_SEQ_HEADER_SIZE + 2U * i] |
+                            (buf[LAMP_SEQ_HEADER_SIZE + 2U * i + 1U] << 8)) == 0U)
+    {
+      seq_stats.Rejected++;
+      return 0U;
+    }
+  }
+
+  LAMP_SEQ_Stop();
+
+  seq_loop = (uint8_t)(buf[0] & LAMP_SEQ_FLAG_LOOP);
+  seq_count = count;
+  for (i = 0U; i < count; i++)
+  {
+    step = (uint16_t)(buf[LAMP_SEQ_HEADER_SIZE + 2U * i] |
+                      (buf[LAMP_SEQ_HEADER_SIZE + 2U * i + 1U] << 8));
+    seq_steps[i] = step;
+  }
+
+  if (count != 0U)
+  {
+    seq_stats.Uploads++;
+    LAMP_SEQ_Start((uint32_t)(buf[2] | (buf[3] << 8)) * LAMP_SEQ_TIME_UNIT_MS);
+  }
+  return 1U;
+}
+
+/**
+  * @brief  Stop the running sequence, leaving the lamps as they are.
+  */
+void LAMP_SEQ_Stop(void)
+{
+  HW_TS_Stop(seq_timer_id);
+}
+
+/**
+  * @brief  Sequence counters.
+  */
+const LAMP_SEQ_StatsTypeDef *LAMP_SEQ_GetStats(void)
+{
+  return &seq_stats;
+}
@@ -0,0 +1,180 @@
+/**
+  ******************************************************************************
+  * @file           : lamp_stream.c
+  * @brief          : Batches of timed lamp steps written to B_LED_C.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "lamp_stream.h"
+#include "app_common.h"
+#include "dbg_trace.h"
+#include "hw_if.h"
+#include "lamps.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint8_t  State;
+  uint16_t HoldMs;
+} LAMP_STREAM_StepTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+/* Filled from the BLE task, emptied by the timer callback */
+static LAMP_STREAM_StepTypeDef stream_queue[LAMP_STREAM_QUEUE_SIZE];
+static volatile uint32_t stream_head;
+static volatile uint32_t stream_tail;
+/* Set while a step is being held; cleared by the callback on underrun */
+static volatile uint8_t stream_playing;
+
+static LAMP_STREAM_StatsTypeDef stream_stats;
+static uint8_t stream_next_seq;
+static uint8_t stream_synced;
+
+/* Sub-tick remainder in 1/1000 tick, carried over so back to back steps do
+   not drift */
+static uint32_t stream_tick_rem;
+static uint8_t stream_timer_id;
+
+/* Private function prototypes -----------------------------------------------*/
+static void LAMP_STREAM_TimerCb(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Apply queued steps until one has to be held, then start the timer.
+  *         Runs in the timer callback, or in the BLE task while idle.
+  */
+static void LAMP_STREAM_Play(void)
+{
+  uint32_t tail = stream_tail;
+  uint32_t scaled;
+  LAMP_STREAM_StepTypeDef step;
+
+  do
+  {
+    if (stream_head == tail)
+    {
+      stream_playing = 0U;
+      return;
+    }
+    __DMB();
+    step = stream_queue[tail & (LAMP_STREAM_QUEUE_SIZE - 1U)];
+    tail++;
+    stream_tail = tail;
+    Lamps_Write(step.State);
+  } while (step.HoldMs == 0U);
+
+  scaled = (uint32_t)step.HoldMs * CFG_TS_TICKS_PER_SEC + stream_tick_rem;
+  stream_tick_rem = scaled % 1000U;
+  HW_TS_Start(stream_timer_id, scaled / 1000U);
+}
+
+/**
+  * @brief  Timer server callback, runs in the RTC wakeup interrupt: the
+  *         current step is over.
+  */
+static void LAMP_STREAM_TimerCb(void)
+{
+  LAMP_STREAM_Play();
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Reserve the timer server slot. Call after the timer server is
+  *         initialised.
+  */
+void LAMP_STREAM_Init(void)
+{
+  (void)HW_TS_Create(CFG_TIM_PROC_ID_ISR, &stream_timer_id, hw_ts_SingleShot, LAMP_STREAM_TimerCb);
+}
+
+/**
+  * @brief  Drop all queued steps and resynchronise on the next sequence
+  *         number. Task context only.
+  */
+void LAMP_STREAM_Reset(void)
+{
+  HW_TS_Stop(stream_timer_id);
+  stream_playing = 0U;
+  stream_tail = stream_head;
+  stream_synced = 0U;
+}
+
+/**
+  * @brief  Queue the steps of one frame and start playing if idle. Task
+  *         context only.
+  * @param  buf: frame, without the opcode
+  * @param  len: frame length
+  * @retval 1 if the frame was accepted, 0 if it was malformed
+  */
+uint8_t LAMP_STREAM_PutFrame(const uint8_t *buf, uint32_t len)
+{
+  uint32_t count, i;
+  uint32_t head = stream_head;
+  uint8_t seq_diff;
+
+  if ((len < LAMP_STREAM_HEADER_SIZE) ||
+      (len < LAMP_STREAM_HEADER_SIZE + (uint32_t)buf[1] * LAMP_STREAM_STEP_SIZE))
+  {
+    stream_stats.Malformed++;
+    return 0U;
+  }
+
+  seq_diff = (uint8_t)(buf[0] - stream_next_seq);
+  if (stream_synced && (seq_diff != 0U))
+  {
+    /* A frame behind the expected one wraps to a large difference: it is a
+       repeat or a late frame, not 255 lost ones. Either way the stream
+       resynchronises on it */
+    if (seq_diff < 128U)
+    {
+      stream_stats.SeqGaps += seq_diff;
+      APP_DBG_MSG("lamp stream: %d frame(s) missing before #%d\n", seq_diff, buf[0]);
+    }
+    else
+    {
+      stream_stats.Reordered++;
+      APP_DBG_MSG("lamp stream: #%d repeated or late, expected #%d\n", buf[0], stream_next_seq);
+    }
+  }
+  stream_next_seq = (uint8_t)(buf[0] + 1U);
+  stream_synced = 1U;
+  stream_stats.Frames++;
+
+  count = buf[1];
+  buf += LAMP_STREAM_HEADER_SIZE;
+  for (i = 0U; i < count; i++, buf += LAMP_STREAM_STEP_SIZE)
+  {
+    if ((head - stream_tail) >= LAMP_STREAM_QUEUE_SIZE)
+    {
+      stream_stats.Dropped += count - i;
+      break;
+    }
+    stream_queue[head & (LAMP_STREAM_QUEUE_SIZE - 1U)].State = buf[0];
+    stream_queue[head & (LAMP_STREAM_QUEUE_SIZE - 1U)].HoldMs = (uint16_t)(buf[1] | (buf[2] << 8));
+    head++;
+  }
+  /* Publish the steps before the callback may look at them */
+  __DMB();
+  stream_head = head;
+
+  /* An idle player has no timer pending, so nothing can race the kick */
+  if (!stream_playing)
+  {
+    stream_playing = 1U;
+    stream_tick_rem = 0U;
+    LAMP_STREAM_Play();
+  }
+
+  return 1U;
+}
+
+/**
+  * @brief  Stream counters.
+  */
+const LAMP_STREAM_StatsTypeDef *LAMP_STREAM_GetStats(void)
+{
+  return &stream_stats;
+}
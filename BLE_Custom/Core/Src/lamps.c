@@ -0,0 +1,60 @@
+/**
+  ******************************************************************************
+  * @file           : lamps.c
+  * @brief          : Traffic light lamp outputs.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "lamps.h"
+#include "telemetry.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Ports carrying lamps, in the order they are written */
+#define LAMPS_PORT_NBR      2U
+
+/* Private macro -------------------------------------------------------------*/
+/* Pin mask of a main.h pin if it lives on the given port, 0 otherwise */
+#define LAMPS_PIN(port, name) \
+  ((((name##_GPIO_Port) == (port))) ? (uint32_t)(name##_Pin) : 0U)
+
+#define LAMPS_GREEN(port)   LAMPS_PIN(port, TRAFFIC_GR)
+#define LAMPS_YELLOW(port)  LAMPS_PIN(port, TRAFFIC_YL)
+#define LAMPS_RED(port)     LAMPS_PIN(port, TRAFFIC_RD)
+#define LAMPS_ALL(port)     (LAMPS_GREEN(port) | LAMPS_YELLOW(port) | LAMPS_RED(port))
+
+#define LAMPS_SET(port, state)                                   \
+  ((((state) & LAMPS_STATE_GREEN) ? LAMPS_GREEN(port) : 0U) |    \
+   (((state) & LAMPS_STATE_YELLOW) ? LAMPS_YELLOW(port) : 0U) |  \
+   (((state) & LAMPS_STATE_RED) ? LAMPS_RED(port) : 0U))
+
+/* BSRR: low half sets, high half resets the lamps that must be off */
+#define LAMPS_BSRR(port, state) \
+  (LAMPS_SET(port, state) | ((LAMPS_ALL(port) & ~LAMPS_SET(port, state)) << 16))
+
+#define LAMPS_BSRR_ROW(port)                                  \
+  { LAMPS_BSRR(port, 0U), LAMPS_BSRR(port, 1U),               \
+    LAMPS_BSRR(port, 2U), LAMPS_BSRR(port, 3U),               \
+    LAMPS_BSRR(port, 4U), LAMPS_BSRR(port, 5U),               \
+    LAMPS_BSRR(port, 6U), LAMPS_BSRR(port, 7U) }
+
+/* Private variables ---------------------------------------------------------*/
+static const uint32_t lamps_bsrr[LAMPS_PORT_NBR][LAMPS_STATE_MASK + 1U] =
+{
+  LAMPS_BSRR_ROW(GPIOC),
+  LAMPS_BSRR_ROW(GPIOA),
+};
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Drive the traffic light lamps from a 3-bit state.
+  * @param  state: bit0 = green, bit1 = yellow, bit2 = red
+  */
+void Lamps_Write(uint8_t state)
+{
+  state &= LAMPS_STATE_MASK;
+  GPIOC->BSRR = lamps_bsrr[0][state];
+  GPIOA->BSRR = lamps_bsrr[1][state];
+  TELEMETRY_PutTicked(TELEMETRY_REC_LAMPS, state);
+}
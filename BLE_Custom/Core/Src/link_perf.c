@@ -0,0 +1,214 @@
+/**
+  ******************************************************************************
+  * @file           : link_perf.c
+  * @brief          : Data length and PHY upgrade, link figures on LINK_C.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "link_perf.h"
+#include "app_common.h"
+#include "dbg_trace.h"
+#include "ble.h"
+#include "custom_stm.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Values in force until something else is negotiated */
+#define LINK_PERF_DEFAULT_OCTETS  27U
+#define LINK_PERF_DEFAULT_MTU     23U
+#define LINK_PERF_PHY_1M          1U
+#define LINK_PERF_PHY_2M          2U
+#define LINK_PERF_PHY_CODED       3U
+
+/* Inter frame space and the ACL framing around the ATT payload */
+#define LINK_PERF_T_IFS_NS        150000U
+#define LINK_PERF_L2CAP_HEADER    4U
+#define LINK_PERF_ATT_HEADER      3U
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t link_tx_phy;
+static uint8_t link_rx_phy;
+static uint16_t link_tx_octets;
+static uint16_t link_rx_octets;
+static uint16_t link_interval;
+static uint16_t link_mtu;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Air time of one LL data PDU.
+  * @param  octets: payload length
+  * @param  phy: PHY it is sent on
+  * @retval time in ns
+  */
+static uint32_t LINK_PERF_PduNs(uint32_t octets, uint8_t phy)
+{
+  /* Access address, header and CRC around the payload */
+  uint32_t bits = (4U + 2U + octets + 3U) * 8U;
+
+  switch (phy)
+  {
+    case LINK_PERF_PHY_2M:
+      return 8000U + bits * 500U;
+
+    case LINK_PERF_PHY_CODED:
+      /* S=8 coding throughout, 80 us preamble */
+      return 80000U + bits * 8000U;
+
+    default:
+      return 8000U + bits * 1000U;
+  }
+}
+
+/**
+  * @brief  Estimate the ATT payload rate in one direction.
+  * @param  octets: max data PDU payload in that direction
+  * @param  data_phy: PHY of the data PDUs
+  * @param  ack_phy: PHY of the empty PDUs answering them
+  * @retval bytes per second
+  */
+static uint32_t LINK_PERF_Rate(uint16_t octets, uint8_t data_phy, uint8_t ack_phy)
+{
+  uint32_t interval_ns = (uint32_t)link_interval * 1250000U;
+  uint32_t pair_ns, pdus, payload;
+
+  if (interval_ns == 0U)
+  {
+    return 0U;
+  }
+  pair_ns = LINK_PERF_PduNs(octets, data_phy) + LINK_PERF_PduNs(0U, ack_phy) + 2U * LINK_PERF_T_IFS_NS;
+  pdus = interval_ns / pair_ns;
+  /* An ATT PDU never carries more than ATT_MTU bytes */
+  payload = MIN((uint32_t)octets - LINK_PERF_L2CAP_HEADER, (uint32_t)link_mtu) - LINK_PERF_ATT_HEADER;
+
+  return (uint32_t)(((uint64_t)pdus * payload * 1000000000U) / interval_ns);
+}
+
+/**
+  * @brief  Write the current figures to LINK_C.
+  */
+static void LINK_PERF_Publish(void)
+{
+  uint8_t value[LINK_PERF_VALUE_SIZE];
+  uint32_t down = LINK_PERF_Rate(link_tx_octets, link_tx_phy, link_rx_phy);
+  uint32_t up = LINK_PERF_Rate(link_rx_octets, link_rx_phy, link_tx_phy);
+
+  value[0] = link_tx_phy;
+  value[1] = link_rx_phy;
+  value[2] = (uint8_t)link_tx_octets;
+  value[3] = (uint8_t)(link_tx_octets >> 8);
+  value[4] = (uint8_t)link_rx_octets;
+  value[5] = (uint8_t)(link_rx_octets >> 8);
+  value[6] = (uint8_t)link_interval;
+  value[7] = (uint8_t)(link_interval >> 8);
+  value[8] = (uint8_t)link_mtu;
+  value[9] = (uint8_t)(link_mtu >> 8);
+  value[10] = (uint8_t)down;
+  value[11] = (uint8_t)(down >> 8);
+  value[12] = (uint8_t)(down >> 16);
+  value[13] = (uint8_t)(down >> 24);
+  value[14] = (uint8_t)up;
+  value[15] = (uint8_t)(up >> 8);
+  value[16] = (uint8_t)(up >> 16);
+  value[17] = (uint8_t)(up >> 24);
+
+  APP_DBG_MSG("  Link: PHY %d/%d, octets %d/%d, MTU %d, ~%ld B/s down, ~%ld B/s up\n\r",
+              link_tx_phy, link_rx_phy, link_tx_octets, link_rx_octets, link_mtu, down, up);
+  /* Called from the HCI event handlers: do not wait for CPU2 */
+  (void)Custom_STM_App_Update_Char_Async(CUSTOM_STM_LINK_C, value);
+}
+
+/**
+  * @brief  Restore the figures of a fresh connection.
+  */
+static void LINK_PERF_Reset(void)
+{
+  link_tx_phy = LINK_PERF_PHY_1M;
+  link_rx_phy = LINK_PERF_PHY_1M;
+  link_tx_octets = LINK_PERF_DEFAULT_OCTETS;
+  link_rx_octets = LINK_PERF_DEFAULT_OCTETS;
+  link_mtu = LINK_PERF_DEFAULT_MTU;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  A central connected: ask for the longest data PDUs and the 2M
+  *         PHY. The results arrive as HCI_LE_DATA_LENGTH_CHANGE and
+  *         HCI_LE_PHY_UPDATE_COMPLETE.
+  * @param  ConnectionHandle: connection handle
+  * @param  Interval: connection interval, 1.25 ms units
+  */
+void LINK_PERF_Connected(uint16_t ConnectionHandle, uint16_t Interval)
+{
+  tBleStatus ret;
+
+  link_interval = Interval;
+  LINK_PERF_Reset();
+  LINK_PERF_Publish();
+
+  ret = hci_le_set_data_length(ConnectionHandle, LINK_PERF_MAX_OCTETS, LINK_PERF_MAX_TIME_US);
+  if (ret != BLE_STATUS_SUCCESS)
+  {
+    APP_DBG_MSG("  Fail   : hci_le_set_data_length command, result: 0x%x \n\r", ret);
+  }
+  ret = hci_le_set_phy(ConnectionHandle, ALL_PHYS_PREFERENCE, TX_2M_PREFERRED, RX_2M_PREFERRED, 0);
+  if (ret != BLE_STATUS_SUCCESS)
+  {
+    APP_DBG_MSG("  Fail   : hci_le_set_phy command, result: 0x%x \n\r", ret);
+  }
+}
+
+/**
+  * @brief  The link is gone.
+  */
+void LINK_PERF_Disconnected(void)
+{
+  link_interval = 0U;
+  LINK_PERF_Reset();
+  LINK_PERF_Publish();
+}
+
+/**
+  * @brief  HCI_LE_CONNECTION_UPDATE_COMPLETE received.
+  * @param  Interval: connection interval, 1.25 ms units
+  */
+void LINK_PERF_SetInterval(uint16_t Interval)
+{
+  link_interval = Interval;
+  LINK_PERF_Publish();
+}
+
+/**
+  * @brief  HCI_LE_PHY_UPDATE_COMPLETE received.
+  * @param  TxPhy: PHY used to send
+  * @param  RxPhy: PHY used to receive
+  */
+void LINK_PERF_SetPhy(uint8_t TxPhy, uint8_t RxPhy)
+{
+  link_tx_phy = TxPhy;
+  link_rx_phy = RxPhy;
+  LINK_PERF_Publish();
+}
+
+/**
+  * @brief  HCI_LE_DATA_LENGTH_CHANGE received.
+  * @param  MaxTxOctets: longest data PDU payload sent
+  * @param  MaxRxOctets: longest data PDU payload received
+  */
+void LINK_PERF_SetDataLength(uint16_t MaxTxOctets, uint16_t MaxRxOctets)
+{
+  link_tx_octets = MaxTxOctets;
+  link_rx_octets = MaxRxOctets;
+  LINK_PERF_Publish();
+}
+
+/**
+  * @brief  ATT_MTU exchanged.
+  * @param  Mtu: ATT_MTU
+  */
+void LINK_PERF_SetMtu(uint16_t Mtu)
+{
+  link_mtu = Mtu;
+  LINK_PERF_Publish();
+}
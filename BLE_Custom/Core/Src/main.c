@@ -73,6 +73,8 @@ RNG_HandleTypeDef hrng;
 RTC_HandleTypeDef hrtc;
 
 /* USER CODE BEGIN PV */
+/* Circular reception of the console, see console.c */
+DMA_HandleTypeDef hdma_usart1_rx;
 
 /* USER CODE END PV */
 
@@ -44,6 +44,9 @@ static void Switch_On_HSI(void);
 static void EnterLowPower(void);
 static void ExitLowPower(void);
 /* USER CODE BEGIN Private_Function_Prototypes */
+static uint32_t ReadRtcUnits(void);
+static void LowPowerStart(UTIL_LPM_Mode_t Mode);
+static void LowPowerEnd(void);
 
 /* USER CODE END Private_Function_Prototypes */
 /* Private typedef -----------------------------------------------------------*/
@@ -52,14 +55,33 @@ static void ExitLowPower(void);
 /* USER CODE END Private_Typedef */
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN Private_Define */
+/* RTC calendar period, in calendar seconds */
+#define RTC_SECONDS_PER_DAY   86400U
+
+/**
+ * SSR counts at LSE / (PREDIV_A + 1). With CFG_RTCCLK_DIVIDER_CONF 0, PREDIV_S is
+ * 0x7FFF rather than that rate minus one and a calendar second lasts 16 s, so RTC
+ * units are converted to time with the SSR rate only
+ */
+#define RTC_UNITS_PER_SECOND  (LSE_VALUE / (CFG_RTC_ASYNCH_PRESCALER + 1U))
 
 /* USER CODE END Private_Define */
 /* Private macro -------------------------------------------------------------*/
 /* USER CODE BEGIN Private_Macro */
+#define BCD_TO_BIN(bcd)       ((((bcd) >> 4) * 10U) + ((bcd) & 0x0FU))
 
 /* USER CODE END Private_Macro */
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN Private_Variables */
+/**
+ * SysTick is suspended in Sleep and Stop modes: the time spent there is read from
+ * the RTC, which keeps running on LSE, and added to the HAL tick on exit
+ */
+static UTIL_LPM_Mode_t LowPowerMode;
+static uint32_t LowPowerStartUnits;
+/* Sub millisecond remainder, in 1/1000 RTC unit, carried over so the HAL tick does not drift */
+static uint32_t LowPowerUnitsRem;
+static PWR_LpmStatsTypeDef LowPowerStats;
 
 /* USER CODE END Private_Variables */
 
@@ -72,6 +94,7 @@ static void ExitLowPower(void);
 void PWR_EnterOffMode(void)
 {
 /* USER CODE BEGIN PWR_EnterOffMode_1 */
+  LowPowerStats.Entries[UTIL_LPM_OFFMODE]++;
 
 /* USER CODE END PWR_EnterOffMode_1 */
   /**
@@ -139,6 +162,7 @@ void PWR_ExitOffMode(void)
 void PWR_EnterStopMode(void)
 {
 /* USER CODE BEGIN PWR_EnterStopMode_1 */
+  LowPowerStart(UTIL_LPM_STOPMODE);
 
 /* USER CODE END PWR_EnterStopMode_1 */
   /**
@@ -196,6 +220,7 @@ void PWR_ExitStopMode(void)
 
   HAL_ResumeTick();
 /* USER CODE BEGIN PWR_ExitStopMode_2 */
+  LowPowerEnd();
 
 /* USER CODE END PWR_ExitStopMode_2 */
   return;
@@ -210,6 +235,7 @@ void PWR_ExitStopMode(void)
 void PWR_EnterSleepMode(void)
 {
 /* USER CODE BEGIN PWR_EnterSleepMode_1 */
+  LowPowerStart(UTIL_LPM_SLEEPMODE);
 
 /* USER CODE END PWR_EnterSleepMode_1 */
 
@@ -247,6 +273,7 @@ void PWR_ExitSleepMode(void)
 /* USER CODE END PWR_ExitSleepMode_1 */
   HAL_ResumeTick();
 /* USER CODE BEGIN PWR_ExitSleepMode_2 */
+  LowPowerEnd();
 
 /* USER CODE END PWR_ExitSleepMode_2 */
   return;
@@ -347,6 +374,92 @@ static void Switch_On_HSI(void)
 }
 
 /* USER CODE BEGIN Private_Functions */
+/**
+  * @brief Read the RTC time of day
+  * @param none
+  * @retval time of day in SSR counts (PREDIV_S + 1 per calendar second)
+  */
+static uint32_t ReadRtcUnits(void)
+{
+  uint32_t ssr, tr, units_per_calendar_second, seconds;
+
+  /**
+   * The shadow registers are bypassed (see HW_TS_Init()): TR is consistent when SSR
+   * did not reload while reading it
+   */
+  do
+  {
+    ssr = READ_BIT(RTC->SSR, RTC_SSR_SS);
+    tr = READ_REG(RTC->TR);
+  } while (ssr != READ_BIT(RTC->SSR, RTC_SSR_SS));
+
+  units_per_calendar_second = READ_BIT(RTC->PRER, RTC_PRER_PREDIV_S) + 1U;
+  seconds = BCD_TO_BIN((tr & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos) * 3600U +
+            BCD_TO_BIN((tr & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos) * 60U +
+            BCD_TO_BIN((tr & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos);
+
+  /* SSR counts down from PREDIV_S */
+  return (seconds * units_per_calendar_second) + (units_per_calendar_second - 1U - ssr);
+}
+
+/**
+  * @brief Record the entry in a low power mode
+  * @param Mode: Sleep or Stop mode
+  * @retval none
+  */
+static void LowPowerStart(UTIL_LPM_Mode_t Mode)
+{
+  LowPowerMode = Mode;
+  LowPowerStartUnits = ReadRtcUnits();
+  LowPowerStats.Entries[Mode]++;
+
+  return;
+}
+
+/**
+  * @brief Account the time spent in the low power mode and catch up the HAL tick
+  * @note  Called from CRITICAL SECTION, before the wakeup interrupt is served
+  * @param none
+  * @retval none
+  */
+static void LowPowerEnd(void)
+{
+  uint32_t units_per_day, now, elapsed, elapsed_ms;
+
+  units_per_day = RTC_SECONDS_PER_DAY * (READ_BIT(RTC->PRER, RTC_PRER_PREDIV_S) + 1U);
+
+  /* A day is close to 2^32 units: handle the wrap without overflowing */
+  now = ReadRtcUnits();
+  if (now >= LowPowerStartUnits)
+  {
+    elapsed = now - LowPowerStartUnits;
+  }
+  else
+  {
+    elapsed = now + (units_per_day - LowPowerStartUnits);
+  }
+
+  elapsed_ms = (elapsed / RTC_UNITS_PER_SECOND) * 1000U;
+  elapsed = ((elapsed % RTC_UNITS_PER_SECOND) * 1000U) + LowPowerUnitsRem;
+  elapsed_ms += elapsed / RTC_UNITS_PER_SECOND;
+  LowPowerUnitsRem = elapsed % RTC_UNITS_PER_SECOND;
+
+  /* The HAL tick runs at 1 kHz */
+  uwTick += elapsed_ms;
+  LowPowerStats.TimeMs[LowPowerMode] += elapsed_ms;
+
+  return;
+}
+
+/**
+  * @brief Returns the low power mode counters
+  * @param none
+  * @retval counters, updated on every low power mode exit
+  */
+const PWR_LpmStatsTypeDef *PWR_GetLpmStats(void)
+{
+  return &LowPowerStats;
+}
 
 /* USER CODE END Private_Functions */
 
@@ -44,6 +44,7 @@ extern DMA_HandleTypeDef hdma_usart1_tx;
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN PV */
+extern DMA_HandleTypeDef hdma_usart1_rx;
 
 /* USER CODE END PV */
 
@@ -266,6 +267,25 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
     HAL_NVIC_SetPriority(USART1_IRQn, 0, 0);
     HAL_NVIC_EnableIRQ(USART1_IRQn);
     /* USER CODE BEGIN USART1_MspInit 1 */
+    /* USART1_RX Init, circular for the console */
+    hdma_usart1_rx.Instance = DMA2_Channel5;
+    hdma_usart1_rx.Init.Request = DMA_REQUEST_USART1_RX;
+    hdma_usart1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_usart1_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart1_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart1_rx.Init.Mode = DMA_CIRCULAR;
+    hdma_usart1_rx.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_usart1_rx) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(huart,hdmarx,hdma_usart1_rx);
+
+    HAL_NVIC_SetPriority(DMA2_Channel5_IRQn, 15, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Channel5_IRQn);
 
     /* USER CODE END USART1_MspInit 1 */
   }
@@ -323,6 +343,8 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* huart)
     /* USART1 interrupt DeInit */
     HAL_NVIC_DisableIRQ(USART1_IRQn);
     /* USER CODE BEGIN USART1_MspDeInit 1 */
+    HAL_DMA_DeInit(huart->hdmarx);
+    HAL_NVIC_DisableIRQ(DMA2_Channel5_IRQn);
 
     /* USER CODE END USART1_MspDeInit 1 */
   }
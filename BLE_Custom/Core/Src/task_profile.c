@@ -0,0 +1,81 @@
+/**
+  ******************************************************************************
+  * @file           : task_profile.c
+  * @brief          : Sequencer task profile dump.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "task_profile.h"
+#include "app_common.h"
+#include "dbg_trace.h"
+#include "stm32_seq.h"
+
+/* Private variables ---------------------------------------------------------*/
+static const char * const task_names[CFG_TASK_NBR] =
+{
+  [CFG_TASK_ADV_CANCEL_ID] = "ADV_CANCEL",
+#if (L2CAP_REQUEST_NEW_CONN_PARAM != 0 )
+  [CFG_TASK_CONN_UPDATE_REG_ID] = "CONN_UPDATE_REG",
+#endif
+  [CFG_TASK_HCI_ASYNCH_EVT_ID] = "HCI_ASYNCH_EVT",
+  [CFG_TASK_SW1_BUTTON_PUSHED_ID] = "SW1_BUTTON",
+  [CFG_TASK_TELEMETRY_TX_ID] = "TELEMETRY_TX",
+  [CFG_TASK_CONN_POLICY_ID] = "CONN_POLICY",
+  [CFG_TASK_SYSTEM_HCI_ASYNCH_EVT_ID] = "SYSTEM_HCI_EVT",
+  [CFG_TASK_CONSOLE_ID] = "CONSOLE",
+};
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Start the DWT cycle counter and clear the profile. Does nothing
+  *         when the profiler is not built in.
+  */
+void TASK_PROFILE_Init(void)
+{
+  if (UTIL_SEQ_GetTaskProfile(0U) == NULL)
+  {
+    return;
+  }
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  UTIL_SEQ_ResetProfile();
+}
+
+/**
+  * @brief  Print the profile of every task that ran since the last dump,
+  *         then clear it. Prints nothing when the profiler is not built in.
+  */
+void TASK_PROFILE_Dump(void)
+{
+  const UTIL_SEQ_TaskProfile_t *p_profile;
+  uint32_t cycles_per_us = SystemCoreClock / 1000000U;
+  uint32_t id;
+
+  if (UTIL_SEQ_GetTaskProfile(0U) == NULL)
+  {
+    return;
+  }
+
+  APP_DBG_MSG("  Task profile: runs, total ms, avg/max us, avg/max wait us\n\r");
+  for (id = 0U; id < CFG_TASK_NBR; id++)
+  {
+    p_profile = UTIL_SEQ_GetTaskProfile(id);
+    if (p_profile->RunCount == 0U)
+    {
+      continue;
+    }
+    APP_DBG_MSG("  %-16s %8ld %8ld %6ld %6ld %6ld %6ld\n\r",
+                (task_names[id] != NULL) ? task_names[id] : "?",
+                p_profile->RunCount,
+                (uint32_t)(p_profile->TotalCycles / (cycles_per_us * 1000U)),
+                (uint32_t)(p_profile->TotalCycles / p_profile->RunCount / cycles_per_us),
+                p_profile->MaxCycles / cycles_per_us,
+                (uint32_t)(p_profile->TotalLatency / p_profile->RunCount / cycles_per_us),
+                p_profile->MaxLatency / cycles_per_us);
+  }
+  APP_DBG_MSG("  Missed task deadlines: %ld\n\r", UTIL_SEQ_GetDeadlineMissed());
+  UTIL_SEQ_ResetProfile();
+}
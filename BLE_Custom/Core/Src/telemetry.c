@@ -0,0 +1,242 @@
+/**
+  ******************************************************************************
+  * @file           : telemetry.c
+  * @brief          : Telemetry records notified on LONG_C in MTU sized frames.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "telemetry.h"
+#include "app_common.h"
+#include "ble.h"
+#include "custom_stm.h"
+#include "stm32_seq.h"
+#include "utilities_conf.h"
+
+/* Private define ------------------------------------------------------------*/
+/* ATT notification header: opcode and attribute handle */
+#define TELEMETRY_ATT_HEADER      3U
+/* Frames sent per task run before giving the other tasks a turn */
+#define TELEMETRY_TX_BURST        8U
+
+#define TELEMETRY_QUEUE_MASK      (TELEMETRY_QUEUE_SIZE - 1U)
+
+/* Private variables ---------------------------------------------------------*/
+/* Records are appended under a critical section from any context and
+   removed by the TX task only */
+static uint8_t tlm_queue[TELEMETRY_QUEUE_SIZE];
+static volatile uint32_t tlm_head;
+static volatile uint32_t tlm_tail;
+
+/* Frame being sent; kept while the controller has no TX buffer for it */
+static uint8_t tlm_frame[TELEMETRY_FRAME_MAX];
+static uint32_t tlm_frame_len;
+static uint32_t tlm_frame_max = TELEMETRY_DEFAULT_ATT_MTU - TELEMETRY_ATT_HEADER;
+static uint8_t tlm_frame_seq;
+
+static volatile uint8_t tlm_enabled;
+/* Set on BLE_STATUS_INSUFFICIENT_RESOURCES until TELEMETRY_TxReady */
+static volatile uint8_t tlm_blocked;
+
+static TELEMETRY_StatsTypeDef tlm_stats;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Move as many queued records as fit into the next frame.
+  * @retval frame length, 0 if nothing was queued
+  */
+static uint32_t TELEMETRY_Pack(void)
+{
+  uint32_t tail = tlm_tail;
+  uint32_t len = TELEMETRY_FRAME_HEADER;
+  uint32_t rec, i;
+
+  while (tail != tlm_head)
+  {
+    rec = TELEMETRY_RECORD_HEADER + tlm_queue[(tail + 1U) & TELEMETRY_QUEUE_MASK];
+    if ((len + rec) > tlm_frame_max)
+    {
+      if (len != TELEMETRY_FRAME_HEADER)
+      {
+        break;
+      }
+      /* Would not fit even an empty frame at this MTU */
+      tail += rec;
+      tlm_stats.Oversized++;
+      continue;
+    }
+    for (i = 0U; i < rec; i++)
+    {
+      tlm_frame[len++] = tlm_queue[tail++ & TELEMETRY_QUEUE_MASK];
+    }
+  }
+  tlm_tail = tail;
+
+  if (len == TELEMETRY_FRAME_HEADER)
+  {
+    return 0U;
+  }
+  tlm_frame[0] = tlm_frame_seq++;
+  tlm_frame_len = len;
+  return len;
+}
+
+/**
+  * @brief  TX task: notify frames until the queue is empty or the controller
+  *         is out of TX buffers.
+  */
+static void TELEMETRY_Tx(void)
+{
+  tBleStatus ret;
+  uint32_t burst;
+
+  for (burst = 0U; burst < TELEMETRY_TX_BURST; burst++)
+  {
+    if (!tlm_enabled)
+    {
+      return;
+    }
+    if ((tlm_frame_len == 0U) && (TELEMETRY_Pack() == 0U))
+    {
+      return;
+    }
+
+    ret = Custom_STM_App_Notify_Long_C(tlm_frame, (uint8_t)tlm_frame_len);
+    if (ret == BLE_STATUS_INSUFFICIENT_RESOURCES)
+    {
+      /* Keep the frame, TELEMETRY_TxReady resumes once buffers are freed */
+      tlm_blocked = 1U;
+      tlm_stats.PoolFull++;
+      return;
+    }
+    if (ret == BLE_STATUS_SUCCESS)
+    {
+      tlm_stats.Frames++;
+      tlm_stats.Bytes += tlm_frame_len;
+    }
+    else
+    {
+      tlm_stats.Failed++;
+    }
+    tlm_frame_len = 0U;
+  }
+
+  UTIL_SEQ_SetTask(1U << CFG_TASK_TELEMETRY_TX_ID, CFG_SCH_PRIO_1);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Register the TX task. Telemetry stays off until enabled.
+  */
+void TELEMETRY_Init(void)
+{
+  UTIL_SEQ_RegTask(1U << CFG_TASK_TELEMETRY_TX_ID, UTIL_SEQ_RFU, TELEMETRY_Tx);
+}
+
+/**
+  * @brief  Start or stop telemetry, following the LONG_C notification status.
+  *         Stopping discards everything not sent yet. BLE task only.
+  * @param  enable: 1 to start, 0 to stop
+  */
+void TELEMETRY_Enable(uint8_t enable)
+{
+  tlm_enabled = enable;
+  if (!enable)
+  {
+    tlm_tail = tlm_head;
+    tlm_frame_len = 0U;
+    tlm_blocked = 0U;
+  }
+}
+
+/**
+  * @brief  Size frames for the ATT_MTU agreed with the client. BLE task only.
+  * @param  mtu: ATT_MTU
+  */
+void TELEMETRY_SetMtu(uint16_t mtu)
+{
+  tlm_frame_max = MIN((uint32_t)mtu - TELEMETRY_ATT_HEADER, TELEMETRY_FRAME_MAX);
+}
+
+/**
+  * @brief  Queue one record. Safe to call from interrupts.
+  * @param  type: record type
+  * @param  data: record payload
+  * @param  len: payload length, at most TELEMETRY_RECORD_MAX
+  * @retval 1 if queued, 0 if telemetry is off or the queue is full
+  */
+uint8_t TELEMETRY_Put(uint8_t type, const uint8_t *data, uint8_t len)
+{
+  uint32_t head, i;
+
+  if (!tlm_enabled || (len > TELEMETRY_RECORD_MAX))
+  {
+    return 0U;
+  }
+
+  UTILS_ENTER_CRITICAL_SECTION();
+  head = tlm_head;
+  if ((TELEMETRY_QUEUE_SIZE - (head - tlm_tail)) < (TELEMETRY_RECORD_HEADER + len))
+  {
+    tlm_stats.Dropped++;
+    UTILS_EXIT_CRITICAL_SECTION();
+    return 0U;
+  }
+  tlm_queue[head++ & TELEMETRY_QUEUE_MASK] = type;
+  tlm_queue[head++ & TELEMETRY_QUEUE_MASK] = len;
+  for (i = 0U; i < len; i++)
+  {
+    tlm_queue[head++ & TELEMETRY_QUEUE_MASK] = data[i];
+  }
+  tlm_head = head;
+  tlm_stats.Records++;
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  if (!tlm_blocked)
+  {
+    UTIL_SEQ_SetTask(1U << CFG_TASK_TELEMETRY_TX_ID, CFG_SCH_PRIO_1);
+  }
+  return 1U;
+}
+
+/**
+  * @brief  Queue a record made of the current tick and one value byte.
+  *         Safe to call from interrupts.
+  * @param  type: record type
+  * @param  value: value byte
+  */
+void TELEMETRY_PutTicked(uint8_t type, uint8_t value)
+{
+  uint32_t tick = HAL_GetTick();
+  uint8_t rec[5];
+
+  rec[0] = (uint8_t)tick;
+  rec[1] = (uint8_t)(tick >> 8);
+  rec[2] = (uint8_t)(tick >> 16);
+  rec[3] = (uint8_t)(tick >> 24);
+  rec[4] = value;
+  (void)TELEMETRY_Put(type, rec, sizeof(rec));
+}
+
+/**
+  * @brief  The controller released TX buffers (ACI_GATT_TX_POOL_AVAILABLE or
+  *         notification complete): resume sending.
+  */
+void TELEMETRY_TxReady(void)
+{
+  tlm_blocked = 0U;
+  if (tlm_enabled)
+  {
+    UTIL_SEQ_SetTask(1U << CFG_TASK_TELEMETRY_TX_ID, CFG_SCH_PRIO_1);
+  }
+}
+
+/**
+  * @brief  Telemetry counters.
+  */
+const TELEMETRY_StatsTypeDef *TELEMETRY_GetStats(void)
+{
+  return &tlm_stats;
+}
@@ -88,6 +88,24 @@ extern "C" {
    */
   void SVCCTL_RegisterSvcHandler( SVC_CTL_p_EvtHandler_t pfBLE_SVC_Service_Event_Handler );
 
+  /**
+   * @brief  This API binds the attribute handles of a Service to its handler. A GATT event on a local attribute
+   *         (attribute modified, read/write/prepare write permit request, notification complete) is then reported
+   *         only to the handler owning the handle, found by a binary search over the registered ranges, so the
+   *         dispatch cost does not grow with the number of Services. GATT events without an attribute handle are
+   *         still reported to every Service handler.
+   *         It shall be called once the Service and its characteristics are added. A handler already registered
+   *         with SVCCTL_RegisterSvcHandler() is moved to the range; if the range is invalid, overlaps another one
+   *         or BLE_CFG_SVC_MAX_NBR_CB ranges are registered, the handler keeps receiving every GATT event.
+   *
+   * @param  StartHandle: Service declaration handle
+   * @param  EndHandle: Last handle of the Service (StartHandle + Max_Attribute_Records - 1)
+   * @param  pfBLE_SVC_Service_Event_Handler: This is the Service handler that the ble_controller calls to report a
+   *         GATT event on one of the handles
+   * @retval None
+   */
+  void SVCCTL_RegisterSvcHandleRange( uint16_t StartHandle, uint16_t EndHandle, SVC_CTL_p_EvtHandler_t pfBLE_SVC_Service_Event_Handler );
+
   /**
    * @brief  This API registers a handler to be called when a GATT user event is received from the BLE core device. When
    *         a Client is created, it shall register a callback to be notified when a GATT event is received from the
@@ -38,6 +38,21 @@ SVC_CTL_p_EvtHandler_t SVCCTL_CltHandlerTable[BLE_CFG_CLT_MAX_NBR_CB];
 uint8_t NbreOfRegisteredHandler;
 } SVCCTL_CltHandler_t;
 
+typedef struct
+{
+uint16_t StartHandle;
+uint16_t EndHandle;
+SVC_CTL_p_EvtHandler_t pfHandler;
+} SVCCTL_HandleRange_t;
+
+typedef struct
+{
+#if (BLE_CFG_SVC_MAX_NBR_CB > 0)
+SVCCTL_HandleRange_t SVCCTL_RangeTab[BLE_CFG_SVC_MAX_NBR_CB];  /* Sorted by StartHandle, no overlap */
+#endif
+uint8_t NbreOfRegisteredRange;
+} SVCCTL_RangeHandler_t;
+
 /* Private defines -----------------------------------------------------------*/
 #define SVCCTL_EGID_EVT_MASK   0xFF00
 #define SVCCTL_GATT_EVT_TYPE   0x0C00
@@ -51,12 +66,84 @@ uint8_t NbreOfRegisteredHandler;
 
 PLACE_IN_SECTION("BLE_DRIVER_CONTEXT") SVCCTL_EvtHandler_t SVCCTL_EvtHandler;
 PLACE_IN_SECTION("BLE_DRIVER_CONTEXT") SVCCTL_CltHandler_t SVCCTL_CltHandler;
+PLACE_IN_SECTION("BLE_DRIVER_CONTEXT") SVCCTL_RangeHandler_t SVCCTL_RangeHandler;
 
 /**
  * END of Section BLE_DRIVER_CONTEXT
  */
 
 /* Private functions ----------------------------------------------------------*/
+#if (BLE_CFG_SVC_MAX_NBR_CB > 0)
+/**
+ * @brief  Get the local attribute handle a GATT server event refers to
+ * @param  blecore_evt: GATT event
+ * @param  p_handle: attribute handle found
+ * @retval 1 when the event carries a local attribute handle, 0 otherwise
+ */
+static uint8_t SVCCTL_GetAttrHandle( evt_blecore_aci *blecore_evt, uint16_t *p_handle )
+{
+  switch (blecore_evt->ecode)
+  {
+    case ACI_GATT_ATTRIBUTE_MODIFIED_VSEVT_CODE:
+      *p_handle = ((aci_gatt_attribute_modified_event_rp0*)blecore_evt->data)->Attr_Handle;
+      return 1;
+
+    case ACI_GATT_READ_PERMIT_REQ_VSEVT_CODE:
+      *p_handle = ((aci_gatt_read_permit_req_event_rp0*)blecore_evt->data)->Attribute_Handle;
+      return 1;
+
+    case ACI_GATT_WRITE_PERMIT_REQ_VSEVT_CODE:
+      *p_handle = ((aci_gatt_write_permit_req_event_rp0*)blecore_evt->data)->Attribute_Handle;
+      return 1;
+
+    case ACI_GATT_PREPARE_WRITE_PERMIT_REQ_VSEVT_CODE:
+      *p_handle = ((aci_gatt_prepare_write_permit_req_event_rp0*)blecore_evt->data)->Attribute_Handle;
+      return 1;
+
+    case ACI_GATT_NOTIFICATION_COMPLETE_VSEVT_CODE:
+      *p_handle = ((aci_gatt_notification_complete_event_rp0*)blecore_evt->data)->Attr_Handle;
+      return 1;
+
+    default:
+      /**
+       * No handle, several handles (read multiple) or a handle of the remote server (client events)
+       */
+      return 0;
+  }
+}
+
+/**
+ * @brief  Find the handler owning an attribute handle
+ * @param  handle: attribute handle
+ * @retval Handler of the range holding the handle, NULL when there is none
+ */
+static SVC_CTL_p_EvtHandler_t SVCCTL_FindRange( uint16_t handle )
+{
+  uint8_t low = 0;
+  uint8_t high = SVCCTL_RangeHandler.NbreOfRegisteredRange;
+  uint8_t mid;
+
+  while (low < high)
+  {
+    mid = (low + high) / 2;
+    if (handle < SVCCTL_RangeHandler.SVCCTL_RangeTab[mid].StartHandle)
+    {
+      high = mid;
+    }
+    else if (handle > SVCCTL_RangeHandler.SVCCTL_RangeTab[mid].EndHandle)
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      return SVCCTL_RangeHandler.SVCCTL_RangeTab[mid].pfHandler;
+    }
+  }
+
+  return NULL;
+}
+#endif
+
 /* Weak functions ----------------------------------------------------------*/
 void BVOPUS_STM_Init(void);
 
@@ -144,6 +231,7 @@ void SVCCTL_Init( void )
    */
   SVCCTL_EvtHandler.NbreOfRegisteredHandler = 0;
   SVCCTL_CltHandler.NbreOfRegisteredHandler = 0;
+  SVCCTL_RangeHandler.NbreOfRegisteredRange = 0;
 
   /**
    * Add and Initialize requested services
@@ -211,6 +299,75 @@ void SVCCTL_RegisterSvcHandler( SVC_CTL_p_EvtHandler_t pfBLE_SVC_Service_Event_H
   return;
 }
 
+/**
+ * @brief  Bind a range of attribute handles to a Service handler
+ * @param  StartHandle: first handle of the range (the service declaration)
+ * @param  EndHandle: last handle of the range
+ * @param  pfBLE_SVC_Service_Event_Handler: Service handler
+ * @retval None
+ */
+void SVCCTL_RegisterSvcHandleRange( uint16_t StartHandle, uint16_t EndHandle, SVC_CTL_p_EvtHandler_t pfBLE_SVC_Service_Event_Handler )
+{
+#if (BLE_CFG_SVC_MAX_NBR_CB > 0)
+  uint8_t index;
+  uint8_t pos;
+
+  if ((StartHandle == 0) || (EndHandle < StartHandle) ||
+      (SVCCTL_RangeHandler.NbreOfRegisteredRange >= BLE_CFG_SVC_MAX_NBR_CB))
+  {
+    /**
+     * The handler, if already registered, keeps receiving every GATT event
+     */
+    return;
+  }
+
+  /**
+   * Keep the table sorted, refuse overlapping ranges
+   */
+  pos = 0;
+  while ((pos < SVCCTL_RangeHandler.NbreOfRegisteredRange) &&
+         (SVCCTL_RangeHandler.SVCCTL_RangeTab[pos].EndHandle < StartHandle))
+  {
+    pos++;
+  }
+  if ((pos < SVCCTL_RangeHandler.NbreOfRegisteredRange) &&
+      (SVCCTL_RangeHandler.SVCCTL_RangeTab[pos].StartHandle <= EndHandle))
+  {
+    return;
+  }
+  for (index = SVCCTL_RangeHandler.NbreOfRegisteredRange; index > pos; index--)
+  {
+    SVCCTL_RangeHandler.SVCCTL_RangeTab[index] = SVCCTL_RangeHandler.SVCCTL_RangeTab[index - 1];
+  }
+  SVCCTL_RangeHandler.SVCCTL_RangeTab[pos].StartHandle = StartHandle;
+  SVCCTL_RangeHandler.SVCCTL_RangeTab[pos].EndHandle = EndHandle;
+  SVCCTL_RangeHandler.SVCCTL_RangeTab[pos].pfHandler = pfBLE_SVC_Service_Event_Handler;
+  SVCCTL_RangeHandler.NbreOfRegisteredRange++;
+
+  /**
+   * A handler registered with SVCCTL_RegisterSvcHandler() is no longer called for every GATT event
+   */
+  for (index = 0; index < SVCCTL_EvtHandler.NbreOfRegisteredHandler; index++)
+  {
+    if (SVCCTL_EvtHandler.SVCCTL__SvcHandlerTab[index] == pfBLE_SVC_Service_Event_Handler)
+    {
+      SVCCTL_EvtHandler.NbreOfRegisteredHandler--;
+      for (; index < SVCCTL_EvtHandler.NbreOfRegisteredHandler; index++)
+      {
+        SVCCTL_EvtHandler.SVCCTL__SvcHandlerTab[index] = SVCCTL_EvtHandler.SVCCTL__SvcHandlerTab[index + 1];
+      }
+      break;
+    }
+  }
+#else
+  (void)(StartHandle);
+  (void)(EndHandle);
+  (void)(pfBLE_SVC_Service_Event_Handler);
+#endif
+
+  return;
+}
+
 /**
  * @brief  BLE Controller initialization
  * @param  None
@@ -235,6 +392,10 @@ __WEAK SVCCTL_UserEvtFlowStatus_t SVCCTL_UserEvtRx( void *pckt )
   SVCCTL_EvtAckStatus_t event_notification_status;
   SVCCTL_UserEvtFlowStatus_t return_status;
   uint8_t index;
+#if (BLE_CFG_SVC_MAX_NBR_CB > 0)
+  SVC_CTL_p_EvtHandler_t p_range_handler;
+  uint16_t attr_handle;
+#endif
 
   event_pckt = (hci_event_pckt*) ((hci_uart_pckt *) pckt)->data;
   event_notification_status = SVCCTL_EvtNotAck;
@@ -249,8 +410,34 @@ __WEAK SVCCTL_UserEvtFlowStatus_t SVCCTL_UserEvtRx( void *pckt )
       {
         case SVCCTL_GATT_EVT_TYPE:
 #if (BLE_CFG_SVC_MAX_NBR_CB > 0)
+          /**
+           * An event on a local attribute goes straight to the Service owning its handle
+           */
+          if (SVCCTL_GetAttrHandle(blecore_evt, &attr_handle) != 0)
+          {
+            p_range_handler = SVCCTL_FindRange(attr_handle);
+            if (p_range_handler != NULL)
+            {
+              event_notification_status = p_range_handler(pckt);
+            }
+          }
+          else
+          {
+            /**
+             * Events without a handle are offered to every Service
+             */
+            for (index = 0; index < SVCCTL_RangeHandler.NbreOfRegisteredRange; index++)
+            {
+              event_notification_status = SVCCTL_RangeHandler.SVCCTL_RangeTab[index].pfHandler(pckt);
+              if (event_notification_status != SVCCTL_EvtNotAck)
+              {
+                break;
+              }
+            }
+          }
+
           /* For Service event handler */
-          for (index = 0; index < SVCCTL_EvtHandler.NbreOfRegisteredHandler; index++)
+          for (index = 0; (index < SVCCTL_EvtHandler.NbreOfRegisteredHandler) && (event_notification_status == SVCCTL_EvtNotAck); index++)
           {
             event_notification_status = SVCCTL_EvtHandler.SVCCTL__SvcHandlerTab[index](pckt);
             /**
@@ -32,6 +32,15 @@ typedef enum
   HCI_TL_CMD_RESP_WAIT,
 } HCI_TL_CmdRespStatus_t;
 
+typedef struct
+{
+  uint16_t opcode;
+  uint8_t plen;
+  uint8_t param[BLE_CMD_MAX_PARAM_LEN];
+  HCI_TL_CmdCallback_t p_callback;
+  void *p_ctx;
+} HCI_TL_AsyncCmd_t;
+
 /* Private defines -----------------------------------------------------------*/
 
 /**
@@ -39,6 +48,28 @@ typedef enum
  */
 #define HCI_TL_DEFAULT_TIMEOUT (33000)
 
+/**
+ * Most asynchronous events reported per hci_user_evt_proc() run. 1 keeps the one event per run behavior.
+ */
+#ifndef CFG_TLBLE_EVT_BATCH_MAX
+#define CFG_TLBLE_EVT_BATCH_MAX (1)
+#endif
+
+/**
+ * Time after which a run stops reporting events even when CFG_TLBLE_EVT_BATCH_MAX is not reached, in us.
+ * It is measured with the DWT cycle counter; 0 disables the budget.
+ */
+#ifndef CFG_TLBLE_EVT_BATCH_BUDGET_US
+#define CFG_TLBLE_EVT_BATCH_BUDGET_US (0)
+#endif
+
+/**
+ * Number of commands hci_send_req_async() can hold. 0 removes the asynchronous path.
+ */
+#ifndef CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH
+#define CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH (0)
+#endif
+
 /* Private macros ------------------------------------------------------------*/
 /* Public variables ---------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
@@ -57,12 +88,29 @@ static tHciContext hciContext;
 static tListNode HciCmdEventQueue;
 static void (* StatusNotCallBackFunction) (HCI_TL_CmdStatus_t status);
 static volatile HCI_TL_CmdRespStatus_t CmdRspStatusFlag;
+static volatile HCI_TL_EvtStats_t HciEvtStats;
+
+#if (CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH > 0)
+/**
+ * Commands of hci_send_req_async(), sent one at a time from the head. Only accessed from the background
+ */
+static HCI_TL_AsyncCmd_t AsyncCmdQueue[CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH];
+static uint8_t AsyncCmdHead;
+static uint8_t AsyncCmdCount;
+static volatile uint8_t AsyncCmdInFlight;
+static uint8_t SyncCmdBusy;
+#endif
 
 /* Private function prototypes -----------------------------------------------*/
 static void NotifyCmdStatus(HCI_TL_CmdStatus_t hcicmdstatus);
 static void SendCmd(uint16_t opcode, uint8_t plen, void *param);
 static void TlEvtReceived(TL_EvtPacket_t *hcievt);
 static void TlInit( TL_CmdPacket_t * p_cmdbuffer );
+static void AsynchEvtDepthUpdate( int8_t delta );
+#if (CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH > 0)
+static void AsyncCmdSendNext( void );
+static void AsyncCmdProc( void );
+#endif
 
 /* Interface ------- ---------------------------------------------------------*/
 void hci_init(void(* UserEvtRx)(void* pData), void* pConf)
@@ -81,15 +129,21 @@ void hci_user_evt_proc(void)
 {
   TL_EvtPacket_t *phcievtbuffer;
   tHCI_UserEvtRxParam UserEvtRxParam;
+  uint16_t evt_count;
+#if (CFG_TLBLE_EVT_BATCH_BUDGET_US > 0)
+  uint32_t start_cycles;
+  uint32_t budget_cycles;
+#endif
 
   /**
    * Up to release version v1.2.0, a while loop was implemented to read out events from the queue as long as
    * it is not empty. However, in a bare metal implementation, this leads to calling in a "blocking" mode
    * hci_user_evt_proc() as long as events are received without giving the opportunity to run other tasks
    * in the background.
-   * From now, the events are reported one by one. When it is checked there is still an event pending in the queue,
+   * From now, the events are reported by batches of at most CFG_TLBLE_EVT_BATCH_MAX, and a batch is cut short
+   * once CFG_TLBLE_EVT_BATCH_BUDGET_US is spent. When it is checked there is still an event pending in the queue,
    * a request to the user is made to call again hci_user_evt_proc().
-   * This gives the opportunity to the application to run other background tasks between each event.
+   * This gives the opportunity to the application to run other background tasks between each batch.
    */
 
   /**
@@ -97,9 +151,35 @@ void hci_user_evt_proc(void)
    * in case the user overwrite the header where the next/prev pointers are located
    */
 
-  if((LST_is_empty(&HciAsynchEventQueue) == FALSE) && (UserEventFlow != HCI_TL_UserEventFlow_Disable))
+#if (CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH > 0)
+  /**
+   * Complete the asynchronous command answered since the last run and send the next one
+   */
+  AsyncCmdProc();
+#endif
+
+#if (CFG_TLBLE_EVT_BATCH_BUDGET_US > 0)
+  start_cycles = DWT->CYCCNT;
+  budget_cycles = CFG_TLBLE_EVT_BATCH_BUDGET_US * (SystemCoreClock / 1000000);
+#endif
+
+  evt_count = 0;
+  while((evt_count < CFG_TLBLE_EVT_BATCH_MAX) &&
+        (LST_is_empty(&HciAsynchEventQueue) == FALSE) && (UserEventFlow != HCI_TL_UserEventFlow_Disable))
   {
+#if (CFG_TLBLE_EVT_BATCH_BUDGET_US > 0)
+    /**
+     * At least one event is reported per run
+     */
+    if((evt_count != 0) && ((DWT->CYCCNT - start_cycles) >= budget_cycles))
+    {
+      HciEvtStats.BudgetCount++;
+      break;
+    }
+#endif
+
     LST_remove_head ( &HciAsynchEventQueue, (tListNode **)&phcievtbuffer );
+    AsynchEvtDepthUpdate(-1);
 
     if (hciContext.UserEvtRx != NULL)
     {
@@ -116,6 +196,7 @@ void hci_user_evt_proc(void)
     if(UserEventFlow != HCI_TL_UserEventFlow_Disable)
     {
       TL_MM_EvtDone( phcievtbuffer );
+      evt_count++;
     }
     else
     {
@@ -123,6 +204,17 @@ void hci_user_evt_proc(void)
        * put back the event in the queue
        */
       LST_insert_head ( &HciAsynchEventQueue, (tListNode *)phcievtbuffer );
+      AsynchEvtDepthUpdate(1);
+    }
+  }
+
+  if(evt_count != 0)
+  {
+    HciEvtStats.EvtCount += evt_count;
+    HciEvtStats.PassCount++;
+    if(evt_count > HciEvtStats.BatchMax)
+    {
+      HciEvtStats.BatchMax = evt_count;
     }
   }
 
@@ -161,6 +253,18 @@ int hci_send_req(struct hci_request *p_cmd, uint8_t async)
   NotifyCmdStatus(HCI_TL_CmdBusy);
   local_cmd_status = HCI_TL_CmdBusy;
   opcode = ((p_cmd->ocf) & 0x03ff) | ((p_cmd->ogf) << 10);
+
+#if (CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH > 0)
+  /**
+   * The command buffer is shared: wait for the asynchronous command in flight to be answered first
+   */
+  SyncCmdBusy = 1;
+  while(AsyncCmdInFlight != 0)
+  {
+    hci_cmd_resp_wait(HCI_TL_DEFAULT_TIMEOUT);
+    AsyncCmdProc();
+  }
+#endif
   
   CmdRspStatusFlag = HCI_TL_CMD_RESP_WAIT;
   SendCmd(opcode, p_cmd->clen, p_cmd->cparam);
@@ -210,9 +314,53 @@ int hci_send_req(struct hci_request *p_cmd, uint8_t async)
 
   NotifyCmdStatus(HCI_TL_CmdAvailable);
 
+#if (CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH > 0)
+  SyncCmdBusy = 0;
+  AsyncCmdSendNext();
+#endif
+
   return 0;
 }
 
+int hci_send_req_async(uint16_t ogf, uint16_t ocf, const void *p_cparam, uint8_t clen,
+                       HCI_TL_CmdCallback_t p_callback, void *p_ctx)
+{
+#if (CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH > 0)
+  HCI_TL_AsyncCmd_t *p_slot;
+
+  if((AsyncCmdCount >= CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH) || (clen > BLE_CMD_MAX_PARAM_LEN))
+  {
+    return -1;
+  }
+
+  p_slot = &AsyncCmdQueue[(AsyncCmdHead + AsyncCmdCount) % CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH];
+  p_slot->opcode = (ocf & 0x03ff) | (ogf << 10);
+  p_slot->plen = clen;
+  memcpy(p_slot->param, p_cparam, clen);
+  p_slot->p_callback = p_callback;
+  p_slot->p_ctx = p_ctx;
+  AsyncCmdCount++;
+
+  AsyncCmdSendNext();
+
+  return 0;
+#else
+  (void)ogf;
+  (void)ocf;
+  (void)p_cparam;
+  (void)clen;
+  (void)p_callback;
+  (void)p_ctx;
+
+  return -1;
+#endif
+}
+
+const HCI_TL_EvtStats_t *hci_get_evt_stats( void )
+{
+  return (const HCI_TL_EvtStats_t *)&HciEvtStats;
+}
+
 /* Private functions ---------------------------------------------------------*/
 static void TlInit( TL_CmdPacket_t * p_cmdbuffer )
 {
@@ -226,9 +374,24 @@ static void TlInit( TL_CmdPacket_t * p_cmdbuffer )
   pCmdBuffer = p_cmdbuffer;
 
   LST_init_head (&HciAsynchEventQueue);
+  memset((void *)&HciEvtStats, 0, sizeof(HciEvtStats));
+#if (CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH > 0)
+  AsyncCmdHead = 0;
+  AsyncCmdCount = 0;
+  AsyncCmdInFlight = 0;
+  SyncCmdBusy = 0;
+#endif
 
   UserEventFlow = HCI_TL_UserEventFlow_Enable;
 
+#if (CFG_TLBLE_EVT_BATCH_BUDGET_US > 0)
+  /**
+   * The batch budget is measured with the DWT cycle counter
+   */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
   /* Initialize low level driver */
   if (hciContext.io.Init)
   {
@@ -278,16 +441,116 @@ static void TlEvtReceived(TL_EvtPacket_t *hcievt)
   {
     LST_insert_tail(&HciCmdEventQueue, (tListNode *)hcievt);
     hci_cmd_resp_release(0); /**< Notify the application a full Cmd Event has been received */
+#if (CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH > 0)
+    if(AsyncCmdInFlight != 0)
+    {
+      hci_notify_asynch_evt((void*) &HciAsynchEventQueue); /**< The answer is processed in hci_user_evt_proc() */
+    }
+#endif
   }
   else
   {
     LST_insert_tail(&HciAsynchEventQueue, (tListNode *)hcievt);
+    AsynchEvtDepthUpdate(1);
     hci_notify_asynch_evt((void*) &HciAsynchEventQueue); /**< Notify the application a full HCI event has been received */
   }
 
   return;
 }
 
+#if (CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH > 0)
+static void AsyncCmdSendNext( void )
+{
+  HCI_TL_AsyncCmd_t *p_slot;
+
+  if((AsyncCmdInFlight != 0) || (SyncCmdBusy != 0) || (AsyncCmdCount == 0))
+  {
+    return;
+  }
+
+  p_slot = &AsyncCmdQueue[AsyncCmdHead];
+  AsyncCmdInFlight = 1;
+  SendCmd(p_slot->opcode, p_slot->plen, p_slot->param);
+
+  return;
+}
+
+static void AsyncCmdProc( void )
+{
+  TL_EvtPacket_t *pevtpacket;
+  TL_CsEvt_t *pcommand_status_event;
+  TL_CcEvt_t *pcommand_complete_event;
+  HCI_TL_AsyncCmd_t *p_slot;
+  const uint8_t *p_rparam;
+  uint8_t rlen;
+  uint8_t numcmd;
+
+  while((AsyncCmdInFlight != 0) && (LST_is_empty(&HciCmdEventQueue) == FALSE))
+  {
+    LST_remove_head (&HciCmdEventQueue, (tListNode **)&pevtpacket);
+
+    p_slot = &AsyncCmdQueue[AsyncCmdHead];
+    p_rparam = NULL;
+    rlen = 0;
+
+    if(pevtpacket->evtserial.evt.evtcode == TL_BLEEVT_CS_OPCODE)
+    {
+      pcommand_status_event = (TL_CsEvt_t*)pevtpacket->evtserial.evt.payload;
+      if(pcommand_status_event->cmdcode == p_slot->opcode)
+      {
+        p_rparam = &pcommand_status_event->status;
+        rlen = 1;
+      }
+      numcmd = pcommand_status_event->numcmd;
+    }
+    else
+    {
+      pcommand_complete_event = (TL_CcEvt_t*)pevtpacket->evtserial.evt.payload;
+      if(pcommand_complete_event->cmdcode == p_slot->opcode)
+      {
+        p_rparam = pcommand_complete_event->payload;
+        rlen = pevtpacket->evtserial.evt.plen - TL_EVT_HDR_SIZE;
+      }
+      numcmd = pcommand_complete_event->numcmd;
+    }
+
+    if(numcmd != 0)
+    {
+      AsyncCmdHead = (AsyncCmdHead + 1) % CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH;
+      AsyncCmdCount--;
+      /**
+       * The return parameters are read in the command buffer: the next command is sent once the callback returns
+       */
+      if(p_slot->p_callback != NULL)
+      {
+        p_slot->p_callback(p_slot->opcode, p_rparam, rlen, p_slot->p_ctx);
+      }
+      AsyncCmdInFlight = 0;
+    }
+  }
+
+  AsyncCmdSendNext();
+
+  return;
+}
+#endif
+
+static void AsynchEvtDepthUpdate( int8_t delta )
+{
+  uint32_t primask_bit;
+
+  primask_bit = __get_PRIMASK();  /**< backup PRIMASK bit */
+  __disable_irq();                  /**< Disable all interrupts by setting PRIMASK bit on Cortex*/
+  HciEvtStats.QueueDepth += delta;
+  if(HciEvtStats.QueueDepth > HciEvtStats.QueueDepthMax)
+  {
+    HciEvtStats.QueueDepthMax = HciEvtStats.QueueDepth;
+  }
+  __set_PRIMASK(primask_bit);     /**< Restore PRIMASK bit*/
+
+  return;
+}
+
 /* Weak implementation ----------------------------------------------------------------*/
 __WEAK void hci_cmd_resp_wait(uint32_t timeout)
 {
@@ -82,6 +82,33 @@ typedef struct
   void (* StatusNotCallBack) (HCI_TL_CmdStatus_t status);
 } HCI_TL_HciInitConf_t;
 
+/**
+ * @brief Completion callback of hci_send_req_async()
+ *        opcode: opcode of the command
+ *        p_rparam: return parameters of the command complete event, or the status of the command status event
+ *                  (NULL when the answer does not match the command)
+ *        rlen: length of p_rparam
+ *        p_ctx: context given to hci_send_req_async()
+ */
+typedef void (* HCI_TL_CmdCallback_t) (uint16_t opcode, const uint8_t *p_rparam, uint8_t rlen, void *p_ctx);
+
+/**
+ * @brief Counters of the asynchronous event processing, see hci_get_evt_stats()
+ * @{
+ */
+typedef struct
+{
+  uint32_t EvtCount;      /**< Asynchronous events reported to the application */
+  uint32_t PassCount;     /**< hci_user_evt_proc() runs that reported at least one event */
+  uint32_t BudgetCount;   /**< Runs cut short by CFG_TLBLE_EVT_BATCH_BUDGET_US */
+  uint16_t QueueDepth;    /**< Asynchronous events currently queued */
+  uint16_t QueueDepthMax; /**< High-water mark of QueueDepth */
+  uint16_t BatchMax;      /**< Most events reported in one hci_user_evt_proc() run */
+} HCI_TL_EvtStats_t;
+/**
+ * @}
+ */
+
 /**
  * @brief  Register IO bus services.
  * @param  fops The HCI IO structure managing the IO BUS
@@ -160,6 +187,34 @@ void hci_cmd_resp_release(uint32_t flag);
 
 void hci_user_evt_proc(void);
 
+/**
+ * @brief  Counters of the asynchronous event processing. They may be read from any context; a field updated
+ *         by an interrupt while it is read may be one event off
+ *
+ * @param  None
+ * @retval Pointer to the counters
+ */
+const HCI_TL_EvtStats_t *hci_get_evt_stats( void );
+
+/**
+ * @brief  Queue a command without waiting for its answer. The commands are sent one at a time, in order, as the
+ *         previous one is answered; the answers are processed in hci_user_evt_proc() which calls p_callback.
+ *         A synchronous command (hci_send_req()) waits for the asynchronous command in flight, then goes before
+ *         the queued ones.
+ *         Background only. The callback may queue commands but shall not send a synchronous one.
+ *         The queue length is set with CFG_TLBLE_ASYNC_CMD_QUEUE_LENGTH (0 by default).
+ *
+ * @param  ogf: Opcode group field
+ * @param  ocf: Opcode command field
+ * @param  p_cparam: Command parameters, copied before returning
+ * @param  clen: Length of the command parameters
+ * @param  p_callback: Called with the answer, may be NULL
+ * @param  p_ctx: Passed to p_callback
+ * @retval 0 when queued, -1 when the queue is full
+ */
+int hci_send_req_async(uint16_t ogf, uint16_t ocf, const void *p_cparam, uint8_t clen,
+                       HCI_TL_CmdCallback_t p_callback, void *p_ctx);
+
 /**
  * END OF SECTION - PROCESS TO BE CALLED BY THE SCHEDULER
  *********************************************************************************************************************
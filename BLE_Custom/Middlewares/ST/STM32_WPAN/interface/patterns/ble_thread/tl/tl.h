@@ -181,6 +181,20 @@ typedef struct
   uint32_t TracesEvtPoolSize;
 } TL_MM_Config_t;
 
+/**
+ * Latency of the BLE asynchronous events, from HW_IPCC_BLE_RxEvtNot() to TL_MM_EvtDone()
+ * Hist[0] counts latencies below 1us, Hist[n] latencies in [2^(n-1), 2^n) us, the last bin everything above
+ */
+#define TL_EVT_LATENCY_BINS   16
+
+typedef struct
+{
+  uint32_t Count;                       /**< Events measured */
+  uint32_t MaxUs;                       /**< Longest latency */
+  uint32_t Untracked;                   /**< Events not measured, no free time stamp slot */
+  uint32_t Hist[TL_EVT_LATENCY_BINS];
+} TL_EvtLatencyStats_t;
+
 typedef struct
 {
   uint8_t *p_ThreadOtCmdRspBuffer;
@@ -337,6 +351,8 @@ void TL_BLE_LLD_SendRspAck( void );
  ******************************************************************************/
 void TL_MM_Init( TL_MM_Config_t *p_Config );
 void TL_MM_EvtDone( TL_EvtPacket_t * hcievt );
+const TL_EvtLatencyStats_t * TL_MM_GetEvtLatency( void );
+void TL_MM_ResetEvtLatency( void );
 
 /******************************************************************************
  * TRACES
@@ -40,6 +40,25 @@ typedef enum
 } TL_MB_PacketType_t;
 
 /* Private defines -----------------------------------------------------------*/
+/**
+ * Number of released buffers TL_MM_EvtDone() can hold before they are handed over to CPU2 (power of 2).
+ * Buffers released beyond that go through the LocalFreeBufQueue list
+ */
+#ifndef CFG_TL_MM_FREE_RING_SIZE
+#define CFG_TL_MM_FREE_RING_SIZE    (32)
+#endif
+
+/**
+ * Set to 1 to measure the latency of the BLE asynchronous events with the DWT cycle counter
+ */
+#ifndef CFG_TL_EVT_LATENCY_STATS
+#define CFG_TL_EVT_LATENCY_STATS    (0)
+#endif
+/**
+ * Number of BLE asynchronous events that can be measured at the same time
+ */
+#define TL_EVT_LATENCY_SLOTS        (32)
+
 /* Private macros ------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 
@@ -65,6 +84,21 @@ PLACE_IN_SECTION("MB_MEM1") ALIGN(4) static tListNode  SystemEvtQueue;
 
 
 static tListNode  LocalFreeBufQueue;
+
+/**
+ * Released buffers waiting for the release channel. Single producer, TL_MM_EvtDone() in the background,
+ * single consumer, SendFreeBuf() called either from TL_MM_EvtDone() when the channel is free or from the
+ * channel free interrupt, never both at once
+ */
+static tListNode * LocalFreeBufRing[CFG_TL_MM_FREE_RING_SIZE];
+static volatile uint32_t LocalFreeBufRingHead;
+static volatile uint32_t LocalFreeBufRingTail;
+
+#if (CFG_TL_EVT_LATENCY_STATS != 0)
+static TL_EvtPacket_t * EvtLatencyPacket[TL_EVT_LATENCY_SLOTS];
+static uint32_t EvtLatencyStamp[TL_EVT_LATENCY_SLOTS];
+static TL_EvtLatencyStats_t EvtLatencyStats;
+#endif
 static void (* BLE_IoBusEvtCallBackFunction) (TL_EvtPacket_t *phcievt);
 static void (* BLE_IoBusAclDataTxAck) ( void );
 static void (* SYS_CMD_IoBusCallBackFunction) (TL_EvtPacket_t *phcievt);
@@ -75,6 +109,10 @@ static void (* SYS_EVT_IoBusCallBackFunction) (TL_EvtPacket_t *phcievt);
 /* Private function prototypes -----------------------------------------------*/
 static void SendFreeBuf( void );
 static void OutputDbgTrace(TL_MB_PacketType_t packet_type, uint8_t* buffer);
+#if (CFG_TL_EVT_LATENCY_STATS != 0)
+static void EvtLatencyStart( TL_EvtPacket_t * phcievt );
+static void EvtLatencyStop( TL_EvtPacket_t * phcievt );
+#endif
 
 /* Public Functions Definition ------------------------------------------------------*/
 
@@ -149,10 +187,24 @@ int32_t TL_BLE_SendCmd( uint8_t* buffer, uint16_t size )
 void HW_IPCC_BLE_RxEvtNot(void)
 {
   TL_EvtPacket_t *phcievt;
+  tListNode *p_node;
+  tListNode *p_next;
+
+  /**
+   * CPU2 does not access EvtQueue until the channel is cleared on return, and this interrupt is the only
+   * reader on CPU1: the whole list is taken at once, without masking interrupts for each event
+   */
+  p_node = EvtQueue.next;
+  EvtQueue.next = &EvtQueue;
+  EvtQueue.prev = &EvtQueue;
 
-  while(LST_is_empty(&EvtQueue) == FALSE)
+  while(p_node != &EvtQueue)
   {
-    LST_remove_head (&EvtQueue, (tListNode **)&phcievt);
+    /**
+     * The callback links the packet into another list
+     */
+    p_next = p_node->next;
+    phcievt = (TL_EvtPacket_t *)p_node;
 
     if ( ((phcievt->evtserial.evt.evtcode) == TL_BLEEVT_CS_OPCODE) || ((phcievt->evtserial.evt.evtcode) == TL_BLEEVT_CC_OPCODE ) )
     {
@@ -161,9 +213,13 @@ void HW_IPCC_BLE_RxEvtNot(void)
     else
     {
       OutputDbgTrace(TL_MB_BLE_ASYNCH_EVT, (uint8_t*)phcievt);
+#if (CFG_TL_EVT_LATENCY_STATS != 0)
+      EvtLatencyStart(phcievt);
+#endif
     }
 
     BLE_IoBusEvtCallBackFunction(phcievt);
+    p_node = p_next;
   }
 
   return;
@@ -600,6 +656,15 @@ void TL_MM_Init( TL_MM_Config_t *p_Config )
 
   LST_init_head (&FreeBufQueue);
   LST_init_head (&LocalFreeBufQueue);
+  LocalFreeBufRingHead = 0;
+  LocalFreeBufRingTail = 0;
+
+#if (CFG_TL_EVT_LATENCY_STATS != 0)
+  memset(EvtLatencyPacket, 0, sizeof(EvtLatencyPacket));
+  TL_MM_ResetEvtLatency();
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
 
   p_mem_manager_table = TL_RefTable.p_mem_manager_table;
 
@@ -616,7 +681,23 @@ void TL_MM_Init( TL_MM_Config_t *p_Config )
 
 void TL_MM_EvtDone(TL_EvtPacket_t * phcievt)
 {
-  LST_insert_tail(&LocalFreeBufQueue, (tListNode *)phcievt);
+  uint32_t head;
+
+#if (CFG_TL_EVT_LATENCY_STATS != 0)
+  EvtLatencyStop(phcievt);
+#endif
+
+  head = LocalFreeBufRingHead;
+  if ( (head - LocalFreeBufRingTail) < CFG_TL_MM_FREE_RING_SIZE )
+  {
+    LocalFreeBufRing[head & (CFG_TL_MM_FREE_RING_SIZE - 1)] = (tListNode *)phcievt;
+    __DMB();  /**< The slot is written before it is published */
+    LocalFreeBufRingHead = head + 1;
+  }
+  else
+  {
+    LST_insert_tail(&LocalFreeBufQueue, (tListNode *)phcievt);
+  }
 
   OutputDbgTrace(TL_MB_MM_RELEASE_BUFFER, (uint8_t*)phcievt);
 
@@ -628,15 +709,113 @@ void TL_MM_EvtDone(TL_EvtPacket_t * phcievt)
 static void SendFreeBuf( void )
 {
   tListNode *p_node;
+  tListNode *p_free_queue;
+  uint32_t tail;
+  uint32_t head;
+
+  /**
+   * CPU2 does not access the free buffer queue until the release channel is set again after this callback:
+   * the buffers are appended without masking interrupts
+   */
+  p_free_queue = (tListNode*)(TL_RefTable.p_mem_manager_table->pevt_free_buffer_queue);
+
+  tail = LocalFreeBufRingTail;
+  head = LocalFreeBufRingHead;
+  __DMB();  /**< The slots are read after the published head */
+  while ( tail != head )
+  {
+    p_node = LocalFreeBufRing[tail & (CFG_TL_MM_FREE_RING_SIZE - 1)];
+    p_node->next = p_free_queue;
+    p_node->prev = p_free_queue->prev;
+    p_free_queue->prev->next = p_node;
+    p_free_queue->prev = p_node;
+    tail++;
+  }
+  LocalFreeBufRingTail = tail;
 
   while ( FALSE == LST_is_empty (&LocalFreeBufQueue) )
   {
     LST_remove_head( &LocalFreeBufQueue, (tListNode **)&p_node );
-    LST_insert_tail( (tListNode*)(TL_RefTable.p_mem_manager_table->pevt_free_buffer_queue), p_node );
+    LST_insert_tail( p_free_queue, p_node );
+  }
+
+  return;
+}
+
+const TL_EvtLatencyStats_t * TL_MM_GetEvtLatency( void )
+{
+#if (CFG_TL_EVT_LATENCY_STATS != 0)
+  return &EvtLatencyStats;
+#else
+  return NULL;
+#endif
+}
+
+void TL_MM_ResetEvtLatency( void )
+{
+#if (CFG_TL_EVT_LATENCY_STATS != 0)
+  memset(&EvtLatencyStats, 0, sizeof(EvtLatencyStats));
+#endif
+
+  return;
+}
+
+#if (CFG_TL_EVT_LATENCY_STATS != 0)
+/**
+ * Called from the IPCC RX interrupt only
+ */
+static void EvtLatencyStart( TL_EvtPacket_t * phcievt )
+{
+  uint32_t index;
+
+  for(index = 0; index < TL_EVT_LATENCY_SLOTS; index++)
+  {
+    if(EvtLatencyPacket[index] == NULL)
+    {
+      EvtLatencyStamp[index] = DWT->CYCCNT;
+      EvtLatencyPacket[index] = phcievt;
+      return;
+    }
+  }
+  EvtLatencyStats.Untracked++;
+
+  return;
+}
+
+/**
+ * Called from the background only; a slot is freed last so that the interrupt never sees it half written
+ */
+static void EvtLatencyStop( TL_EvtPacket_t * phcievt )
+{
+  uint32_t index;
+  uint32_t us;
+  uint32_t bin;
+
+  for(index = 0; index < TL_EVT_LATENCY_SLOTS; index++)
+  {
+    if(EvtLatencyPacket[index] == phcievt)
+    {
+      us = (DWT->CYCCNT - EvtLatencyStamp[index]) / (SystemCoreClock / 1000000);
+      EvtLatencyPacket[index] = NULL;
+
+      bin = 0;
+      while(((us >> bin) != 0) && (bin < (TL_EVT_LATENCY_BINS - 1)))
+      {
+        bin++;
+      }
+      EvtLatencyStats.Hist[bin]++;
+      EvtLatencyStats.Count++;
+      if(us > EvtLatencyStats.MaxUs)
+      {
+        EvtLatencyStats.MaxUs = us;
+      }
+      return;
+    }
   }
 
   return;
 }
+#endif
 
 /******************************************************************************
  * TRACES
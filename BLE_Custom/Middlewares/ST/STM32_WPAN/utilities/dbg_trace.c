@@ -19,7 +19,6 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "utilities_common.h"
-#include "stm_queue.h"
 #include "dbg_trace.h"
 
 /* Definition of the function */
@@ -50,6 +49,13 @@ size_t __write(int handle, const unsigned char * buf, size_t bufSize);
 /** @defgroup TRACE Log private defines 
  * @{
  */
+#if (DBG_TRACE_USE_CIRCULAR_QUEUE != 0)
+#define DBG_TRACE_RING_MASK   (DBG_TRACE_MSG_QUEUE_SIZE - 1U)
+
+#if ((DBG_TRACE_MSG_QUEUE_SIZE & DBG_TRACE_RING_MASK) != 0)
+#error "DBG_TRACE_MSG_QUEUE_SIZE shall be a power of two"
+#endif
+#endif
 
 /**
  * @}
@@ -69,8 +75,23 @@ size_t __write(int handle, const unsigned char * buf, size_t bufSize);
  */
 #if (( CFG_DEBUG_TRACE_FULL != 0 ) || ( CFG_DEBUG_TRACE_LIGHT != 0 ))
 #if (DBG_TRACE_USE_CIRCULAR_QUEUE != 0)
-static queue_t MsgDbgTraceQueue;
-static uint8_t MsgDbgTraceQueueBuff[DBG_TRACE_MSG_QUEUE_SIZE];
+/**
+ * Trace byte ring, written from any context without masking the interrupts and read by the UART DMA.
+ * The indexes are free running, the ring index is taken with DBG_TRACE_RING_MASK.
+ *  - the writers reserve [DbgTraceRingReserve, + size) with LDREX/STREX, then copy into it
+ *  - DbgTraceRingHead is moved to DbgTraceRingReserve by the last writer to finish, so the
+ *    bytes before DbgTraceRingHead are all written. As the writers can only be nested by
+ *    interrupts, they always finish in the reverse order they started
+ *  - [DbgTraceRingTail, DbgTraceRingTail + DbgTraceRingSending) is being sent by the DMA
+ */
+static uint8_t DbgTraceRing[DBG_TRACE_MSG_QUEUE_SIZE];
+static volatile uint32_t DbgTraceRingReserve;
+static volatile uint32_t DbgTraceRingHead;
+static volatile uint32_t DbgTraceRingTail;
+static volatile uint32_t DbgTraceRingWriters;
+static volatile uint32_t DbgTraceRingSending;
+/* Owner of the UART: set by whoever starts a transfer, cleared by the end of transfer */
+static volatile uint32_t DbgTraceRingTxBusy;
 #endif
 __IO ITStatus DbgTracePeripheralReady = SET;
 #endif
@@ -92,6 +113,10 @@ __IO ITStatus DbgTracePeripheralReady = SET;
  */
 #if (( CFG_DEBUG_TRACE_FULL != 0 ) || ( CFG_DEBUG_TRACE_LIGHT != 0 ))
 static void DbgTrace_TxCpltCallback(void);
+#if (DBG_TRACE_USE_CIRCULAR_QUEUE != 0)
+static uint32_t DbgTraceRingWrite(const uint8_t *buf, uint32_t bufSize);
+static void DbgTraceRingKick(void);
+#endif
 #endif
 
 
@@ -104,6 +129,117 @@ static void DbgTrace_TxCpltCallback(void);
 /** @defgroup TRACE Log Private function 
  * @{
  */
+#if ((( CFG_DEBUG_TRACE_FULL != 0 ) || ( CFG_DEBUG_TRACE_LIGHT != 0 )) && (DBG_TRACE_USE_CIRCULAR_QUEUE != 0))
+/**
+ * @brief  DbgTraceRingWrite: Copy a trace into the ring and make it visible to the UART
+ * @param  buf      Trace to be written
+ * @param  bufSize  Its size
+ * @retval 1 if written, 0 if the ring had no room for it (the trace is dropped)
+ */
+static uint32_t DbgTraceRingWrite(const uint8_t *buf, uint32_t bufSize)
+{
+  uint32_t start;
+  uint32_t index;
+  uint32_t first;
+  uint32_t head;
+  uint32_t written = 1;
+
+  /* Interrupted read-modify-writes are safe: a nested writer restores the count before returning */
+  DbgTraceRingWriters++;
+
+  do
+  {
+    start = __LDREXW(&DbgTraceRingReserve);
+    if ((start + bufSize - DbgTraceRingTail) > DBG_TRACE_MSG_QUEUE_SIZE)
+    {
+      __CLREX();
+      written = 0;
+      break;
+    }
+  } while (__STREXW(start + bufSize, &DbgTraceRingReserve) != 0U);
+
+  if (written != 0)
+  {
+    /* Copy in at most two chunks, around the end of the ring */
+    index = start & DBG_TRACE_RING_MASK;
+    first = DBG_TRACE_MSG_QUEUE_SIZE - index;
+    if (first >= bufSize)
+    {
+      memcpy(&DbgTraceRing[index], buf, bufSize);
+    }
+    else
+    {
+      memcpy(&DbgTraceRing[index], buf, first);
+      memcpy(&DbgTraceRing[0], &buf[first], bufSize - first);
+    }
+    __DMB();
+  }
+
+  DbgTraceRingWriters--;
+  if (DbgTraceRingWriters == 0U)
+  {
+    /**
+     * Publish everything reserved so far. A writer interrupting this may publish more and then be
+     * overwritten with an older value: read again until stable. The older value is still fully written
+     */
+    do
+    {
+      head = DbgTraceRingReserve;
+      DbgTraceRingHead = head;
+    } while (head != DbgTraceRingReserve);
+
+    DbgTraceRingKick();
+  }
+
+  return written;
+}
+
+/**
+ * @brief  DbgTraceRingKick: Start a UART transfer of the published traces if none is running
+ * @note   The transfer covers the contiguous span from the tail, up to the end of the ring
+ * @param  None
+ * @retval None
+ */
+static void DbgTraceRingKick(void)
+{
+  uint32_t tail;
+  uint32_t span;
+
+  for (;;)
+  {
+    /* Take the UART, or leave it to its owner */
+    do
+    {
+      if (__LDREXW(&DbgTraceRingTxBusy) != 0U)
+      {
+        __CLREX();
+        return;
+      }
+    } while (__STREXW(1U, &DbgTraceRingTxBusy) != 0U);
+
+    tail = DbgTraceRingTail;
+    span = DbgTraceRingHead - tail;
+    if (span != 0U)
+    {
+      if (span > (DBG_TRACE_MSG_QUEUE_SIZE - (tail & DBG_TRACE_RING_MASK)))
+      {
+        span = DBG_TRACE_MSG_QUEUE_SIZE - (tail & DBG_TRACE_RING_MASK);
+      }
+      DbgTraceRingSending = span;
+      DbgOutputTraces(&DbgTraceRing[tail & DBG_TRACE_RING_MASK], (uint16_t)span, DbgTrace_TxCpltCallback);
+      return;
+    }
+
+    /* Nothing to send: release the UART, unless a trace was published in between */
+    DbgTraceRingTxBusy = 0U;
+    if (DbgTraceRingHead == DbgTraceRingTail)
+    {
+      return;
+    }
+  }
+}
+#endif
+
 
 
 /* Functions Definition ------------------------------------------------------*/
@@ -155,6 +291,45 @@ void DbgTraceBuffer(const void *pBuffer, uint32_t u32Length, const char *strForm
   }
 }
 
+/**
+ * @brief  DbgTraceBinary: Queue a binary trace record made of a format string offset and raw arguments
+ * @param  fmt_id  Offset of the format string in the .dbg_trace_fmt section
+ * @param  p_args  Arguments, as 32 bit values
+ * @param  nargs   Number of arguments, at most DBG_TRACE_BIN_MAX_ARGS
+ * @retval None
+ */
+void DbgTraceBinary(uint16_t fmt_id, const uint32_t *p_args, uint32_t nargs)
+{
+#if (( CFG_DEBUG_TRACE_FULL != 0 ) || ( CFG_DEBUG_TRACE_LIGHT != 0 ))
+  uint8_t record[4 + (4 * DBG_TRACE_BIN_MAX_ARGS)];
+  uint32_t u32Index;
+
+  if (nargs > DBG_TRACE_BIN_MAX_ARGS)
+  {
+    nargs = DBG_TRACE_BIN_MAX_ARGS;
+  }
+
+  record[0] = DBG_TRACE_BIN_SYNC;
+  record[1] = (uint8_t)nargs;
+  record[2] = (uint8_t)fmt_id;
+  record[3] = (uint8_t)(fmt_id >> 8);
+  for (u32Index = 0; u32Index < nargs; u32Index++)
+  {
+    record[4 + (4 * u32Index)] = (uint8_t)p_args[u32Index];
+    record[5 + (4 * u32Index)] = (uint8_t)(p_args[u32Index] >> 8);
+    record[6 + (4 * u32Index)] = (uint8_t)(p_args[u32Index] >> 16);
+    record[7 + (4 * u32Index)] = (uint8_t)(p_args[u32Index] >> 24);
+  }
+
+  /* Written at once: the record is never interleaved with another trace */
+  (void)DbgTraceWrite(1U, record, 4 + (4 * nargs));
+#else
+  (void)fmt_id;
+  (void)p_args;
+  (void)nargs;
+#endif
+}
+
 #if (( CFG_DEBUG_TRACE_FULL != 0 ) || ( CFG_DEBUG_TRACE_LIGHT != 0 ))
 /**
  * @brief  DBG_TRACE USART Tx Transfer completed callback
@@ -166,29 +341,12 @@ void DbgTraceBuffer(const void *pBuffer, uint32_t u32Length, const char *strForm
 static void DbgTrace_TxCpltCallback(void)
 {
 #if (DBG_TRACE_USE_CIRCULAR_QUEUE != 0)
-  uint8_t* buf;
-  uint16_t bufSize;
-
-  BACKUP_PRIMASK();
+  /* Free the bytes just sent to UART and send the next span */
+  DbgTraceRingTail += DbgTraceRingSending;
+  DbgTraceRingSending = 0U;
+  DbgTraceRingTxBusy = 0U;
 
-  DISABLE_IRQ();			/**< Disable all interrupts by setting PRIMASK bit on Cortex*/
-  /* Remove element just sent to UART */
-  CircularQueue_Remove(&MsgDbgTraceQueue,&bufSize);
-
-  /* Sense if new data to be sent */
-  buf=CircularQueue_Sense(&MsgDbgTraceQueue,&bufSize);
-
-
-  if ( buf != NULL) 
-  {
-    RESTORE_PRIMASK();
-    DbgOutputTraces((uint8_t*)buf, bufSize, DbgTrace_TxCpltCallback);
-  } 
-  else
-  {
-    DbgTracePeripheralReady = SET;
-    RESTORE_PRIMASK();
-  }
+  DbgTraceRingKick();
 
 #else
   BACKUP_PRIMASK();
@@ -207,7 +365,12 @@ void DbgTraceInit( void )
 #if (( CFG_DEBUG_TRACE_FULL != 0 ) || ( CFG_DEBUG_TRACE_LIGHT != 0 ))
   DbgOutputInit();
 #if (DBG_TRACE_USE_CIRCULAR_QUEUE != 0)
-  CircularQueue_Init(&MsgDbgTraceQueue, MsgDbgTraceQueueBuff, DBG_TRACE_MSG_QUEUE_SIZE, 0, CIRCULAR_QUEUE_SPLIT_IF_WRAPPING_FLAG);
+  DbgTraceRingReserve = 0U;
+  DbgTraceRingHead = 0U;
+  DbgTraceRingTail = 0U;
+  DbgTraceRingWriters = 0U;
+  DbgTraceRingSending = 0U;
+  DbgTraceRingTxBusy = 0U;
 #endif 
 #endif
   return;
@@ -254,9 +417,10 @@ size_t __write(int handle, const unsigned char * buf, size_t bufSize)
 size_t DbgTraceWrite(int handle, const unsigned char * buf, size_t bufSize)
 {
   size_t chars_written = 0;
-  uint8_t* buffer;
 
+#if (DBG_TRACE_USE_CIRCULAR_QUEUE == 0)
   BACKUP_PRIMASK();
+#endif
 
   /* Ignore flushes */
   if ( handle == -1 )
@@ -272,23 +436,12 @@ size_t DbgTraceWrite(int handle, const unsigned char * buf, size_t bufSize)
   else if (bufSize != 0)
   {
     chars_written = bufSize;
-    /* If queue emepty and TX free, send directly */
-    /* CS Start */
 
 #if (DBG_TRACE_USE_CIRCULAR_QUEUE != 0)
-    DISABLE_IRQ();      /**< Disable all interrupts by setting PRIMASK bit on Cortex*/
-    buffer=CircularQueue_Add(&MsgDbgTraceQueue,(uint8_t*)buf, bufSize,1);
-    if (buffer && DbgTracePeripheralReady)
-    {
-      DbgTracePeripheralReady = RESET;
-      RESTORE_PRIMASK();
-      DbgOutputTraces((uint8_t*)buffer, bufSize, DbgTrace_TxCpltCallback);
-    }
-    else
-    {
-      RESTORE_PRIMASK();
-    }
+    /* No critical section: the ring takes writers from any context */
+    (void)DbgTraceRingWrite(buf, bufSize);
 #else
+    /* CS Start */
     DISABLE_IRQ();      /**< Disable all interrupts by setting PRIMASK bit on Cortex*/
     DbgTracePeripheralReady = RESET;
     RESTORE_PRIMASK();
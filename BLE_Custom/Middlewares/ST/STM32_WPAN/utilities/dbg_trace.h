@@ -29,9 +29,64 @@ extern "C"
 /* Exported types ------------------------------------------------------------*/
 /* External variables --------------------------------------------------------*/
 /* Exported macros -----------------------------------------------------------*/
+#ifndef CFG_DEBUG_TRACE_BINARY
+#define CFG_DEBUG_TRACE_BINARY  0
+#endif
+
+/**
+ * Binary trace: the format string is not formatted on the target. It is placed in the
+ * .dbg_trace_fmt section, which is kept in the ELF file but not loaded (see the linker script),
+ * and the trace records only its offset in that section and the arguments, as 32 bit values:
+ *
+ *   DBG_TRACE_BIN_SYNC, number of arguments, format offset (2 bytes), arguments (4 bytes each)
+ *
+ * all little endian. The host decoder reads the format strings from the ELF file.
+ * %s arguments are decoded only when they point to constant strings in flash, and
+ * 64 bit or floating point arguments are not supported.
+ */
+#define DBG_TRACE_BIN_SYNC      0xA5U
+#define DBG_TRACE_BIN_MAX_ARGS  12U
+
+#if ( ( ( CFG_DEBUG_TRACE_FULL != 0 ) || ( CFG_DEBUG_TRACE_LIGHT != 0 ) ) && ( CFG_DEBUG_TRACE_BINARY != 0 ) && defined(__GNUC__) )
+#define DBG_TRACE_BIN_ENABLED   1
+
+#define DBG_TRACE_BIN_ARG(x)    ((uint32_t)(uintptr_t)(x))
+
+#define DBG_TRACE_BIN_NARG(...) DBG_TRACE_BIN_NARG_(_, ##__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DBG_TRACE_BIN_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, n, ...) n
+
+#define DBG_TRACE_BIN_MAP_0()
+#define DBG_TRACE_BIN_MAP_1(a)        , DBG_TRACE_BIN_ARG(a)
+#define DBG_TRACE_BIN_MAP_2(a, ...)   , DBG_TRACE_BIN_ARG(a) DBG_TRACE_BIN_MAP_1(__VA_ARGS__)
+#define DBG_TRACE_BIN_MAP_3(a, ...)   , DBG_TRACE_BIN_ARG(a) DBG_TRACE_BIN_MAP_2(__VA_ARGS__)
+#define DBG_TRACE_BIN_MAP_4(a, ...)   , DBG_TRACE_BIN_ARG(a) DBG_TRACE_BIN_MAP_3(__VA_ARGS__)
+#define DBG_TRACE_BIN_MAP_5(a, ...)   , DBG_TRACE_BIN_ARG(a) DBG_TRACE_BIN_MAP_4(__VA_ARGS__)
+#define DBG_TRACE_BIN_MAP_6(a, ...)   , DBG_TRACE_BIN_ARG(a) DBG_TRACE_BIN_MAP_5(__VA_ARGS__)
+#define DBG_TRACE_BIN_MAP_7(a, ...)   , DBG_TRACE_BIN_ARG(a) DBG_TRACE_BIN_MAP_6(__VA_ARGS__)
+#define DBG_TRACE_BIN_MAP_8(a, ...)   , DBG_TRACE_BIN_ARG(a) DBG_TRACE_BIN_MAP_7(__VA_ARGS__)
+#define DBG_TRACE_BIN_MAP_9(a, ...)   , DBG_TRACE_BIN_ARG(a) DBG_TRACE_BIN_MAP_8(__VA_ARGS__)
+#define DBG_TRACE_BIN_MAP_10(a, ...)  , DBG_TRACE_BIN_ARG(a) DBG_TRACE_BIN_MAP_9(__VA_ARGS__)
+#define DBG_TRACE_BIN_MAP_11(a, ...)  , DBG_TRACE_BIN_ARG(a) DBG_TRACE_BIN_MAP_10(__VA_ARGS__)
+#define DBG_TRACE_BIN_MAP_12(a, ...)  , DBG_TRACE_BIN_ARG(a) DBG_TRACE_BIN_MAP_11(__VA_ARGS__)
+#define DBG_TRACE_BIN_CAT(a, b)       DBG_TRACE_BIN_CAT_(a, b)
+#define DBG_TRACE_BIN_CAT_(a, b)      a##b
+#define DBG_TRACE_BIN_MAP(...)        DBG_TRACE_BIN_CAT(DBG_TRACE_BIN_MAP_, DBG_TRACE_BIN_NARG(__VA_ARGS__))(__VA_ARGS__)
+
+#define DBG_TRACE_BIN(fmt, ...)                                                                   \
+  do{                                                                                             \
+    static const char dbg_trace_fmt[] __attribute__((section(".dbg_trace_fmt"), used)) = fmt;     \
+    const uint32_t dbg_trace_args[] = { 0U DBG_TRACE_BIN_MAP(__VA_ARGS__) };                      \
+    DbgTraceBinary((uint16_t)(uintptr_t)dbg_trace_fmt, &dbg_trace_args[1], DBG_TRACE_BIN_NARG(__VA_ARGS__)); \
+  }while(0)
+#else
+#define DBG_TRACE_BIN_ENABLED   0
+#endif
+
 #if ( ( CFG_DEBUG_TRACE_FULL != 0 ) || ( CFG_DEBUG_TRACE_LIGHT != 0 ) )
 #define PRINT_LOG_BUFF_DBG(...) DbgTraceBuffer(__VA_ARGS__)
-#if ( CFG_DEBUG_TRACE_FULL != 0 )
+#if ( DBG_TRACE_BIN_ENABLED != 0 )
+#define PRINT_MESG_DBG(...)     DBG_TRACE_BIN(__VA_ARGS__)
+#elif ( CFG_DEBUG_TRACE_FULL != 0 )
 #define PRINT_MESG_DBG(...)     do{printf("\r\n [%s][%s][%d] ", DbgTraceGetFileName(__FILE__),__FUNCTION__,__LINE__);printf(__VA_ARGS__);}while(0);
 #else
 #define PRINT_MESG_DBG          printf
@@ -85,6 +140,16 @@ void DbgTraceBuffer( const void *pBuffer , uint32_t u32Length , const char *strF
 
 const char *DbgTraceGetFileName( const char *fullpath );
 
+/**
+ * @brief Queue a binary trace record, see DBG_TRACE_BIN()
+ *
+ * @param  fmt_id:  Offset of the format string in the .dbg_trace_fmt section
+ * @param  p_args:  Arguments, as 32 bit values
+ * @param  nargs:   Number of arguments, at most DBG_TRACE_BIN_MAX_ARGS
+ * @retval None
+ */
+void DbgTraceBinary( uint16_t fmt_id, const uint32_t *p_args, uint32_t nargs );
+
 /**
  * @brief Override the standard lib function to redirect printf to USART.
  * @param handle output handle (STDIO, STDERR...)
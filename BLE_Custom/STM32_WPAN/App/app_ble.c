@@ -37,6 +37,10 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "telemetry.h"
+#include "conn_policy.h"
+#include "link_perf.h"
+#include "task_profile.h"
 
 /* USER CODE END Includes */
 
@@ -221,7 +225,10 @@ uint8_t a_AdvData[21] =
 };
 
 /* USER CODE BEGIN PV */
-
+/* Set when the HCI event queue was found empty: the next notification is a
+   fresh event and gets a deadline. Re-posts of a backlog are plain, or EDF
+   would keep picking the HCI task over everything else at its priority */
+static volatile uint8_t HciEvtDeadlineArmed = 1;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -238,7 +245,7 @@ static void Connection_Interval_Update_Req(void);
 #endif /* L2CAP_REQUEST_NEW_CONN_PARAM != 0 */
 
 /* USER CODE BEGIN PFP */
-
+static void BLE_HciUserEvtProc(void);
 /* USER CODE END PFP */
 
 /* External variables --------------------------------------------------------*/
@@ -306,7 +313,7 @@ void APP_BLE_Init(void)
   /**
    * Register the hci transport layer to handle BLE User Asynchronous Events
    */
-  UTIL_SEQ_RegTask(1<<CFG_TASK_HCI_ASYNCH_EVT_ID, UTIL_SEQ_RFU, hci_user_evt_proc);
+  UTIL_SEQ_RegTask(1<<CFG_TASK_HCI_ASYNCH_EVT_ID, UTIL_SEQ_RFU, BLE_HciUserEvtProc);
 
   /**
    * Starts the BLE Stack on CPU2
@@ -349,6 +356,7 @@ void APP_BLE_Init(void)
 #if (L2CAP_REQUEST_NEW_CONN_PARAM != 0)
   UTIL_SEQ_RegTask(1<<CFG_TASK_CONN_UPDATE_REG_ID, UTIL_SEQ_RFU, Connection_Interval_Update_Req);
 #endif /* L2CAP_REQUEST_NEW_CONN_PARAM != 0 */
+  CONN_POLICY_Init();
   /* USER CODE END APP_BLE_Init_4 */
 
   /**
@@ -436,6 +444,9 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
                     p_disconnection_complete_event->Reason);
 
         /* USER CODE BEGIN EVT_DISCONN_COMPLETE_2 */
+        CONN_POLICY_Disconnected();
+        LINK_PERF_Disconnected();
+        TASK_PROFILE_Dump();
 
         /* USER CODE END EVT_DISCONN_COMPLETE_2 */
       }
@@ -477,7 +488,34 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
     {
       p_meta_evt = (evt_le_meta_event*) p_event_pckt->data;
       /* USER CODE BEGIN EVT_LE_META_EVENT */
+      switch (p_meta_evt->subevent)
+      {
+        case HCI_LE_PHY_UPDATE_COMPLETE_SUBEVT_CODE:
+        {
+          hci_le_phy_update_complete_event_rp0 *p_phy_event;
 
+          p_phy_event = (hci_le_phy_update_complete_event_rp0 *)p_meta_evt->data;
+          APP_DBG_MSG(">>== HCI_LE_PHY_UPDATE_COMPLETE_SUBEVT_CODE - Status: 0x%x\n", p_phy_event->Status);
+          if (p_phy_event->Status == BLE_STATUS_SUCCESS)
+          {
+            LINK_PERF_SetPhy(p_phy_event->TX_PHY, p_phy_event->RX_PHY);
+          }
+          break;
+        }
+
+        case HCI_LE_DATA_LENGTH_CHANGE_SUBEVT_CODE:
+        {
+          hci_le_data_length_change_event_rp0 *p_dle_event;
+
+          p_dle_event = (hci_le_data_length_change_event_rp0 *)p_meta_evt->data;
+          APP_DBG_MSG(">>== HCI_LE_DATA_LENGTH_CHANGE_SUBEVT_CODE\n");
+          LINK_PERF_SetDataLength(p_dle_event->MaxTxOctets, p_dle_event->MaxRxOctets);
+          break;
+        }
+
+        default:
+          break;
+      }
       /* USER CODE END EVT_LE_META_EVENT */
       switch (p_meta_evt->subevent)
       {
@@ -492,6 +530,9 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
 #endif /* CFG_DEBUG_APP_TRACE != 0 */
 
           /* USER CODE BEGIN EVT_LE_CONN_UPDATE_COMPLETE */
+          CONN_POLICY_Updated(((hci_le_connection_update_complete_event_rp0 *)p_meta_evt->data)->Conn_Interval,
+                              ((hci_le_connection_update_complete_event_rp0 *)p_meta_evt->data)->Conn_Latency);
+          LINK_PERF_SetInterval(((hci_le_connection_update_complete_event_rp0 *)p_meta_evt->data)->Conn_Interval);
 
           /* USER CODE END EVT_LE_CONN_UPDATE_COMPLETE */
           break;
@@ -535,6 +576,9 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
           HandleNotification.ConnectionHandle = BleApplicationContext.BleApplicationContext_legacy.connectionHandle;
           Custom_APP_Notification(&HandleNotification);
           /* USER CODE BEGIN HCI_EVT_LE_CONN_COMPLETE */
+          CONN_POLICY_Connected(p_connection_complete_event->Connection_Handle);
+          LINK_PERF_Connected(p_connection_complete_event->Connection_Handle,
+                              p_connection_complete_event->Conn_Interval);
 
           /* USER CODE END HCI_EVT_LE_CONN_COMPLETE */
           break; /* HCI_LE_CONNECTION_COMPLETE_SUBEVT_CODE */
@@ -572,6 +616,7 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
           mutex = 1;
 #endif /* L2CAP_REQUEST_NEW_CONN_PARAM != 0 */
           /* USER CODE BEGIN EVT_BLUE_L2CAP_CONNECTION_UPDATE_RESP */
+          CONN_POLICY_Response(((aci_l2cap_connection_update_resp_event_rp0 *)p_blecore_evt->data)->Result == 0);
 
           /* USER CODE END EVT_BLUE_L2CAP_CONNECTION_UPDATE_RESP */
           break;
@@ -683,7 +728,26 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
           break;
         }
         /* USER CODE BEGIN BLUE_EVT */
-        
+        case ACI_ATT_EXCHANGE_MTU_RESP_VSEVT_CODE:
+        {
+          aci_att_exchange_mtu_resp_event_rp0 *p_mtu_event;
+
+          p_mtu_event = (aci_att_exchange_mtu_resp_event_rp0 *)p_blecore_evt->data;
+          APP_DBG_MSG(">>== ACI_ATT_EXCHANGE_MTU_RESP_VSEVT_CODE\n");
+          APP_DBG_MSG("     - ATT_MTU = %d\n", p_mtu_event->Server_RX_MTU);
+          TELEMETRY_SetMtu(p_mtu_event->Server_RX_MTU);
+          LINK_PERF_SetMtu(p_mtu_event->Server_RX_MTU);
+          break;
+        }
+
+        case ACI_GATT_TX_POOL_AVAILABLE_VSEVT_CODE:
+          TELEMETRY_TxReady();
+          break;
+
+        case ACI_L2CAP_PROC_TIMEOUT_VSEVT_CODE:
+          APP_DBG_MSG(">>== ACI_L2CAP_PROC_TIMEOUT_VSEVT_CODE\n");
+          CONN_POLICY_Response(0);
+          break;
         /* USER CODE END BLUE_EVT */
       }
       break; /* HCI_VENDOR_SPECIFIC_DEBUG_EVT_CODE */
@@ -942,7 +1006,18 @@ static void Ble_Hci_Gap_Gatt_Init(void)
   BleApplicationContext.BleApplicationContext_legacy.bleSecurityParam.encryptionKeySizeMax = CFG_ENCRYPTION_KEY_SIZE_MAX;
   BleApplicationContext.BleApplicationContext_legacy.bleSecurityParam.bonding_mode = CFG_BONDING_MODE;
   /* USER CODE BEGIN Ble_Hci_Gap_Gatt_Init_1*/
-
+  /**
+   * Longest data PDUs also for connections where the central asks first
+   */
+  ret = hci_le_write_suggested_default_data_length(LINK_PERF_MAX_OCTETS, LINK_PERF_MAX_TIME_US);
+  if (ret != BLE_STATUS_SUCCESS)
+  {
+    APP_DBG_MSG("  Fail   : hci_le_write_suggested_default_data_length command, result: 0x%x \n", ret);
+  }
+  else
+  {
+    APP_DBG_MSG("  Success: hci_le_write_suggested_default_data_length command\n");
+  }
   /* USER CODE END Ble_Hci_Gap_Gatt_Init_1*/
 
   ret = aci_gap_set_authentication_requirement(BleApplicationContext.BleApplicationContext_legacy.bleSecurityParam.bonding_mode,
@@ -1074,6 +1149,24 @@ const uint8_t* BleGetBdAddress(void)
 }
 
 /* USER CODE BEGIN FD_LOCAL_FUNCTION */
+/**
+  * @brief  HCI_ASYNCH_EVT task: report queued events and re-arm the deadline
+  *         once the queue is drained.
+  */
+static void BLE_HciUserEvtProc(void)
+{
+  uint32_t primask_bit;
+
+  hci_user_evt_proc();
+
+  primask_bit = __get_PRIMASK();
+  __disable_irq();
+  if (hci_get_evt_stats()->QueueDepth == 0U)
+  {
+    HciEvtDeadlineArmed = 1;
+  }
+  __set_PRIMASK(primask_bit);
+}
 
 /* USER CODE END FD_LOCAL_FUNCTION */
 
@@ -1201,7 +1294,23 @@ void APP_BLE_Key_Button3_Action(void)
  *************************************************************/
 void hci_notify_asynch_evt(void* p_Data)
 {
-  UTIL_SEQ_SetTask(1 << CFG_TASK_HCI_ASYNCH_EVT_ID, CFG_SCH_PRIO_0);
+  uint32_t primask_bit;
+  uint8_t deadline;
+
+  primask_bit = __get_PRIMASK();
+  __disable_irq();
+  deadline = HciEvtDeadlineArmed;
+  HciEvtDeadlineArmed = 0;
+  __set_PRIMASK(primask_bit);
+
+  if (deadline != 0)
+  {
+    UTIL_SEQ_SetTaskDeadline(1 << CFG_TASK_HCI_ASYNCH_EVT_ID, CFG_SCH_PRIO_0, CFG_TLBLE_EVT_DEADLINE_MS);
+  }
+  else
+  {
+    UTIL_SEQ_SetTask(1 << CFG_TASK_HCI_ASYNCH_EVT_ID, CFG_SCH_PRIO_0);
+  }
 
   return;
 }
@@ -29,6 +29,11 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "lamps.h"
+#include "lamp_seq.h"
+#include "lamp_stream.h"
+#include "telemetry.h"
+#include "conn_policy.h"
 
 /* USER CODE END Includes */
 
@@ -37,6 +42,7 @@ typedef struct
 {
   /* LED_Server */
   uint8_t               Switch_c_Notification_Status;
+  uint8_t               Long_c_Notification_Status;
   /* USER CODE BEGIN CUSTOM_APP_Context_t */
   uint8_t               SW1_Status;
   uint8_t               SW2_Status;
@@ -59,6 +65,12 @@ typedef struct
 
 #define TOGGLE_ON                       1
 #define TOGGLE_OFF                      0
+
+/* B_LED_C writes of up to LED_C_LEGACY_MAX_LEN bytes carry the lamp bitmask;
+   longer ones start with an opcode */
+#define LED_C_LEGACY_MAX_LEN            2
+#define LED_C_OP_SEQUENCE               0x01
+#define LED_C_OP_BATCH                  0x02
 /* USER CODE END PD */
 
 /* Private macros -------------------------------------------------------------*/
@@ -88,9 +100,12 @@ uint8_t hr_energy_reset = CUSTOM_STM_HRS_ENERGY_NOT_RESET;
 /* LED_Server */
 static void Custom_Switch_c_Update_Char(void);
 static void Custom_Switch_c_Send_Notification(void);
+static void Custom_Long_c_Update_Char(void);
+static void Custom_Long_c_Send_Notification(void);
 
 /* USER CODE BEGIN PFP */
-
+static void Custom_B_led_c_Write_Legacy(uint8_t *pPayload, uint16_t Length);
+static uint8_t Custom_B_led_c_Write_Op(uint8_t *pPayload, uint16_t Length);
 /* USER CODE END PFP */
 
 /* Functions Definition ------------------------------------------------------*/
@@ -117,16 +132,18 @@ void Custom_STM_App_Notification(Custom_STM_App_Notification_evt_t *pNotificatio
     case CUSTOM_STM_B_LED_C_WRITE_NO_RESP_EVT:
       /* USER CODE BEGIN CUSTOM_STM_B_LED_C_WRITE_NO_RESP_EVT */
       APP_DBG_MSG("\r\n\r** CUSTOM_STM_B_LED_C_WRITE_NO_RESP_EVT \n");
-      APP_DBG_MSG("\r\n\r** Write Data: 0x%02X %02X \n", pNotification->DataTransfered.pPayload[0], pNotification->DataTransfered.pPayload[1]);
-      uint8_t orVal = pNotification->DataTransfered.pPayload[1] | pNotification->DataTransfered.pPayload[0];
-
-
-      HAL_GPIO_WritePin(TRAFFIC_GR_GPIO_Port, TRAFFIC_GR_Pin, (orVal & 1) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-      HAL_GPIO_WritePin(TRAFFIC_YL_GPIO_Port, TRAFFIC_YL_Pin, (orVal & 2) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-      HAL_GPIO_WritePin(TRAFFIC_RD_GPIO_Port, TRAFFIC_RD_Pin, (orVal & 4) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-
-      if (orVal & 8) BSP_LED_On(LED_BLUE); else BSP_LED_Off(LED_BLUE);
-      if (orVal & 16) BSP_LED_On(LED_RED); else BSP_LED_Off(LED_RED);
+      CONN_POLICY_Activity();
+      if (pNotification->DataTransfered.Length <= LED_C_LEGACY_MAX_LEN)
+      {
+        Custom_B_led_c_Write_Legacy(pNotification->DataTransfered.pPayload,
+                                    pNotification->DataTransfered.Length);
+      }
+      else if (!Custom_B_led_c_Write_Op(pNotification->DataTransfered.pPayload,
+                                        pNotification->DataTransfered.Length))
+      {
+        /* A write command has no ATT response: report it as telemetry */
+        TELEMETRY_PutTicked(TELEMETRY_REC_REJECT, pNotification->DataTransfered.pPayload[0]);
+      }
       /* USER CODE END CUSTOM_STM_B_LED_C_WRITE_NO_RESP_EVT */
       break;
 
@@ -146,8 +163,34 @@ void Custom_STM_App_Notification(Custom_STM_App_Notification_evt_t *pNotificatio
       /* USER CODE END CUSTOM_STM_SWITCH_C_NOTIFY_DISABLED_EVT */
       break;
 
+    case CUSTOM_STM_LINK_C_READ_EVT:
+      /* USER CODE BEGIN CUSTOM_STM_LINK_C_READ_EVT */
+
+      /* USER CODE END CUSTOM_STM_LINK_C_READ_EVT */
+      break;
+
+    case CUSTOM_STM_LONG_C_NOTIFY_ENABLED_EVT:
+      /* USER CODE BEGIN CUSTOM_STM_LONG_C_NOTIFY_ENABLED_EVT */
+      APP_DBG_MSG("\r\n\r** CUSTOM_STM_LONG_C_NOTIFY_ENABLED_EVT \n");
+
+      Custom_App_Context.Long_c_Notification_Status = TOGGLE_ON;          /* MyLongChar carries the telemetry frames */
+      TELEMETRY_Enable(1);
+      /* USER CODE END CUSTOM_STM_LONG_C_NOTIFY_ENABLED_EVT */
+      break;
+
+    case CUSTOM_STM_LONG_C_NOTIFY_DISABLED_EVT:
+      /* USER CODE BEGIN CUSTOM_STM_LONG_C_NOTIFY_DISABLED_EVT */
+      APP_DBG_MSG("\r\n\r** CUSTOM_STM_LONG_C_NOTIFY_DISABLED_EVT \n");
+
+      Custom_App_Context.Long_c_Notification_Status = TOGGLE_OFF;
+      TELEMETRY_Enable(0);
+      /* USER CODE END CUSTOM_STM_LONG_C_NOTIFY_DISABLED_EVT */
+      break;
+
     case CUSTOM_STM_NOTIFICATION_COMPLETE_EVT:
       /* USER CODE BEGIN CUSTOM_STM_NOTIFICATION_COMPLETE_EVT */
+      /* A TX buffer was freed: top the controller up with the next frames */
+      TELEMETRY_TxReady();
 
       /* USER CODE END CUSTOM_STM_NOTIFICATION_COMPLETE_EVT */
       break;
@@ -184,6 +227,10 @@ void Custom_APP_Notification(Custom_App_ConnHandle_Not_evt_t *pNotification)
     case CUSTOM_DISCON_HANDLE_EVT :
       /* USER CODE BEGIN CUSTOM_DISCON_HANDLE_EVT */
       Connection_Handle = pNotification->ConnectionHandle;
+      /* Notification subscriptions and the ATT_MTU end with the link */
+      Custom_App_Context.Long_c_Notification_Status = TOGGLE_OFF;
+      TELEMETRY_Enable(0);
+      TELEMETRY_SetMtu(TELEMETRY_DEFAULT_ATT_MTU);
       /* USER CODE END CUSTOM_DISCON_HANDLE_EVT */
       break;
 
@@ -207,10 +254,14 @@ void Custom_APP_Init(void)
 
 
   Custom_Switch_c_Update_Char();
+  LAMP_SEQ_Init();
+  LAMP_STREAM_Init();
+  TELEMETRY_Init();
 
   UTIL_SEQ_RegTask(1<< CFG_TASK_SW1_BUTTON_PUSHED_ID, UTIL_SEQ_RFU, Custom_Switch_c_Send_Notification);
   
   Custom_App_Context.Switch_c_Notification_Status = TOGGLE_OFF;
+  Custom_App_Context.Long_c_Notification_Status = TOGGLE_OFF;
   Custom_App_Context.SW1_Status = 0; 
   /* USER CODE END CUSTOM_APP_Init */
   return;
@@ -282,17 +333,119 @@ void Custom_Switch_c_Send_Notification(void) /* Property Notification */
   }
 
   /* USER CODE BEGIN Switch_c_NS_Last*/
-
+  TELEMETRY_PutTicked(TELEMETRY_REC_BUTTON, Custom_App_Context.SW1_Status);
   /* USER CODE END Switch_c_NS_Last*/
 
   return;
 }
 
+__USED void Custom_Long_c_Update_Char(void) /* Property Read */
+{
+  uint8_t updateflag = 0;
+
+  /* USER CODE BEGIN Long_c_UC_1*/
+
+  /* USER CODE END Long_c_UC_1*/
+
+  if (updateflag != 0)
+  {
+    Custom_STM_App_Update_Char(CUSTOM_STM_LONG_C, (uint8_t *)UpdateCharData);
+  }
+
+  /* USER CODE BEGIN Long_c_UC_Last*/
+
+  /* USER CODE END Long_c_UC_Last*/
+  return;
+}
+
+__USED void Custom_Long_c_Send_Notification(void) /* Property Notification */
+{
+  uint8_t updateflag = 0;
+
+  /* USER CODE BEGIN Long_c_NS_1*/
+  /* Frames are notified by the telemetry TX task, see telemetry.c */
+  /* USER CODE END Long_c_NS_1*/
+
+  if (updateflag != 0)
+  {
+    Custom_STM_App_Update_Char(CUSTOM_STM_LONG_C, (uint8_t *)NotifyCharData);
+  }
+
+  /* USER CODE BEGIN Long_c_NS_Last*/
+
+  /* USER CODE END Long_c_NS_Last*/
+
+  return;
+}
+
 /* USER CODE BEGIN FD_LOCAL_FUNCTIONS*/
+/**
+  * @brief  Apply a lamp bitmask write: bits 0..2 traffic light, bit 3 blue
+  *         LED, bit 4 red LED. Stops a running sequence.
+  * @param  pPayload: written value, one or two bytes that are OR-ed
+  * @param  Length: value length
+  */
+static void Custom_B_led_c_Write_Legacy(uint8_t *pPayload, uint16_t Length)
+{
+  uint8_t orVal;
+
+  if (Length == 0)
+  {
+    return;
+  }
+  orVal = pPayload[0];
+  if (Length > 1)
+  {
+    orVal |= pPayload[1];
+  }
+  APP_DBG_MSG("\r\n\r** Write Data: 0x%02X \n", orVal);
+
+  LAMP_SEQ_Stop();
+  LAMP_STREAM_Reset();
+  Lamps_Write(orVal);
+
+  if (orVal & 8) BSP_LED_On(LED_BLUE); else BSP_LED_Off(LED_BLUE);
+  if (orVal & 16) BSP_LED_On(LED_RED); else BSP_LED_Off(LED_RED);
+}
+
+/**
+  * @brief  Handle an opcode-prefixed B_LED_C write.
+  * @param  pPayload: written value, opcode first
+  * @param  Length: value length
+  * @retval 1 if the command was applied, 0 if it was rejected
+  */
+static uint8_t Custom_B_led_c_Write_Op(uint8_t *pPayload, uint16_t Length)
+{
+  switch (pPayload[0])
+  {
+    case LED_C_OP_SEQUENCE:
+      LAMP_STREAM_Reset();
+      if (!LAMP_SEQ_Load(&pPayload[1], Length - 1U))
+      {
+        APP_DBG_MSG("\r\n\r** Sequence rejected, %d bytes \n", Length - 1);
+        return 0U;
+      }
+      return 1U;
+
+    case LED_C_OP_BATCH:
+      LAMP_SEQ_Stop();
+      if (!LAMP_STREAM_PutFrame(&pPayload[1], Length - 1U))
+      {
+        APP_DBG_MSG("\r\n\r** Batch rejected, %d bytes \n", Length - 1);
+        return 0U;
+      }
+      return 1U;
+
+    default:
+      APP_DBG_MSG("\r\n\r** Unknown B_LED_C opcode 0x%02X \n", pPayload[0]);
+      return 0U;
+  }
+}
+
 
 void SW1_Button_Action(void)
 {
-  UTIL_SEQ_SetTask( 1<<CFG_TASK_SW1_BUTTON_PUSHED_ID, CFG_SCH_PRIO_0);
+  UTIL_SEQ_SetTask( 1<<CFG_TASK_SW1_BUTTON_PUSHED_ID, CFG_SCH_PRIO_1);
 
   return;
 }
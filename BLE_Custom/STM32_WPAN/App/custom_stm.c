@@ -23,7 +23,7 @@
 #include "custom_stm.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "hci_tl.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -31,6 +31,8 @@ typedef struct{
   uint16_t  CustomLedsHdle;                    /**< LED_Server handle */
   uint16_t  CustomB_Led_CHdle;                  /**< BLUE_LED_Char handle */
   uint16_t  CustomSwitch_CHdle;                  /**< My_Switch_Char handle */
+  uint16_t  CustomLong_CHdle;                  /**< MyLongChar handle */
+  uint16_t  CustomLink_CHdle;                  /**< LinkInfoChar handle */
 /* USER CODE BEGIN Context */
   /* Place holder for Characteristic Descriptors Handle*/
 
@@ -54,7 +56,10 @@ extern uint16_t Connection_Handle;
 #define BM_REQ_CHAR_SIZE    (3)
 
 /* USER CODE BEGIN PD */
-
+/* ACI_GATT_UPDATE_CHAR_VALUE, for the commands queued with hci_send_req_async */
+#define ACI_GATT_UPDATE_CHAR_VALUE_OGF          0x3f
+#define ACI_GATT_UPDATE_CHAR_VALUE_OCF          0x106
+#define ACI_GATT_UPDATE_CHAR_VALUE_HEADER       6
 /* USER CODE END PD */
 
 /* Private macros ------------------------------------------------------------*/
@@ -67,8 +72,10 @@ extern uint16_t Connection_Handle;
 /* USER CODE END PM */
 
 /* Private variables ---------------------------------------------------------*/
-uint16_t SizeB_Led_C = 2;
+uint16_t SizeB_Led_C = 347;
 uint16_t SizeSwitch_C = 2;
+uint16_t SizeLong_C = 300;
+uint16_t SizeLink_C = 18;
 
 /**
  * START of Section BLE_DRIVER_CONTEXT
@@ -110,8 +117,104 @@ do {\
 #define COPY_LED_SERVER_UUID(uuid_struct)          COPY_UUID_128(uuid_struct,0x00,0x00,0xfe,0x40,0xcc,0x7a,0x48,0x2a,0x98,0x4a,0x7f,0x2e,0xd5,0xb3,0xe5,0x8f)
 #define COPY_BLUE_LED_CHAR_UUID(uuid_struct)    COPY_UUID_128(uuid_struct,0x00,0x00,0xfe,0x41,0x8e,0x22,0x45,0x41,0x9d,0x4c,0x21,0xed,0xae,0x82,0xed,0x19)
 #define COPY_MY_SWITCH_CHAR_UUID(uuid_struct)    COPY_UUID_128(uuid_struct,0x00,0x00,0xfe,0x42,0x8e,0x22,0x45,0x41,0x9d,0x4c,0x21,0xed,0xae,0x82,0xed,0x19)
+#define COPY_MYLONGCHAR_UUID(uuid_struct)    COPY_UUID_128(uuid_struct,0x00,0x00,0xfe,0x43,0x8e,0x22,0x45,0x41,0x9d,0x4c,0x21,0xed,0xae,0x82,0xed,0x19)
+#define COPY_LINKINFOCHAR_UUID(uuid_struct)    COPY_UUID_128(uuid_struct,0x00,0x00,0xfe,0x44,0x8e,0x22,0x45,0x41,0x9d,0x4c,0x21,0xed,0xae,0x82,0xed,0x19)
 
 /* USER CODE BEGIN PF */
+/**
+ * @brief  Notify a MyLongChar value without tracing every call; meant for
+ *         frames sent back to back
+ * @param  pPayload: Characteristic value
+ * @param  size: Length of the characteristic value in octets, at most 249
+ * @retval BLE_STATUS_INSUFFICIENT_RESOURCES while the controller has no
+ *         free TX buffer, in which case the value can be sent again later
+ */
+tBleStatus Custom_STM_App_Notify_Long_C(uint8_t *pPayload, uint8_t size)
+{
+  tBleStatus ret;
+
+  ret = aci_gatt_update_char_value(CustomContext.CustomLedsHdle,
+                                   CustomContext.CustomLong_CHdle,
+                                   0, /* charValOffset */
+                                   size, /* charValueLen */
+                                   (uint8_t *)  pPayload);
+  if ((ret != BLE_STATUS_SUCCESS) && (ret != BLE_STATUS_INSUFFICIENT_RESOURCES))
+  {
+    APP_DBG_MSG("  Fail   : aci_gatt_update_char_value LONG_C command, result : 0x%x \n\r", ret);
+  }
+
+  return ret;
+}
+
+/**
+ * @brief  Log an update queued by Custom_STM_App_Update_Char_Async that failed
+ */
+static void Custom_STM_Update_Char_Done(uint16_t opcode, const uint8_t *p_rparam, uint8_t rlen, void *p_ctx)
+{
+  if ((p_rparam == NULL) || (rlen == 0) || (p_rparam[0] != BLE_STATUS_SUCCESS))
+  {
+    APP_DBG_MSG("  Fail   : aci_gatt_update_char_value async command, char %d, result : 0x%x \n\r",
+                (int)(uintptr_t)p_ctx, ((p_rparam != NULL) && (rlen != 0)) ? p_rparam[0] : 0xFF);
+  }
+}
+
+/**
+ * @brief  Characteristic update queued without waiting for CPU2; updates
+ *         are sent in order, one per mailbox round trip, while the
+ *         application keeps running
+ * @param  CharOpcode: Characteristic identifier
+ * @param  pPayload: Characteristic value, copied before returning
+ * @retval BLE_STATUS_INSUFFICIENT_RESOURCES when the command queue is full
+ */
+tBleStatus Custom_STM_App_Update_Char_Async(Custom_STM_Char_Opcode_t CharOpcode, uint8_t *pPayload)
+{
+  uint8_t cmd_buffer[BLE_CMD_MAX_PARAM_LEN];
+  aci_gatt_update_char_value_cp0 *cp0 = (aci_gatt_update_char_value_cp0 *)cmd_buffer;
+  uint16_t size;
+
+  switch (CharOpcode)
+  {
+    case CUSTOM_STM_B_LED_C:
+      cp0->Char_Handle = CustomContext.CustomB_Led_CHdle;
+      size = SizeB_Led_C;
+      break;
+
+    case CUSTOM_STM_SWITCH_C:
+      cp0->Char_Handle = CustomContext.CustomSwitch_CHdle;
+      size = SizeSwitch_C;
+      break;
+
+    case CUSTOM_STM_LONG_C:
+      cp0->Char_Handle = CustomContext.CustomLong_CHdle;
+      size = SizeLong_C;
+      break;
+
+    case CUSTOM_STM_LINK_C:
+      cp0->Char_Handle = CustomContext.CustomLink_CHdle;
+      size = SizeLink_C;
+      break;
+
+    default:
+      return BLE_STATUS_INVALID_PARAMS;
+  }
+  if (size > sizeof(cp0->Char_Value))
+  {
+    return BLE_STATUS_INVALID_PARAMS;
+  }
+
+  cp0->Service_Handle = CustomContext.CustomLedsHdle;
+  cp0->Val_Offset = 0;
+  cp0->Char_Value_Length = (uint8_t)size;
+  memcpy(cp0->Char_Value, pPayload, size);
+
+  if (hci_send_req_async(ACI_GATT_UPDATE_CHAR_VALUE_OGF, ACI_GATT_UPDATE_CHAR_VALUE_OCF,
+                         cmd_buffer, ACI_GATT_UPDATE_CHAR_VALUE_HEADER + size,
+                         Custom_STM_Update_Char_Done, (void *)(uintptr_t)CharOpcode) < 0)
+  {
+    return BLE_STATUS_INSUFFICIENT_RESOURCES;
+  }
+  return BLE_STATUS_SUCCESS;
+}
 
 /* USER CODE END PF */
 
@@ -208,6 +311,50 @@ static SVCCTL_EvtAckStatus_t Custom_STM_Event_Handler(void *Event)
             Custom_STM_App_Notification(&Notification);
             /* USER CODE END CUSTOM_STM_Service_1_Char_1_ACI_GATT_ATTRIBUTE_MODIFIED_VSEVT_CODE */
           } /* if (attribute_modified->Attr_Handle == (CustomContext.CustomB_Led_CHdle + CHARACTERISTIC_VALUE_ATTRIBUTE_OFFSET))*/
+
+          else if (attribute_modified->Attr_Handle == (CustomContext.CustomLong_CHdle + CHARACTERISTIC_DESCRIPTOR_ATTRIBUTE_OFFSET))
+          {
+            return_value = SVCCTL_EvtAckFlowEnable;
+            /* USER CODE BEGIN CUSTOM_STM_Service_1_Char_3 */
+
+            /* USER CODE END CUSTOM_STM_Service_1_Char_3 */
+            switch (attribute_modified->Attr_Data[0])
+            {
+              /* USER CODE BEGIN CUSTOM_STM_Service_1_Char_3_attribute_modified */
+
+              /* USER CODE END CUSTOM_STM_Service_1_Char_3_attribute_modified */
+
+              /* Disabled Notification management */
+              case (!(COMSVC_Notification)):
+                /* USER CODE BEGIN CUSTOM_STM_Service_1_Char_3_Disabled_BEGIN */
+
+                /* USER CODE END CUSTOM_STM_Service_1_Char_3_Disabled_BEGIN */
+                Notification.Custom_Evt_Opcode = CUSTOM_STM_LONG_C_NOTIFY_DISABLED_EVT;
+                Custom_STM_App_Notification(&Notification);
+                /* USER CODE BEGIN CUSTOM_STM_Service_1_Char_3_Disabled_END */
+
+                /* USER CODE END CUSTOM_STM_Service_1_Char_3_Disabled_END */
+                break;
+
+              /* Enabled Notification management */
+              case COMSVC_Notification:
+                /* USER CODE BEGIN CUSTOM_STM_Service_1_Char_3_COMSVC_Notification_BEGIN */
+
+                /* USER CODE END CUSTOM_STM_Service_1_Char_3_COMSVC_Notification_BEGIN */
+                Notification.Custom_Evt_Opcode = CUSTOM_STM_LONG_C_NOTIFY_ENABLED_EVT;
+                Custom_STM_App_Notification(&Notification);
+                /* USER CODE BEGIN CUSTOM_STM_Service_1_Char_3_COMSVC_Notification_END */
+
+                /* USER CODE END CUSTOM_STM_Service_1_Char_3_COMSVC_Notification_END */
+                break;
+
+              default:
+                /* USER CODE BEGIN CUSTOM_STM_Service_1_Char_3_default */
+
+                /* USER CODE END CUSTOM_STM_Service_1_Char_3_default */
+              break;
+            }
+          }  /* if (attribute_modified->Attr_Handle == (CustomContext.CustomLong_CHdle + CHARACTERISTIC_DESCRIPTOR_ATTRIBUTE_OFFSET))*/
           /* USER CODE BEGIN EVT_BLUE_GATT_ATTRIBUTE_MODIFIED_END */
 
           /* USER CODE END EVT_BLUE_GATT_ATTRIBUTE_MODIFIED_END */
@@ -304,17 +451,20 @@ void SVCCTL_InitCustomSvc(void)
   /**
    *          LED_Server
    *
-   * Max_Attribute_Records = 1 + 2*2 + 1*no_of_char_with_notify_or_indicate_property + 1*no_of_char_with_broadcast_property
+   * Max_Attribute_Records = 1 + 2*4 + 1*no_of_char_with_notify_or_indicate_property + 1*no_of_char_with_broadcast_property
    * service_max_attribute_record = 1 for LED_Server +
    *                                2 for BLUE_LED_Char +
    *                                2 for My_Switch_Char +
    *                                1 for My_Switch_Char configuration descriptor +
-   *                              = 6
+   *                                2 for MyLongChar +
+   *                                1 for MyLongChar configuration descriptor +
+   *                                2 for LinkInfoChar +
+   *                              = 11
    *
    * This value doesn't take into account number of descriptors manually added
    * In case of descriptors added, please update the max_attr_record value accordingly in the next SVCCTL_InitService User Section
    */
-  max_attr_record = 6;
+  max_attr_record = 11;
 
   /* USER CODE BEGIN SVCCTL_InitService1 */
     /* max_attr_record to be updated if descriptors have been added */
@@ -388,9 +538,64 @@ void SVCCTL_InitCustomSvc(void)
   /* Place holder for Characteristic Descriptors */
 
   /* USER CODE END SVCCTL_Init_Service1_Char2 */
+  /**
+   *  MyLongChar
+   */
+  COPY_MYLONGCHAR_UUID(uuid.Char_UUID_128);
+  ret = aci_gatt_add_char(CustomContext.CustomLedsHdle,
+                          UUID_TYPE_128, &uuid,
+                          SizeLong_C,
+                          CHAR_PROP_NOTIFY,
+                          ATTR_PERMISSION_NONE,
+                          GATT_NOTIFY_ATTRIBUTE_WRITE,
+                          0x10,
+                          CHAR_VALUE_LEN_VARIABLE,
+                          &(CustomContext.CustomLong_CHdle));
+  if (ret != BLE_STATUS_SUCCESS)
+  {
+    APP_DBG_MSG("  Fail   : aci_gatt_add_char command   : LONG_C, error code: 0x%x \n\r", ret);
+  }
+  else
+  {
+    APP_DBG_MSG("  Success: aci_gatt_add_char command   : LONG_C , handle = 0x%04x \n\r", CustomContext.CustomLong_CHdle);
+  }
 
-  /* USER CODE BEGIN SVCCTL_InitCustomSvc_2 */
+  /* USER CODE BEGIN SVCCTL_Init_Service1_Char3 */
+  /* Place holder for Characteristic Descriptors */
 
+  /* USER CODE END SVCCTL_Init_Service1_Char3 */
+  /**
+   *  LinkInfoChar
+   */
+  COPY_LINKINFOCHAR_UUID(uuid.Char_UUID_128);
+  ret = aci_gatt_add_char(CustomContext.CustomLedsHdle,
+                          UUID_TYPE_128, &uuid,
+                          SizeLink_C,
+                          CHAR_PROP_READ,
+                          ATTR_PERMISSION_NONE,
+                          GATT_DONT_NOTIFY_EVENTS,
+                          0x10,
+                          CHAR_VALUE_LEN_CONSTANT,
+                          &(CustomContext.CustomLink_CHdle));
+  if (ret != BLE_STATUS_SUCCESS)
+  {
+    APP_DBG_MSG("  Fail   : aci_gatt_add_char command   : LINK_C, error code: 0x%x \n\r", ret);
+  }
+  else
+  {
+    APP_DBG_MSG("  Success: aci_gatt_add_char command   : LINK_C , handle = 0x%04x \n\r", CustomContext.CustomLink_CHdle);
+  }
+
+  /* USER CODE BEGIN SVCCTL_Init_Service1_Char4 */
+  /* Place holder for Characteristic Descriptors */
+
+  /* USER CODE END SVCCTL_Init_Service1_Char4 */
+
+  /* USER CODE BEGIN SVCCTL_InitCustomSvc_2 */
+  /* Route the GATT events on the LEDS handles without asking the other services */
+  SVCCTL_RegisterSvcHandleRange(CustomContext.CustomLedsHdle,
+                                CustomContext.CustomLedsHdle + max_attr_record - 1,
+                                Custom_STM_Event_Handler);
   /* USER CODE END SVCCTL_InitCustomSvc_2 */
 
   return;
@@ -452,6 +657,42 @@ tBleStatus Custom_STM_App_Update_Char(Custom_STM_Char_Opcode_t CharOpcode, uint8
       /* USER CODE END CUSTOM_STM_App_Update_Service_1_Char_2*/
       break;
 
+    case CUSTOM_STM_LONG_C:
+      /* SizeLong_C does not fit the 8-bit length of aci_gatt_update_char_value:
+         the value is written in parts, 0x0000 notifies every connected client */
+      ret = Generic_STM_App_Update_Char_Ext(0x0000, CustomContext.CustomLedsHdle, CustomContext.CustomLong_CHdle, SizeLong_C, pPayload);
+      if (ret != BLE_STATUS_SUCCESS)
+      {
+        APP_DBG_MSG("  Fail   : Generic_STM_App_Update_Char_Ext LONG_C command, result : 0x%x \n\r", ret);
+      }
+      else
+      {
+        APP_DBG_MSG("  Success: Generic_STM_App_Update_Char_Ext LONG_C command\n\r");
+      }
+      /* USER CODE BEGIN CUSTOM_STM_App_Update_Service_1_Char_3*/
+
+      /* USER CODE END CUSTOM_STM_App_Update_Service_1_Char_3*/
+      break;
+
+    case CUSTOM_STM_LINK_C:
+      ret = aci_gatt_update_char_value(CustomContext.CustomLedsHdle,
+                                       CustomContext.CustomLink_CHdle,
+                                       0, /* charValOffset */
+                                       SizeLink_C, /* charValueLen */
+                                       (uint8_t *)  pPayload);
+      if (ret != BLE_STATUS_SUCCESS)
+      {
+        APP_DBG_MSG("  Fail   : aci_gatt_update_char_value LINK_C command, result : 0x%x \n\r", ret);
+      }
+      else
+      {
+        APP_DBG_MSG("  Success: aci_gatt_update_char_value LINK_C command\n\r");
+      }
+      /* USER CODE BEGIN CUSTOM_STM_App_Update_Service_1_Char_4*/
+
+      /* USER CODE END CUSTOM_STM_App_Update_Service_1_Char_4*/
+      break;
+
     default:
       break;
   }
@@ -518,6 +759,44 @@ tBleStatus Custom_STM_App_Update_Char_Variable_Length(Custom_STM_Char_Opcode_t C
       /* USER CODE END Custom_STM_App_Update_Char_Variable_Length_Service_1_Char_2*/
       break;
 
+    case CUSTOM_STM_LONG_C:
+      ret = aci_gatt_update_char_value(CustomContext.CustomLedsHdle,
+                                       CustomContext.CustomLong_CHdle,
+                                       0, /* charValOffset */
+                                       size, /* charValueLen */
+                                       (uint8_t *)  pPayload);
+      if (ret != BLE_STATUS_SUCCESS)
+      {
+        APP_DBG_MSG("  Fail   : aci_gatt_update_char_value LONG_C command, result : 0x%x \n\r", ret);
+      }
+      else
+      {
+        APP_DBG_MSG("  Success: aci_gatt_update_char_value LONG_C command\n\r");
+      }
+      /* USER CODE BEGIN Custom_STM_App_Update_Char_Variable_Length_Service_1_Char_3*/
+
+      /* USER CODE END Custom_STM_App_Update_Char_Variable_Length_Service_1_Char_3*/
+      break;
+
+    case CUSTOM_STM_LINK_C:
+      ret = aci_gatt_update_char_value(CustomContext.CustomLedsHdle,
+                                       CustomContext.CustomLink_CHdle,
+                                       0, /* charValOffset */
+                                       size, /* charValueLen */
+                                       (uint8_t *)  pPayload);
+      if (ret != BLE_STATUS_SUCCESS)
+      {
+        APP_DBG_MSG("  Fail   : aci_gatt_update_char_value LINK_C command, result : 0x%x \n\r", ret);
+      }
+      else
+      {
+        APP_DBG_MSG("  Success: aci_gatt_update_char_value LINK_C command\n\r");
+      }
+      /* USER CODE BEGIN Custom_STM_App_Update_Char_Variable_Length_Service_1_Char_4*/
+
+      /* USER CODE END Custom_STM_App_Update_Char_Variable_Length_Service_1_Char_4*/
+      break;
+
     default:
       break;
   }
@@ -578,6 +857,38 @@ tBleStatus Custom_STM_App_Update_Char_Ext(uint16_t Connection_Handle, Custom_STM
       }
       break;
 
+    case CUSTOM_STM_LONG_C:
+      /* USER CODE BEGIN Updated_Length_Service_1_Char_3*/
+
+      /* USER CODE END Updated_Length_Service_1_Char_3*/
+      ret = Generic_STM_App_Update_Char_Ext(Connection_Handle, CustomContext.CustomLedsHdle, CustomContext.CustomLong_CHdle, SizeLong_C, pPayload);
+
+      if (ret != BLE_STATUS_SUCCESS)
+      {
+        APP_DBG_MSG("  Fail   : Generic_STM_App_Update_Char_Ext command, result : 0x%x \n\r", ret);
+      }
+      else
+      {
+        APP_DBG_MSG("  Success: Generic_STM_App_Update_Char_Ext command\n\r");
+      }
+      break;
+
+    case CUSTOM_STM_LINK_C:
+      /* USER CODE BEGIN Updated_Length_Service_1_Char_4*/
+
+      /* USER CODE END Updated_Length_Service_1_Char_4*/
+      ret = Generic_STM_App_Update_Char_Ext(Connection_Handle, CustomContext.CustomLedsHdle, CustomContext.CustomLink_CHdle, SizeLink_C, pPayload);
+
+      if (ret != BLE_STATUS_SUCCESS)
+      {
+        APP_DBG_MSG("  Fail   : Generic_STM_App_Update_Char_Ext command, result : 0x%x \n\r", ret);
+      }
+      else
+      {
+        APP_DBG_MSG("  Success: Generic_STM_App_Update_Char_Ext command\n\r");
+      }
+      break;
+
     default:
       break;
   }
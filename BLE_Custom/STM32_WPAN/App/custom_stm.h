@@ -37,6 +37,8 @@ typedef enum
   /* LED_Server */
   CUSTOM_STM_B_LED_C,
   CUSTOM_STM_SWITCH_C,
+  CUSTOM_STM_LONG_C,
+  CUSTOM_STM_LINK_C,
 } Custom_STM_Char_Opcode_t;
 
 typedef enum
@@ -47,6 +49,11 @@ typedef enum
   /* My_Switch_Char */
   CUSTOM_STM_SWITCH_C_NOTIFY_ENABLED_EVT,
   CUSTOM_STM_SWITCH_C_NOTIFY_DISABLED_EVT,
+  /* MyLongChar */
+  CUSTOM_STM_LONG_C_NOTIFY_ENABLED_EVT,
+  CUSTOM_STM_LONG_C_NOTIFY_DISABLED_EVT,
+  /* LinkInfoChar */
+  CUSTOM_STM_LINK_C_READ_EVT,
   CUSTOM_STM_NOTIFICATION_COMPLETE_EVT,
 
   CUSTOM_STM_BOOT_REQUEST_EVT
@@ -55,7 +62,7 @@ typedef enum
 typedef struct
 {
   uint8_t * pPayload;
-  uint8_t   Length;
+  uint16_t  Length;
 } Custom_STM_Data_t;
 
 typedef struct
@@ -93,6 +100,8 @@ typedef enum
 /* Exported constants --------------------------------------------------------*/
 extern uint16_t SizeB_Led_C;
 extern uint16_t SizeSwitch_C;
+extern uint16_t SizeLong_C;
+extern uint16_t SizeLink_C;
 
 /* USER CODE BEGIN EC */
 
@@ -115,6 +124,8 @@ tBleStatus Custom_STM_App_Update_Char(Custom_STM_Char_Opcode_t CharOpcode,  uint
 tBleStatus Custom_STM_App_Update_Char_Variable_Length(Custom_STM_Char_Opcode_t CharOpcode, uint8_t *pPayload, uint8_t size);
 tBleStatus Custom_STM_App_Update_Char_Ext(uint16_t Connection_Handle, Custom_STM_Char_Opcode_t CharOpcode, uint8_t *pPayload);
 /* USER CODE BEGIN EF */
+tBleStatus Custom_STM_App_Notify_Long_C(uint8_t *pPayload, uint8_t size);
+tBleStatus Custom_STM_App_Update_Char_Async(Custom_STM_Char_Opcode_t CharOpcode, uint8_t *pPayload);
 
 /* USER CODE END EF */
 
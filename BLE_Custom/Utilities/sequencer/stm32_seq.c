@@ -108,6 +108,35 @@ typedef struct
 #define UTIL_SEQ_MEMSET8( dest, value, size )   UTILS_MEMSET8( dest, value, size )
 #endif /* UTIL_SEQ_MEMSET8 */
 
+/**
+  * @brief the task profiler is disabled by default.
+  */
+#ifndef UTIL_SEQ_CONF_PROFILER
+#define UTIL_SEQ_CONF_PROFILER  (0)
+#endif /* UTIL_SEQ_CONF_PROFILER */
+
+#if (UTIL_SEQ_CONF_PROFILER != 0)
+#ifndef UTIL_SEQ_PROFILER_GET_CYCLES
+#error "UTIL_SEQ_PROFILER_GET_CYCLES shall be defined when UTIL_SEQ_CONF_PROFILER is set"
+#endif /* UTIL_SEQ_PROFILER_GET_CYCLES */
+#ifndef UTIL_SEQ_PROFILER_INIT
+#define UTIL_SEQ_PROFILER_INIT( )
+#endif /* UTIL_SEQ_PROFILER_INIT */
+#endif /* UTIL_SEQ_CONF_PROFILER */
+
+/**
+  * @brief the earliest deadline first selection is disabled by default.
+  */
+#ifndef UTIL_SEQ_CONF_EDF
+#define UTIL_SEQ_CONF_EDF  (0)
+#endif /* UTIL_SEQ_CONF_EDF */
+
+#if (UTIL_SEQ_CONF_EDF != 0)
+#ifndef UTIL_SEQ_EDF_GET_TIME
+#error "UTIL_SEQ_EDF_GET_TIME shall be defined when UTIL_SEQ_CONF_EDF is set"
+#endif /* UTIL_SEQ_EDF_GET_TIME */
+#endif /* UTIL_SEQ_CONF_EDF */
+
 /**
   * @}
   */
@@ -164,6 +193,40 @@ static volatile UTIL_SEQ_Priority_t TaskPrio[UTIL_SEQ_CONF_PRIO_NBR];
   */
 static UTIL_SEQ_bm_t  TaskClearList = 0;
 
+#if (UTIL_SEQ_CONF_PROFILER != 0)
+/**
+  * @brief execution profile of the tasks.
+  */
+static UTIL_SEQ_TaskProfile_t TaskProfile[UTIL_SEQ_CONF_TASK_NBR];
+
+/**
+  * @brief time at which each pending task has been set.
+  */
+static uint32_t TaskSetTime[UTIL_SEQ_CONF_TASK_NBR];
+
+/**
+  * @brief run time of the tasks executed inside the running one (UTIL_SEQ_WaitEvt()).
+  */
+static uint32_t TaskNestedCycles = 0;
+#endif /* UTIL_SEQ_CONF_PROFILER */
+
+#if (UTIL_SEQ_CONF_EDF != 0)
+/**
+  * @brief pending tasks that have a deadline.
+  */
+static volatile UTIL_SEQ_bm_t TaskDeadlineSet = UTIL_SEQ_NO_BIT_SET;
+
+/**
+  * @brief deadline of each task of TaskDeadlineSet, in UTIL_SEQ_EDF_GET_TIME() units.
+  */
+static uint32_t TaskDeadline[UTIL_SEQ_CONF_TASK_NBR];
+
+/**
+  * @brief number of tasks executed after their deadline.
+  */
+static uint32_t TaskDeadlineMissed = 0;
+#endif /* UTIL_SEQ_CONF_EDF */
+
 /**
   * @}
   */
@@ -173,6 +236,9 @@ static UTIL_SEQ_bm_t  TaskClearList = 0;
   *  @{
   */
 uint8_t SEQ_BitPosition(uint32_t Value);
+#if (UTIL_SEQ_CONF_EDF != 0)
+static uint32_t SEQ_EarliestDeadline(UTIL_SEQ_bm_t TaskSet_bm);
+#endif /* UTIL_SEQ_CONF_EDF */
 
 /**
   * @}
@@ -200,6 +266,14 @@ void UTIL_SEQ_Init( void )
     }
     UTIL_SEQ_INIT_CRITICAL_SECTION( );
     TaskClearList = 0;
+#if (UTIL_SEQ_CONF_EDF != 0)
+    TaskDeadlineSet = UTIL_SEQ_NO_BIT_SET;
+    TaskDeadlineMissed = 0;
+#endif /* UTIL_SEQ_CONF_EDF */
+#if (UTIL_SEQ_CONF_PROFILER != 0)
+    UTIL_SEQ_PROFILER_INIT( );
+    UTIL_SEQ_ResetProfile( );
+#endif /* UTIL_SEQ_CONF_PROFILER */
 }
 
 void UTIL_SEQ_DeInit( void )
@@ -223,6 +297,16 @@ void UTIL_SEQ_Run( UTIL_SEQ_bm_t Mask_bm )
     UTIL_SEQ_bm_t local_evtwaited;
     uint32_t round_robin[UTIL_SEQ_CONF_PRIO_NBR];
     UTIL_SEQ_bm_t  task_starving_list;
+#if (UTIL_SEQ_CONF_EDF != 0)
+    UTIL_SEQ_bm_t  task_deadline_list;
+#endif /* UTIL_SEQ_CONF_EDF */
+#if (UTIL_SEQ_CONF_PROFILER != 0)
+    uint32_t task_start;
+    uint32_t task_elapsed;
+    uint32_t task_self;
+    uint32_t nested_backup;
+    UTIL_SEQ_TaskProfile_t *p_profile;
+#endif /* UTIL_SEQ_CONF_PROFILER */
 
     /*
      * When this function is nested, the mask to be applied cannot be larger than the first call
@@ -258,6 +342,13 @@ void UTIL_SEQ_Run( UTIL_SEQ_bm_t Mask_bm )
 
         current_task_set = TaskPrio[counter].priority & local_taskmask & SuperMask;
 
+#if (UTIL_SEQ_CONF_EDF != 0)
+        /*
+         * The tasks of this priority that have a deadline go first, regardless of the round robin
+         */
+        task_deadline_list = current_task_set & TaskDeadlineSet;
+#endif /* UTIL_SEQ_CONF_EDF */
+
         /*
          * The round_robin register is a mask of allowed flags to be evaluated.
          * The concept is to make sure that on each round on UTIL_SEQ_Run(), if two same flags are always set,
@@ -320,11 +411,23 @@ void UTIL_SEQ_Run( UTIL_SEQ_bm_t Mask_bm )
          * Once the index is read, the associated task will be executed even though a higher priority stack is requested
          * before task execution.
          */
-        CurrentTaskIdx = (SEQ_BitPosition(current_task_set & TaskPrio[counter].round_robin));
+#if (UTIL_SEQ_CONF_EDF != 0)
+        if (task_deadline_list != 0U)
+        {
+          CurrentTaskIdx = SEQ_EarliestDeadline(task_deadline_list);
+        }
+        else
+#endif /* UTIL_SEQ_CONF_EDF */
+        {
+          CurrentTaskIdx = (SEQ_BitPosition(current_task_set & TaskPrio[counter].round_robin));
+        }
 
         UTIL_SEQ_ENTER_CRITICAL_SECTION( );
         /* remove from the list or pending task the one that has been selected to be executed */
         TaskSet &= ~(1U << CurrentTaskIdx);
+#if (UTIL_SEQ_CONF_EDF != 0)
+        TaskDeadlineSet &= ~(1U << CurrentTaskIdx);
+#endif /* UTIL_SEQ_CONF_EDF */
 
         /*
          * remove from all priority mask the task that has been selected to be executed
@@ -351,9 +454,37 @@ void UTIL_SEQ_Run( UTIL_SEQ_bm_t Mask_bm )
             round_robin[index] = TaskPrio[index].round_robin;
           }
 
+#if (UTIL_SEQ_CONF_PROFILER != 0)
+          p_profile = &TaskProfile[CurrentTaskIdx];
+          task_start = UTIL_SEQ_PROFILER_GET_CYCLES( );
+          task_elapsed = task_start - TaskSetTime[CurrentTaskIdx];
+          p_profile->TotalLatency += task_elapsed;
+          if (task_elapsed > p_profile->MaxLatency)
+          {
+            p_profile->MaxLatency = task_elapsed;
+          }
+          nested_backup = TaskNestedCycles;
+          TaskNestedCycles = 0U;
+#endif /* UTIL_SEQ_CONF_PROFILER */
+
           /* Execute the task */
           TaskCb[CurrentTaskIdx]( );
 
+#if (UTIL_SEQ_CONF_PROFILER != 0)
+          /*
+           * CurrentTaskIdx may have been changed by a nested UTIL_SEQ_Run(), p_profile is used instead
+           */
+          task_elapsed = UTIL_SEQ_PROFILER_GET_CYCLES( ) - task_start;
+          task_self = task_elapsed - TaskNestedCycles;
+          TaskNestedCycles = nested_backup + task_elapsed;
+          p_profile->RunCount++;
+          p_profile->TotalCycles += task_self;
+          if (task_self > p_profile->MaxCycles)
+          {
+            p_profile->MaxCycles = task_self;
+          }
+#endif /* UTIL_SEQ_CONF_PROFILER */
+
           /*
            * restore the round-robin context
            */
@@ -440,8 +571,26 @@ uint32_t UTIL_SEQ_IsRegisteredTask(UTIL_SEQ_bm_t TaskId_bm )
 
 void UTIL_SEQ_SetTask( UTIL_SEQ_bm_t TaskId_bm, uint32_t Task_Prio )
 {
+#if (UTIL_SEQ_CONF_PROFILER != 0)
+    UTIL_SEQ_bm_t new_task_bm;
+    uint32_t now;
+#endif /* UTIL_SEQ_CONF_PROFILER */
+
     UTIL_SEQ_ENTER_CRITICAL_SECTION( );
 
+#if (UTIL_SEQ_CONF_PROFILER != 0)
+    /*
+     * The latency is counted from the first request of a task not pending yet
+     */
+    now = UTIL_SEQ_PROFILER_GET_CYCLES( );
+    new_task_bm = TaskId_bm & ~TaskSet;
+    while (new_task_bm != 0U)
+    {
+      TaskSetTime[SEQ_BitPosition(new_task_bm)] = now;
+      new_task_bm &= new_task_bm - 1U;
+    }
+#endif /* UTIL_SEQ_CONF_PROFILER */
+
     TaskSet |= TaskId_bm;
     TaskPrio[Task_Prio].priority |= TaskId_bm;
 
@@ -618,6 +767,70 @@ __WEAK void UTIL_SEQ_PostTask( uint32_t TaskId )
     return;
 }
 
+void UTIL_SEQ_SetTaskDeadline( UTIL_SEQ_bm_t TaskId_bm, uint32_t Task_Prio, uint32_t Deadline )
+{
+#if (UTIL_SEQ_CONF_EDF != 0)
+    UTIL_SEQ_bm_t task_bm;
+    uint32_t deadline;
+    uint32_t index;
+
+    UTIL_SEQ_ENTER_CRITICAL_SECTION( );
+
+    deadline = UTIL_SEQ_EDF_GET_TIME( ) + Deadline;
+    task_bm = TaskId_bm;
+    while (task_bm != 0U)
+    {
+      index = SEQ_BitPosition(task_bm);
+      if (((TaskDeadlineSet & (1U << index)) == 0U) || ((int32_t)(deadline - TaskDeadline[index]) < 0))
+      {
+        TaskDeadline[index] = deadline;
+      }
+      task_bm &= ~(1U << index);
+    }
+    TaskDeadlineSet |= TaskId_bm;
+
+    /* the critical section is nested, the task is set with the deadline */
+    UTIL_SEQ_SetTask( TaskId_bm, Task_Prio );
+
+    UTIL_SEQ_EXIT_CRITICAL_SECTION( );
+#else
+    (void)Deadline;
+    UTIL_SEQ_SetTask( TaskId_bm, Task_Prio );
+#endif /* UTIL_SEQ_CONF_EDF */
+
+    return;
+}
+
+uint32_t UTIL_SEQ_GetDeadlineMissed( void )
+{
+#if (UTIL_SEQ_CONF_EDF != 0)
+    return TaskDeadlineMissed;
+#else
+    return 0U;
+#endif /* UTIL_SEQ_CONF_EDF */
+}
+
+const UTIL_SEQ_TaskProfile_t *UTIL_SEQ_GetTaskProfile( uint32_t TaskId )
+{
+#if (UTIL_SEQ_CONF_PROFILER != 0)
+    if (TaskId < UTIL_SEQ_CONF_TASK_NBR)
+    {
+      return &TaskProfile[TaskId];
+    }
+#else
+    (void)TaskId;
+#endif /* UTIL_SEQ_CONF_PROFILER */
+    return NULL;
+}
+
+void UTIL_SEQ_ResetProfile( void )
+{
+#if (UTIL_SEQ_CONF_PROFILER != 0)
+    (void)UTIL_SEQ_MEMSET8((uint8_t *)TaskProfile, 0, sizeof(TaskProfile));
+#endif /* UTIL_SEQ_CONF_PROFILER */
+    return;
+}
+
 __WEAK void UTIL_SEQ_CatchWarning(UTIL_SEQ_WARNING WarningId)
 {
     (void)WarningId;
@@ -676,6 +889,43 @@ uint8_t SEQ_BitPosition(uint32_t Value)
 }
 #endif /* __CORTEX_M == 0 */
 
+#if (UTIL_SEQ_CONF_EDF != 0)
+/**
+  * @brief return the task with the earliest deadline and count it when it is already late
+  * @param TaskSet_bm tasks to choose from, all in TaskDeadlineSet
+  * @retval the task index
+  */
+static uint32_t SEQ_EarliestDeadline(UTIL_SEQ_bm_t TaskSet_bm)
+{
+    uint32_t now = UTIL_SEQ_EDF_GET_TIME( );
+    uint32_t index;
+    uint32_t earliest_index = 0U;
+    int32_t left;
+    int32_t earliest_left = INT32_MAX;
+
+    /*
+     * deadlines are compared as a time left from now so that the wrap of the time base does not matter
+     */
+    while (TaskSet_bm != 0U)
+    {
+      index = SEQ_BitPosition(TaskSet_bm);
+      left = (int32_t)(TaskDeadline[index] - now);
+      if (left <= earliest_left)
+      {
+        earliest_left = left;
+        earliest_index = index;
+      }
+      TaskSet_bm &= ~(1U << index);
+    }
+
+    if (earliest_left < 0)
+    {
+      TaskDeadlineMissed++;
+    }
+    return earliest_index;
+}
+#endif /* UTIL_SEQ_CONF_EDF */
+
 /**
   * @}
   */
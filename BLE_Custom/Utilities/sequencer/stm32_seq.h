@@ -50,6 +50,19 @@ typedef enum {
 	UTIL_SEQ_WARNING_INVALIDTASKID,
 }UTIL_SEQ_WARNING;
 
+/**
+  *  @brief  execution profile of a task, recorded when UTIL_SEQ_CONF_PROFILER is set.
+  *  Times are in UTIL_SEQ_PROFILER_GET_CYCLES() units. The run time of a task excludes the tasks
+  *  run from it through UTIL_SEQ_WaitEvt().
+  */
+typedef struct {
+    uint32_t RunCount;      /*!<number of runs.                                          */
+    uint32_t MaxCycles;     /*!<longest run.                                             */
+    uint64_t TotalCycles;   /*!<cumulated run time.                                      */
+    uint32_t MaxLatency;    /*!<longest time from UTIL_SEQ_SetTask() to the run.         */
+    uint64_t TotalLatency;  /*!<cumulated time from UTIL_SEQ_SetTask() to the run.       */
+}UTIL_SEQ_TaskProfile_t;
+
 /**
   * @}
  */
@@ -242,6 +255,23 @@ uint32_t UTIL_SEQ_IsRegisteredTask( UTIL_SEQ_bm_t TaskId_bm );
   */
 void UTIL_SEQ_SetTask( UTIL_SEQ_bm_t TaskId_bm, uint32_t Task_Prio );
 
+/**
+  * @brief This function requests a task to be executed before a deadline
+  *
+  * @param TaskId_bm The Id of the task
+  *        It shall be (1<<task_id) where task_id is the number assigned when the task has been registered
+  * @param Task_Prio The priority of the task, as in UTIL_SEQ_SetTask()
+  * @param Deadline The time left to run the task, in UTIL_SEQ_EDF_GET_TIME() units
+  *
+  * @note   Within a priority, the tasks with a deadline are executed before the others, earliest
+  *         deadline first. When the task is already pending with a deadline, the earliest one is kept.
+  *         Without UTIL_SEQ_CONF_EDF, it is the same as UTIL_SEQ_SetTask().
+  *
+  * @note   It may be called from an ISR
+  *
+  */
+void UTIL_SEQ_SetTaskDeadline( UTIL_SEQ_bm_t TaskId_bm, uint32_t Task_Prio, uint32_t Deadline );
+
 /**
   * @brief This function checks if a task could be scheduled.
   *
@@ -389,6 +419,26 @@ void UTIL_SEQ_PostTask( uint32_t TaskId );
   */
 void UTIL_SEQ_CatchWarning(UTIL_SEQ_WARNING WarningId);
 
+/**
+  * @brief This function returns the execution profile of a task
+  * @param TaskId The task id.
+  * @retval the profile, NULL when UTIL_SEQ_CONF_PROFILER is not set or the id is out of range
+  *
+  * @note  the counters are updated by the sequencer while they are read
+  */
+const UTIL_SEQ_TaskProfile_t *UTIL_SEQ_GetTaskProfile( uint32_t TaskId );
+
+/**
+  * @brief This function clears the execution profile of all the tasks
+  */
+void UTIL_SEQ_ResetProfile( void );
+
+/**
+  * @brief This function returns the number of tasks executed after their deadline
+  * @retval the number of missed deadlines, always 0 when UTIL_SEQ_CONF_EDF is not set
+  */
+uint32_t UTIL_SEQ_GetDeadlineMissed( void );
+
 /**
   * @}
  */
@@ -0,0 +1,426 @@
+/**
+  ******************************************************************************
+  * @file           : bench_hw_ts.c
+  * @brief          : Host check and benchmark of the timer server heap.
+  ******************************************************************************
+  * hw_timerserver.c runs against a simulated RTC set up as MX_RTC_Init does
+  * (app_conf.h: asynchronous prescaler 16, synchronous 32768, wakeup clock
+  * RTCCLK/16), so one SSR tick is one wakeup timer tick.
+  *
+  * The check runs a random mix of starts, stops and time steps over all
+  * CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER timers and fires the wakeup timer each
+  * time its count runs out. Every timer has to expire on the tick it was
+  * started for, and none may be left behind.
+  *
+  * The benchmark then keeps 1 to CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER timers
+  * running and times random HW_TS_Start and HW_TS_Stop calls, which run
+  * with PRIMASK set on the target. The host times only tell how the cost
+  * grows with the number of running timers.
+  *
+  * Usage: bench_hw_ts [operations per level]
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <time.h>
+#include "app_common.h"
+#include "hw_conf.h"
+
+/* Private define ------------------------------------------------------------*/
+#define NBR_TIMERS          CFG_HW_TS_MAX_NBR_CONCURRENT_TIMER
+#define SYNCH_PRESCALER     0x7FFFU
+#define ASYNCH_PRESCALER    0x0FU
+#define CHECK_STEPS         200000U
+#define BENCH_OPS           200000U
+
+#define CHECK(cond)                                                            \
+  do                                                                           \
+  {                                                                            \
+    if (!(cond))                                                               \
+    {                                                                          \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);          \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t *ns;
+  uint64_t total_ns;
+  uint32_t count;
+} OpStats_t;
+
+/* Private variables ---------------------------------------------------------*/
+uint32_t host_primask;
+RTC_TypeDef host_rtc;
+RTC_HandleTypeDef hrtc = { RTC };
+
+static uint32_t failures;
+
+/* Simulated time, in wakeup timer ticks */
+static uint32_t sim_now;
+static uint32_t wut_start;
+static uint8_t wkup_pending;
+
+static uint8_t timer_id[NBR_TIMERS];
+static uint8_t running[NBR_TIMERS];
+static uint32_t expiry[NBR_TIMERS];
+static uint32_t period[NBR_TIMERS];
+static uint32_t fired;
+
+/* Private functions ---------------------------------------------------------*/
+
+void HAL_RTC_HostWakeUpTimerEnable(void)
+{
+  SET_BIT(RTC->CR, RTC_CR_WUTE);
+  wut_start = sim_now;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+}
+
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+  wkup_pending = 1U;
+}
+
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+  wkup_pending = 0U;
+}
+
+void HW_TS_RTC_CountUpdated_AppNot(void)
+{
+}
+
+/**
+  * @brief  Timeout of a timer, called from the wakeup handler
+  */
+void HW_TS_RTC_Int_AppNot(uint32_t TimerProcessID, uint8_t TimerID, HW_TS_pTimerCb_t pTimerCallBack)
+{
+  uint32_t i;
+
+  CHECK(TimerID == timer_id[TimerProcessID]);
+  CHECK(running[TimerProcessID]);
+  CHECK(expiry[TimerProcessID] == sim_now);
+  fired++;
+
+  if (period[TimerProcessID] != 0U)
+  {
+    expiry[TimerProcessID] = sim_now + period[TimerProcessID];
+  }
+  else
+  {
+    running[TimerProcessID] = 0U;
+  }
+
+  /* Nothing still running was due before now */
+  for (i = 0U; i < NBR_TIMERS; i++)
+  {
+    CHECK(!running[i] || ((int32_t)(expiry[i] - sim_now) >= 0));
+  }
+}
+
+static void sim_set_now(uint32_t now)
+{
+  sim_now = now;
+  RTC->SSR = SYNCH_PRESCALER - (now % (SYNCH_PRESCALER + 1U));
+}
+
+/**
+  * @brief  Time at which the wakeup interrupt will be taken
+  * @retval 0 when no wakeup is pending nor counting
+  */
+static uint8_t sim_next_wakeup(uint32_t *when)
+{
+  if (wkup_pending)
+  {
+    *when = sim_now;
+    return 1U;
+  }
+  if (READ_BIT(RTC->CR, RTC_CR_WUTE) != 0U)
+  {
+    *when = wut_start + READ_BIT(RTC->WUTR, RTC_WUTR_WUT) + 1U;
+    return 1U;
+  }
+  return 0U;
+}
+
+static void sim_wakeup(uint32_t when)
+{
+  sim_set_now(when);
+  SET_BIT(RTC->ISR, RTC_ISR_WUTF);
+  wkup_pending = 0U;
+  HW_TS_RTC_Wakeup_Handler();
+}
+
+static void sim_init(void)
+{
+  uint32_t i;
+
+  memset(&host_rtc, 0, sizeof(host_rtc));
+  RTC->PRER = (ASYNCH_PRESCALER << POSITION_VAL(RTC_PRER_PREDIV_A)) | SYNCH_PRESCALER;
+  wkup_pending = 0U;
+  sim_set_now(0U);
+
+  HW_TS_Init(hw_ts_InitMode_Full, &hrtc);
+  for (i = 0U; i < NBR_TIMERS; i++)
+  {
+    running[i] = 0U;
+    period[i] = 0U;
+  }
+}
+
+static void sim_start(uint32_t i, uint32_t ticks)
+{
+  HW_TS_Start(timer_id[i], ticks);
+  running[i] = 1U;
+  expiry[i] = sim_now + ticks;
+  if (period[i] != 0U)
+  {
+    period[i] = ticks;
+  }
+}
+
+static uint32_t random_ticks(void)
+{
+  /* Now and then more than the wakeup timer can count at once */
+  if ((rand() % 16) == 0)
+  {
+    return 1U + ((uint32_t)rand() % 100000U);
+  }
+  return 1U + ((uint32_t)rand() % 2000U);
+}
+
+/**
+  * @brief  Random starts, stops and time steps; every timer expires on time
+  *         and in order.
+  */
+static void test_expiry_order(void)
+{
+  HW_TS_Mode_t mode;
+  uint32_t step, i, when, limit, started = 0U;
+  uint8_t extra;
+
+  sim_init();
+  for (i = 0U; i < NBR_TIMERS; i++)
+  {
+    mode = (i < 4U) ? hw_ts_Repeated : hw_ts_SingleShot;
+    CHECK(HW_TS_Create(i, &timer_id[i], mode, NULL) == hw_ts_Successful);
+    period[i] = (mode == hw_ts_Repeated) ? 1U : 0U;
+  }
+  CHECK(HW_TS_Create(NBR_TIMERS, &extra, hw_ts_SingleShot, NULL) == hw_ts_Failed);
+
+  fired = 0U;
+  for (step = 0U; step < CHECK_STEPS; step++)
+  {
+    i = (uint32_t)rand() % NBR_TIMERS;
+    switch (rand() % 4)
+    {
+      case 0:
+      case 1:
+        sim_start(i, random_ticks());
+        started++;
+        break;
+
+      case 2:
+        HW_TS_Stop(timer_id[i]);
+        running[i] = 0U;
+        break;
+
+      default:
+        if (sim_next_wakeup(&limit))
+        {
+          /* Either some time goes by or the wakeup timer fires */
+          when = sim_now + ((uint32_t)rand() % (limit - sim_now + 1U));
+          if (when == limit)
+          {
+            sim_wakeup(when);
+          }
+          else
+          {
+            sim_set_now(when);
+          }
+        }
+        else
+        {
+          sim_set_now(sim_now + ((uint32_t)rand() % 1000U));
+        }
+        break;
+    }
+  }
+
+  /* Let the single shot timers run out */
+  for (i = 0U; i < NBR_TIMERS; i++)
+  {
+    if (period[i] != 0U)
+    {
+      HW_TS_Stop(timer_id[i]);
+      running[i] = 0U;
+    }
+  }
+  while (sim_next_wakeup(&when))
+  {
+    sim_wakeup(when);
+  }
+  for (i = 0U; i < NBR_TIMERS; i++)
+  {
+    CHECK(!running[i]);
+  }
+  CHECK(READ_BIT(RTC->CR, RTC_CR_WUTE) == 0U);
+  CHECK(HW_TS_RTC_ReadLeftTicksToCount() == 0xFFFFU);
+
+  printf("check: %u starts, %u timeouts\n", (unsigned)started, (unsigned)fired);
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void stats_add(OpStats_t *stats, uint64_t t0, uint64_t t1)
+{
+  stats->ns[stats->count++] = (uint32_t)(t1 - t0);
+  stats->total_ns += t1 - t0;
+}
+
+static int compare_ns(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+static double stats_mean(const OpStats_t *stats)
+{
+  return (stats->count != 0U) ? ((double)stats->total_ns / stats->count) : 0.0;
+}
+
+/**
+  * @brief  99th percentile: the host maximum is set by preemption, not by
+  *         the timer server
+  */
+static uint32_t stats_p99(OpStats_t *stats)
+{
+  if (stats->count == 0U)
+  {
+    return 0U;
+  }
+  qsort(stats->ns, stats->count, sizeof(stats->ns[0]), compare_ns);
+  return stats->ns[(stats->count * 99U) / 100U];
+}
+
+/**
+  * @brief  Keep nbr_running timers running while random timers are started,
+  *         restarted and stopped. Time stands still, so nothing expires.
+  */
+static void bench_level(uint32_t nbr_running, uint32_t ops)
+{
+  OpStats_t start = {0}, restart = {0}, stop = {0};
+  uint32_t op, i, j;
+  uint64_t t0, t1;
+
+  start.ns = malloc(ops * sizeof(uint32_t));
+  restart.ns = malloc(ops * sizeof(uint32_t));
+  stop.ns = malloc(ops * sizeof(uint32_t));
+  if ((start.ns == NULL) || (restart.ns == NULL) || (stop.ns == NULL))
+  {
+    printf("out of memory\n");
+    exit(1);
+  }
+
+  sim_init();
+  for (i = 0U; i < NBR_TIMERS; i++)
+  {
+    CHECK(HW_TS_Create(i, &timer_id[i], hw_ts_SingleShot, NULL) == hw_ts_Successful);
+  }
+  sim_set_now((uint32_t)rand());
+  for (i = 0U; i < nbr_running; i++)
+  {
+    sim_start(i, random_ticks());
+  }
+
+  for (op = 0U; op < ops; op++)
+  {
+    do
+    {
+      i = (uint32_t)rand() % NBR_TIMERS;
+    } while (!running[i]);
+
+    if ((rand() % 2) == 0)
+    {
+      t0 = now_ns();
+      HW_TS_Start(timer_id[i], random_ticks());
+      t1 = now_ns();
+      stats_add(&restart, t0, t1);
+    }
+    else if (nbr_running < NBR_TIMERS)
+    {
+      t0 = now_ns();
+      HW_TS_Stop(timer_id[i]);
+      t1 = now_ns();
+      stats_add(&stop, t0, t1);
+      running[i] = 0U;
+
+      do
+      {
+        j = (uint32_t)rand() % NBR_TIMERS;
+      } while (running[j] || (j == i));
+      t0 = now_ns();
+      HW_TS_Start(timer_id[j], random_ticks());
+      t1 = now_ns();
+      stats_add(&start, t0, t1);
+      running[j] = 1U;
+    }
+  }
+
+  printf("%7u %10.1f %6u %10.1f %6u %10.1f %6u\n", (unsigned)nbr_running,
+         stats_mean(&start), (unsigned)stats_p99(&start),
+         stats_mean(&restart), (unsigned)stats_p99(&restart),
+         stats_mean(&stop), (unsigned)stats_p99(&stop));
+
+  free(start.ns);
+  free(restart.ns);
+  free(stop.ns);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+  static const uint32_t levels[] = {1U, 2U, 4U, 6U, 8U, 12U, 16U, 24U, NBR_TIMERS};
+  uint32_t ops = BENCH_OPS;
+  uint32_t i;
+
+  srand(1U);
+  if (argc > 1)
+  {
+    ops = (uint32_t)strtoul(argv[1], NULL, 0);
+  }
+
+  test_expiry_order();
+
+  printf("\n%u operations per level, ns per call (mean, 99th percentile)\n", (unsigned)ops);
+  printf("running      start    p99    restart    p99       stop    p99\n");
+  for (i = 0U; i < (sizeof(levels) / sizeof(levels[0])); i++)
+  {
+    bench_level(levels[i], ops);
+  }
+
+  printf("%s\n", (failures == 0U) ? "PASS" : "FAIL");
+  return (failures == 0U) ? 0 : 1;
+}
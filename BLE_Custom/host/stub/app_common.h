@@ -0,0 +1,22 @@
+/**
+  ******************************************************************************
+  * @file           : app_common.h
+  * @brief          : Host stand-in for the common application header.
+  ******************************************************************************
+  * Same includes as Core/Inc/app_common.h. It has to be replaced too, as the
+  * real one would pick the app_conf.h next to it.
+  ******************************************************************************
+  */
+
+#ifndef APP_COMMON_H
+#define APP_COMMON_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+#include "app_conf.h"
+
+#endif /* APP_COMMON_H */
@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file           : app_conf.h
+  * @brief          : Host stand-in for the application configuration.
+  ******************************************************************************
+  * app_common.h and utilities_common.h pull the whole HAL in through this
+  * header on the target. The host builds only get the HAL RTC, NVIC and
+  * EXTI pieces the timer server touches, the HW_TS API from hw_if.h and the
+  * debug trace settings of Core/Inc/app_conf.h.
+  * The RTC wakeup and NVIC functions are defined by each test.
+  ******************************************************************************
+  */
+
+#ifndef APP_CONF_H
+#define APP_CONF_H
+
+#include "stm32wbxx.h"
+
+/* HAL RTC -------------------------------------------------------------------*/
+#define LSI_VALUE                           32000U
+
+typedef struct
+{
+  RTC_TypeDef *Instance;
+} RTC_HandleTypeDef;
+
+#define RTC_FLAG_WUTWF                      RTC_ISR_WUTWF
+#define RTC_FLAG_WUTF                       RTC_ISR_WUTF
+#define RTC_IT_WUT                          0x00004000U
+#define RTC_EXTI_LINE_WAKEUPTIMER_EVENT     0x00080000U
+
+/* The wakeup timer can be written as soon as it is disabled */
+#define __HAL_RTC_WAKEUPTIMER_GET_FLAG(__HANDLE__, __FLAG__)                   \
+  (((((__FLAG__) == RTC_FLAG_WUTWF) ? (READ_BIT(RTC->CR, RTC_CR_WUTE) == 0U)   \
+                                    : (READ_BIT(RTC->ISR, (__FLAG__)) != 0U))) \
+   ? SET : RESET)
+#define __HAL_RTC_WAKEUPTIMER_CLEAR_FLAG(__HANDLE__, __FLAG__)  CLEAR_BIT(RTC->ISR, (__FLAG__))
+#define __HAL_RTC_WAKEUPTIMER_ENABLE(__HANDLE__)                HAL_RTC_HostWakeUpTimerEnable()
+#define __HAL_RTC_WAKEUPTIMER_DISABLE(__HANDLE__)               CLEAR_BIT(RTC->CR, RTC_CR_WUTE)
+#define __HAL_RTC_WAKEUPTIMER_ENABLE_IT(__HANDLE__, __IT__)     ((void)0)
+#define __HAL_RTC_WAKEUPTIMER_EXTI_CLEAR_FLAG()                 ((void)0)
+#define __HAL_RTC_WRITEPROTECTION_DISABLE(__HANDLE__)           ((void)0)
+#define __HAL_RTC_WRITEPROTECTION_ENABLE(__HANDLE__)            ((void)0)
+
+/* Sets RTC_CR_WUTE and starts counting WUTR + 1 ticks */
+void HAL_RTC_HostWakeUpTimerEnable(void);
+
+/* HAL NVIC and LL EXTI ------------------------------------------------------*/
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+
+#define LL_EXTI_EnableRisingTrig_0_31(ExtiLine)  ((void)(ExtiLine))
+#define LL_EXTI_EnableIT_0_31(ExtiLine)          ((void)(ExtiLine))
+
+/* HW_TS API, from hw_if.h ---------------------------------------------------*/
+typedef enum
+{
+  hw_ts_InitMode_Full,
+  hw_ts_InitMode_Limited,
+} HW_TS_InitMode_t;
+
+typedef enum
+{
+  hw_ts_SingleShot,
+  hw_ts_Repeated
+} HW_TS_Mode_t;
+
+typedef enum
+{
+  hw_ts_Successful,
+  hw_ts_Failed,
+}HW_TS_ReturnStatus_t;
+
+typedef void (*HW_TS_pTimerCb_t)(void);
+
+void HW_TS_Init(HW_TS_InitMode_t TimerInitMode, RTC_HandleTypeDef *hrtc);
+HW_TS_ReturnStatus_t HW_TS_Create(uint32_t TimerProcessID, uint8_t *pTimerId, HW_TS_Mode_t TimerMode, HW_TS_pTimerCb_t pTimerCallBack);
+void HW_TS_Stop(uint8_t TimerID);
+void HW_TS_Start(uint8_t TimerID, uint32_t timeout_ticks);
+void HW_TS_Delete(uint8_t TimerID);
+void HW_TS_RTC_Wakeup_Handler(void);
+uint16_t HW_TS_RTC_ReadLeftTicksToCount(void);
+void HW_TS_RTC_Int_AppNot(uint32_t TimerProcessID, uint8_t TimerID, HW_TS_pTimerCb_t pTimerCallBack);
+void HW_TS_RTC_CountUpdated_AppNot(void);
+
+/* Debug trace, as in Core/Inc/app_conf.h ------------------------------------*/
+#define CFG_DEBUG_TRACE_LIGHT               1
+#define CFG_DEBUG_TRACE_FULL                0
+#define DBG_TRACE_USE_CIRCULAR_QUEUE        1
+#define DBG_TRACE_MSG_QUEUE_SIZE            4096
+
+#endif /* APP_CONF_H */
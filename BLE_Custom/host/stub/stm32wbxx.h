@@ -0,0 +1,92 @@
+/**
+  ******************************************************************************
+  * @file           : stm32wbxx.h
+  * @brief          : Host stand-in for the CMSIS device header.
+  ******************************************************************************
+  * Only what the host builds of the application modules use. The RTC is a
+  * plain register block that the tests drive: they keep SSR in step with
+  * their clock and fire the wakeup timer when its count runs out. Interrupt
+  * masking is a flag that the tests can inspect. The exclusive accesses and
+  * __DMB are defined by the tests that use them, so that an interrupt can be
+  * simulated there.
+  ******************************************************************************
+  */
+
+#ifndef __STM32WBxx_H
+#define __STM32WBxx_H
+
+#include <stdint.h>
+
+#define __IO                volatile
+#define __weak              __attribute__((weak))
+
+#define __DSB()             __sync_synchronize()
+#define __ISB()             __sync_synchronize()
+
+void __DMB(void);
+uint32_t __LDREXW(volatile uint32_t *addr);
+uint32_t __STREXW(uint32_t value, volatile uint32_t *addr);
+void __CLREX(void);
+
+typedef enum
+{
+  RESET = 0,
+  SET = !RESET
+} FlagStatus, ITStatus;
+
+typedef enum
+{
+  RTC_WKUP_IRQn = 3
+} IRQn_Type;
+
+#define READ_BIT(REG, BIT)                  ((REG) & (BIT))
+#define SET_BIT(REG, BIT)                   ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)                 ((REG) &= ~(BIT))
+#define MODIFY_REG(REG, CLEARMSK, SETMASK)  ((REG) = (((REG) & (~(CLEARMSK))) | (SETMASK)))
+#define POSITION_VAL(VAL)                   (__builtin_ctz(VAL))
+
+typedef struct
+{
+  volatile uint32_t SSR;
+  volatile uint32_t CR;
+  volatile uint32_t ISR;
+  volatile uint32_t PRER;
+  volatile uint32_t WUTR;
+} RTC_TypeDef;
+
+#define RTC_SSR_SS                          0x0000FFFFU
+#define RTC_CR_WUCKSEL                      0x00000007U
+#define RTC_CR_BYPSHAD                      0x00000020U
+#define RTC_CR_WUTE                         0x00000400U
+#define RTC_ISR_WUTWF                       0x00000004U
+#define RTC_ISR_WUTF                        0x00000400U
+#define RTC_PRER_PREDIV_S                   0x00007FFFU
+#define RTC_PRER_PREDIV_A                   0x007F0000U
+#define RTC_WUTR_WUT                        0x0000FFFFU
+
+extern RTC_TypeDef host_rtc;
+#define RTC                 (&host_rtc)
+
+extern uint32_t host_primask;
+
+static inline uint32_t __get_PRIMASK(void)
+{
+  return host_primask;
+}
+
+static inline void __set_PRIMASK(uint32_t primask)
+{
+  host_primask = primask;
+}
+
+static inline void __disable_irq(void)
+{
+  host_primask = 1U;
+}
+
+static inline void __enable_irq(void)
+{
+  host_primask = 0U;
+}
+
+#endif /* __STM32WBxx_H */
@@ -0,0 +1,459 @@
+/**
+  ******************************************************************************
+  * @file           : test_dbg_trace.c
+  * @brief          : Host test and benchmark of the debug trace ring.
+  ******************************************************************************
+  * dbg_trace.c is driven through DbgTraceWrite with a stub UART: a transfer
+  * started by DbgOutputTraces is read out and completed later, from the main
+  * loop or from a simulated interrupt.
+  *
+  * Interrupts are simulated at the exclusive accesses and at the barrier
+  * after the copy: there, a nested writer runs or the UART transfer
+  * completes, and the exclusive monitor is cleared on return as on the
+  * core. Every trace is a self checking record; all of them have to come
+  * out of the UART whole, once, and only one transfer may run at a time.
+  *
+  * The benchmark compares the ring with the CircularQueue path it replaced,
+  * which is kept below as a reference. The exclusive accesses are function
+  * calls here, which the ring pays for on the host only. What carries over
+  * to the target is the UART transfers per trace, and that the ring never
+  * masks the interrupts.
+  *
+  * Usage: test_dbg_trace [traces per benchmark run]
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <time.h>
+#include "utilities_common.h"
+#include "dbg_trace.h"
+#include "stm_queue.h"
+
+/* Private define ------------------------------------------------------------*/
+#define RECORD_MIN          6U
+#define RECORD_MAX          64U
+#define NESTING_MAX         3U
+#define IRQ_ODDS            4
+#define WRITES              100000U
+#define UART_OUT_SIZE       (8U * 1024U * 1024U)
+#define BENCH_TRACES        1000000U
+#define BENCH_BATCH         8U
+
+#define CHECK(cond)                                                            \
+  do                                                                           \
+  {                                                                            \
+    if (!(cond))                                                               \
+    {                                                                          \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);          \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+/* Private variables ---------------------------------------------------------*/
+uint32_t host_primask;
+
+static uint32_t failures;
+
+/* Exclusive monitor */
+static volatile uint32_t *excl_addr;
+
+/* Simulated interrupts */
+static uint8_t irq_enabled;
+static uint32_t irq_depth;
+static uint32_t irq_writers;
+
+/* UART transfer in flight and what came out of the line */
+static uint8_t *dma_data;
+static uint16_t dma_size;
+static void (*dma_cb)(void);
+static uint8_t dma_pending;
+static uint32_t dma_starts;
+static uint8_t capture;
+static uint8_t *uart_out;
+static uint32_t uart_len;
+
+/* Records */
+static uint32_t next_seq;
+static uint8_t *seen;
+
+/* Private function prototypes -----------------------------------------------*/
+static void sim_interrupt(void);
+static void write_record(uint32_t len);
+
+/* Private functions ---------------------------------------------------------*/
+
+uint32_t __LDREXW(volatile uint32_t *addr)
+{
+  uint32_t value = *addr;
+
+  excl_addr = addr;
+  sim_interrupt();
+  return value;
+}
+
+uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+  sim_interrupt();
+  if (excl_addr != addr)
+  {
+    return 1U;
+  }
+  excl_addr = NULL;
+  *addr = value;
+  return 0U;
+}
+
+void __CLREX(void)
+{
+  excl_addr = NULL;
+}
+
+void __DMB(void)
+{
+  __sync_synchronize();
+  sim_interrupt();
+}
+
+void DbgOutputInit(void)
+{
+}
+
+void DbgOutputTraces(uint8_t *p_data, uint16_t size, void (*cb)(void))
+{
+  CHECK(!dma_pending);
+  CHECK(size != 0U);
+  dma_data = p_data;
+  dma_size = size;
+  dma_cb = cb;
+  dma_pending = 1U;
+  dma_starts++;
+}
+
+/**
+  * @brief  The UART is done: the bytes are read out only now, so that a
+  *         writer overwriting them while in flight is caught.
+  */
+static void sim_dma_complete(void)
+{
+  if (capture)
+  {
+    memcpy(&uart_out[uart_len], dma_data, dma_size);
+    uart_len += dma_size;
+  }
+  dma_pending = 0U;
+  dma_cb();
+}
+
+/**
+  * @brief  An interrupt may be taken here: a writer or the end of the UART
+  *         transfer. The exception return clears the exclusive monitor.
+  */
+static void sim_interrupt(void)
+{
+  if (!irq_enabled || (irq_depth >= NESTING_MAX) || ((rand() % IRQ_ODDS) != 0))
+  {
+    return;
+  }
+  irq_depth++;
+  if (dma_pending && ((rand() % 3) == 0))
+  {
+    sim_dma_complete();
+  }
+  else
+  {
+    irq_writers++;
+    write_record(RECORD_MIN + ((uint32_t)rand() % (RECORD_MAX - RECORD_MIN + 1U)));
+  }
+  irq_depth--;
+  excl_addr = NULL;
+}
+
+static void sim_dma_drain(void)
+{
+  while (dma_pending)
+  {
+    sim_dma_complete();
+  }
+}
+
+/**
+  * @brief  Record: length, 16 bit sequence number, pattern, xor of the
+  *         bytes before
+  */
+static void write_record(uint32_t len)
+{
+  uint8_t record[RECORD_MAX];
+  uint32_t seq = next_seq++;
+  uint32_t i;
+  uint8_t sum = 0U;
+
+  record[0] = (uint8_t)len;
+  record[1] = (uint8_t)seq;
+  record[2] = (uint8_t)(seq >> 8);
+  for (i = 3U; i < (len - 1U); i++)
+  {
+    record[i] = (uint8_t)((seq * 31U) + i);
+  }
+  for (i = 0U; i < (len - 1U); i++)
+  {
+    sum ^= record[i];
+  }
+  record[len - 1U] = sum;
+
+  CHECK(DbgTraceWrite(1, record, len) == len);
+}
+
+/**
+  * @brief  Walk the UART output: every record whole and seen once
+  * @retval number of records
+  */
+static uint32_t parse_uart(void)
+{
+  uint32_t pos = 0U, records = 0U, len, seq, i;
+  uint8_t sum;
+
+  memset(seen, 0, 0x10000U);
+  while (pos < uart_len)
+  {
+    len = uart_out[pos];
+    if ((len < RECORD_MIN) || (len > RECORD_MAX) || ((pos + len) > uart_len))
+    {
+      printf("bad record length %u at %u\n", (unsigned)len, (unsigned)pos);
+      failures++;
+      break;
+    }
+    sum = 0U;
+    for (i = 0U; i < (len - 1U); i++)
+    {
+      sum ^= uart_out[pos + i];
+    }
+    seq = uart_out[pos + 1U] | ((uint32_t)uart_out[pos + 2U] << 8);
+    CHECK(sum == uart_out[pos + len - 1U]);
+    CHECK(uart_out[pos + 3U] == (uint8_t)((seq * 31U) + 3U));
+    CHECK(seen[seq] == 0U);
+    seen[seq] = 1U;
+    records++;
+    pos += len;
+  }
+  return records;
+}
+
+static void start(void)
+{
+  DbgTraceInit();
+  dma_pending = 0U;
+  excl_addr = NULL;
+  uart_len = 0U;
+  next_seq = 0U;
+}
+
+/**
+  * @brief  Writers nested up to NESTING_MAX deep and transfers ending at any
+  *         of the simulated interrupt points: nothing is lost nor torn.
+  */
+static void test_nested_writers(void)
+{
+  uint32_t i, records, total = 0U;
+  uint32_t writes = 0U;
+
+  irq_writers = 0U;
+  capture = 1U;
+  irq_enabled = 1U;
+
+  /* The sequence number is 16 bit: replay in rounds */
+  for (i = 0U; i < WRITES; i += writes)
+  {
+    start();
+    writes = 0U;
+    while ((next_seq < 0xF000U) && ((i + writes) < WRITES))
+    {
+      write_record(RECORD_MIN + ((uint32_t)rand() % (RECORD_MAX - RECORD_MIN + 1U)));
+      writes++;
+      if ((rand() % 2) == 0)
+      {
+        sim_dma_drain();
+      }
+    }
+    irq_enabled = 0U;
+    sim_dma_drain();
+    irq_enabled = 1U;
+
+    records = parse_uart();
+    CHECK(records == next_seq);
+    total += records;
+  }
+  irq_enabled = 0U;
+
+  printf("nested writers: %u records, %u written from interrupts\n", (unsigned)total, (unsigned)irq_writers);
+}
+
+/**
+  * @brief  The UART stalls: the traces that do not fit are dropped whole,
+  *         and the ring takes traces again once it has been sent.
+  */
+static void test_full_ring(void)
+{
+  uint32_t i, records;
+
+  capture = 1U;
+  start();
+  for (i = 0U; i < ((2U * DBG_TRACE_MSG_QUEUE_SIZE) / RECORD_MAX); i++)
+  {
+    write_record(RECORD_MAX);
+  }
+  sim_dma_drain();
+  records = parse_uart();
+  CHECK(records == (DBG_TRACE_MSG_QUEUE_SIZE / RECORD_MAX));
+  for (i = 0U; i < records; i++)
+  {
+    CHECK(seen[i] != 0U);
+  }
+
+  write_record(RECORD_MAX);
+  sim_dma_drain();
+  CHECK(parse_uart() == (records + 1U));
+  CHECK(seen[next_seq - 1U] != 0U);
+}
+
+/**
+  * Reference: the CircularQueue path dbg_trace.c used before the ring. Each
+  * trace is queued under PRIMASK and sent on its own.
+  */
+static queue_t RefQueue;
+static uint8_t RefQueueBuff[DBG_TRACE_MSG_QUEUE_SIZE];
+static volatile ITStatus RefPeripheralReady = SET;
+
+static void RefTxCpltCallback(void)
+{
+  uint8_t* buf;
+  uint16_t bufSize;
+
+  BACKUP_PRIMASK();
+
+  DISABLE_IRQ();
+  CircularQueue_Remove(&RefQueue, &bufSize);
+  buf = CircularQueue_Sense(&RefQueue, &bufSize);
+  if (buf != NULL)
+  {
+    RESTORE_PRIMASK();
+    DbgOutputTraces(buf, bufSize, RefTxCpltCallback);
+  }
+  else
+  {
+    RefPeripheralReady = SET;
+    RESTORE_PRIMASK();
+  }
+}
+
+static void RefTraceWrite(const uint8_t *buf, uint16_t bufSize)
+{
+  uint8_t* buffer;
+
+  BACKUP_PRIMASK();
+
+  DISABLE_IRQ();
+  buffer = CircularQueue_Add(&RefQueue, (uint8_t*)buf, bufSize, 1);
+  if ((buffer != NULL) && RefPeripheralReady)
+  {
+    RefPeripheralReady = RESET;
+    RESTORE_PRIMASK();
+    DbgOutputTraces(buffer, bufSize, RefTxCpltCallback);
+  }
+  else
+  {
+    RESTORE_PRIMASK();
+  }
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+  * @brief  Traces of one size written back to back, the UART catching up
+  *         after every BENCH_BATCH of them
+  */
+static void bench_size(uint32_t size, uint32_t traces)
+{
+  uint8_t trace[RECORD_MAX];
+  uint64_t t0, ring_ns, queue_ns;
+  uint32_t i, ring_starts, queue_starts;
+
+  memset(trace, 'x', sizeof(trace));
+  capture = 0U;
+
+  start();
+  dma_starts = 0U;
+  t0 = now_ns();
+  for (i = 0U; i < traces; i++)
+  {
+    (void)DbgTraceWrite(1, trace, size);
+    if ((i % BENCH_BATCH) == (BENCH_BATCH - 1U))
+    {
+      sim_dma_drain();
+    }
+  }
+  sim_dma_drain();
+  ring_ns = now_ns() - t0;
+  ring_starts = dma_starts;
+
+  CircularQueue_Init(&RefQueue, RefQueueBuff, DBG_TRACE_MSG_QUEUE_SIZE, 0, CIRCULAR_QUEUE_SPLIT_IF_WRAPPING_FLAG);
+  RefPeripheralReady = SET;
+  dma_pending = 0U;
+  dma_starts = 0U;
+  t0 = now_ns();
+  for (i = 0U; i < traces; i++)
+  {
+    RefTraceWrite(trace, (uint16_t)size);
+    if ((i % BENCH_BATCH) == (BENCH_BATCH - 1U))
+    {
+      sim_dma_drain();
+    }
+  }
+  sim_dma_drain();
+  queue_ns = now_ns() - t0;
+  queue_starts = dma_starts;
+
+  printf("%5u %10.1f %10.3f %10.1f %10.3f\n", (unsigned)size,
+         (double)ring_ns / traces, (double)ring_starts / traces,
+         (double)queue_ns / traces, (double)queue_starts / traces);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+  static const uint32_t sizes[] = {8U, 16U, 32U, 64U};
+  uint32_t traces = BENCH_TRACES;
+  uint32_t i;
+
+  srand(1U);
+  if (argc > 1)
+  {
+    traces = (uint32_t)strtoul(argv[1], NULL, 0);
+  }
+  uart_out = malloc(UART_OUT_SIZE);
+  seen = malloc(0x10000U);
+  if ((uart_out == NULL) || (seen == NULL))
+  {
+    printf("out of memory\n");
+    return 1;
+  }
+
+  test_nested_writers();
+  test_full_ring();
+
+  printf("\n%u traces per size, ns and UART transfers per trace\n", (unsigned)traces);
+  printf(" size       ring  transfers      queue  transfers\n");
+  for (i = 0U; i < (sizeof(sizes) / sizeof(sizes[0])); i++)
+  {
+    bench_size(sizes[i], traces);
+  }
+
+  printf("%s\n", (failures == 0U) ? "PASS" : "FAIL");
+  return (failures == 0U) ? 0 : 1;
+}
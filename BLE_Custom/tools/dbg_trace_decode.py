@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""Decode the binary debug trace of BLE_Custom (CFG_DEBUG_TRACE_BINARY).
+
+The firmware sends, for each trace, a record made of DBG_TRACE_BIN_SYNC, the
+number of arguments, the offset of the format string in the .dbg_trace_fmt
+section (2 bytes) and the arguments (4 bytes each), all little endian. The
+format strings and the constant strings passed to %s are read from the ELF
+file of the same build. Bytes that are not part of a record are printed as
+they are, so text traces (PRINT_LOG_BUFF_DBG) stay readable.
+
+    stty -F /dev/ttyACM0 115200 raw
+    python3 tools/dbg_trace_decode.py build/BLE_Custom.elf < /dev/ttyACM0
+"""
+
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+MAX_ARGS = 12
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+CONVERSION = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcspn%])")
+
+
+class Elf:
+    """Minimal ELF32 little endian reader: sections by name and loaded bytes by address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError("%s is not a 32 bit little endian ELF file" % path)
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.data, 0x2E)
+        headers = [struct.unpack_from("<IIIIIIIIII", self.data, shoff + i * shentsize) for i in range(shnum)]
+        names = headers[shstrndx]
+        self.sections = {}
+        self.loaded = []
+        for name, sh_type, flags, addr, offset, size, _, _, _, _ in headers:
+            end = self.data.index(b"\0", names[4] + name)
+            sname = self.data[names[4] + name:end].decode()
+            body = b"" if sh_type == SHT_NOBITS else self.data[offset:offset + size]
+            self.sections[sname] = body
+            if (flags & SHF_ALLOC) and sh_type != SHT_NOBITS:
+                self.loaded.append((addr, body))
+
+    def string_at(self, address):
+        for base, body in self.loaded:
+            if base <= address < base + len(body):
+                end = body.find(b"\0", address - base)
+                return body[address - base:end if end >= 0 else None].decode(errors="replace")
+        return None
+
+
+def load_formats(elf):
+    section = elf.sections.get(".dbg_trace_fmt")
+    if section is None:
+        raise ValueError("no .dbg_trace_fmt section: was the firmware built with CFG_DEBUG_TRACE_BINARY?")
+    formats = {}
+    offset = 0
+    while offset < len(section):
+        end = section.index(b"\0", offset)
+        if end > offset:
+            formats[offset] = section[offset:end].decode(errors="replace")
+        offset = end + 1
+    return formats
+
+
+def format_trace(elf, fmt, args):
+    """Apply a printf format to 32 bit raw arguments."""
+    values = iter(args)
+    out = []
+    pos = 0
+    for m in CONVERSION.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, precision, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if width == "*":
+            width = str(next(values, 0))
+        spec = "%" + flags + (width or "") + ("." + precision if precision else "")
+        value = next(values, 0)
+        if conv == "s":
+            text = elf.string_at(value)
+            out.append((spec + "s") % (text if text is not None else "<0x%08x>" % value))
+        elif conv == "p":
+            out.append("0x%08x" % value)
+        elif conv == "c":
+            out.append((spec + "c") % chr(value & 0xFF))
+        elif conv in "di":
+            bits = 8 if length == "hh" else 16 if length == "h" else 32
+            value &= (1 << bits) - 1
+            if value >= 1 << (bits - 1):
+                value -= 1 << bits
+            out.append((spec + "d") % value)
+        elif conv == "n":
+            pass
+        else:
+            out.append((spec + ("d" if conv == "u" else conv)) % value)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode(elf, formats, stream, out):
+    buf = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buf += chunk
+        while buf:
+            if buf[0] != SYNC:
+                text_end = buf.find(bytes([SYNC]))
+                text_end = len(buf) if text_end < 0 else text_end
+                out.write(buf[:text_end].decode(errors="replace"))
+                del buf[:text_end]
+                continue
+            if len(buf) < 4:
+                break
+            nargs = buf[1]
+            fmt_id = buf[2] | (buf[3] << 8)
+            if nargs > MAX_ARGS or fmt_id not in formats:
+                # not a record: a text byte that happens to be the sync value
+                out.write(chr(buf[0]))
+                del buf[:1]
+                continue
+            size = 4 + 4 * nargs
+            if len(buf) < size:
+                break
+            args = struct.unpack_from("<%dI" % nargs, buf, 4)
+            out.write(format_trace(elf, formats[fmt_id], args))
+            del buf[:size]
+        out.flush()
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.stderr.write("usage: %s firmware.elf [capture.bin]\n" % sys.argv[0])
+        return 2
+    elf = Elf(sys.argv[1])
+    formats = load_formats(elf)
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "rb") as stream:
+            decode(elf, formats, stream, sys.stdout)
+    else:
+        decode(elf, formats, sys.stdin.buffer, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
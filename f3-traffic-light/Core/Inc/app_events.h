@@ -0,0 +1,70 @@
+/**
+  ******************************************************************************
+  * @file           : app_events.h
+  * @brief          : Event queue and sleep handling of the main loop.
+  ******************************************************************************
+  * Interrupt handlers (USB, UART) post events here; the main loop dispatches
+  * them and sleeps in WFI whenever the queue is empty. The module also keeps
+  * track of how often the core wakes up and how long it stays awake.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __APP_EVENTS_H
+#define __APP_EVENTS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Queue depth, power of two */
+#define APP_EVT_QUEUE_SIZE      16U
+/* Latency histogram: bucket 0 counts events dispatched within 1 us, bucket n
+   those waiting 2^(n-1) to 2^n us; the last bucket also takes everything longer */
+#define APP_EVT_LATENCY_BUCKETS 8U
+/* APP_EVT_SET_STATE flag: Value also carries brightness and fade time */
+#define APP_EVT_STATE_HAS_LEVEL 0x01000000U
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+  APP_EVT_SET_STATE = 0U,   /*!< New lamp bitmask in bits 0..7 of Value; with
+                                 APP_EVT_STATE_HAS_LEVEL also the brightness
+                                 in bits 8..15 and the fade time in 16..23 */
+  APP_EVT_UART_RX,          /*!< Command bytes are waiting in the UART ring */
+  APP_EVT_SEQ_LOAD,         /*!< A sequence upload is waiting in lamp_seq */
+  APP_EVT_SEQ_STEP,         /*!< Sequence step applied: lamp state in bits 0..7,
+                                 sequence generation above */
+} APP_EVT_IdTypeDef;
+
+typedef struct
+{
+  APP_EVT_IdTypeDef Id;
+  uint32_t          Value;
+  uint32_t          Stamp;  /*!< DWT cycle counter when posted */
+} APP_EVT_TypeDef;
+
+typedef struct
+{
+  uint32_t WakeupsPerSec;   /*!< Exits from WFI during the last second */
+  uint32_t ActivePermille;  /*!< Share of the last second spent awake, 0..1000 */
+  uint32_t Dropped;         /*!< Events lost because the queue was full */
+  uint32_t LatencyHist[APP_EVT_LATENCY_BUCKETS]; /*!< Post to dispatch delay */
+} APP_EVT_StatsTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void APP_EVT_Init(void);
+uint8_t APP_EVT_Post(APP_EVT_IdTypeDef id, uint32_t value);
+uint8_t APP_EVT_Get(APP_EVT_TypeDef *evt);
+void APP_EVT_WaitForEvent(void);
+const APP_EVT_StatsTypeDef *APP_EVT_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APP_EVENTS_H */
@@ -0,0 +1,32 @@
+/**
+  ******************************************************************************
+  * @file           : app_loop.h
+  * @brief          : Command dispatch of the main loop.
+  ******************************************************************************
+  * One pass of the main loop: queued events (USB reports and sequences, UART
+  * command bytes, sequence steps), bulk stream frames and streamed steps are
+  * turned into the lamp state, which is then written out and reported in the
+  * telemetry. Sleeping until the next event is left to the caller.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __APP_LOOP_H
+#define __APP_LOOP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported functions prototypes ---------------------------------------------*/
+void APP_LOOP_Init(void);
+void APP_LOOP_Process(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APP_LOOP_H */
@@ -0,0 +1,46 @@
+/**
+  ******************************************************************************
+  * @file           : lamp_fade.h
+  * @brief          : PWM dimming and DMA driven fades of the external lamps.
+  ******************************************************************************
+  * The external lamps run on timer PWM channels instead of plain outputs:
+  *
+  *   green   PC8    TIM8_CH3   DMA2 channel 1
+  *   yellow  PA8    TIM1_CH1   DMA1 channel 2
+  *   red     PA10   TIM1_CH3   DMA1 channel 6
+  *
+  * A fade is described by a ramp (start level, end level, number of 10 ms
+  * samples). It is turned into gamma corrected compare values once, and the
+  * channel's DMA request, moved to the update event and slowed down by the
+  * repetition counter, feeds one value every 10 ms without the CPU.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LAMP_FADE_H
+#define __LAMP_FADE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define LAMP_FADE_CHANNEL_NBR     3U
+#define LAMP_FADE_LEVEL_MAX       255U
+/* Fade times are given in samples of this length, up to LAMP_FADE_MAX_SAMPLES */
+#define LAMP_FADE_SAMPLE_MS       10U
+#define LAMP_FADE_MAX_SAMPLES     255U
+
+/* Exported functions prototypes ---------------------------------------------*/
+void LAMP_FADE_Init(void);
+void LAMP_FADE_SetLevel(uint8_t level, uint8_t fade);
+void LAMP_FADE_Write(uint8_t state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LAMP_FADE_H */
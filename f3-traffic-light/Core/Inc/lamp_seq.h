@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file           : lamp_seq.h
+  * @brief          : Preloaded lamp sequences played back from TIM6.
+  ******************************************************************************
+  * Packed sequence layout, uploaded in one transfer (all fields little endian):
+  *
+  *   offset 0   flags, bit 0 set to loop the sequence
+  *   offset 1   number of steps N, 0 stops the running sequence
+  *   offset 2   phase offset into the sequence, in 10 ms units (2 bytes)
+  *   offset 4   N x step (2 bytes): bits 0..2 lamp state,
+  *                                  bits 3..15 duration in 10 ms units
+  *
+  * The timer interrupt applies every step itself, so the timing does not
+  * depend on the main loop or on the host link. A sequence that does not
+  * loop keeps the state of its last step.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LAMP_SEQ_H
+#define __LAMP_SEQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define LAMP_SEQ_HEADER_SIZE    4U
+#define LAMP_SEQ_STEP_SIZE      2U
+#define LAMP_SEQ_MAX_STEPS      64U
+#define LAMP_SEQ_MAX_SIZE       (LAMP_SEQ_HEADER_SIZE + LAMP_SEQ_MAX_STEPS * LAMP_SEQ_STEP_SIZE)
+
+#define LAMP_SEQ_FLAG_LOOP      0x01U
+#define LAMP_SEQ_TIME_UNIT_MS   10U
+
+#define LAMP_SEQ_STEP_STATE(step)   ((uint8_t)((step) & 0x07U))
+#define LAMP_SEQ_STEP_UNITS(step)   ((uint32_t)(step) >> 3)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Uploads;     /*!< Sequences accepted */
+  uint32_t Rejected;    /*!< Uploads malformed, arriving while one was pending
+                             or lost to a full event queue */
+  uint32_t Steps;       /*!< Steps applied by the timer */
+  uint32_t Loops;       /*!< Completed passes of looping sequences */
+} LAMP_SEQ_StatsTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void LAMP_SEQ_Init(void);
+uint8_t LAMP_SEQ_Submit(const uint8_t *buf, uint32_t len);
+void LAMP_SEQ_DropUpload(void);
+uint8_t LAMP_SEQ_ProcessUpload(void);
+void LAMP_SEQ_Stop(void);
+uint8_t LAMP_SEQ_IsCurrent(uint32_t generation);
+void LAMP_SEQ_IRQHandler(void);
+const LAMP_SEQ_StatsTypeDef *LAMP_SEQ_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LAMP_SEQ_H */
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file           : lamp_stream.h
+  * @brief          : Timed lamp steps streamed over the WinUSB bulk endpoint.
+  ******************************************************************************
+  * Frame layout of one bulk OUT transfer (all fields little endian):
+  *
+  *   offset 0   sequence number, incremented by the host for every frame
+  *   offset 1   number of steps N
+  *   offset 2   N x { lamp state (1 byte), hold time in ms (2 bytes) }
+  *
+  * Steps are queued and played back in order; each one keeps its lamp state
+  * for the given hold time before the next one is applied.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LAMP_STREAM_H
+#define __LAMP_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define LAMP_STREAM_HEADER_SIZE   2U
+#define LAMP_STREAM_STEP_SIZE     3U
+/* Step queue depth, power of two */
+#define LAMP_STREAM_QUEUE_SIZE    64U
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Frames;      /*!< Frames accepted */
+  uint32_t SeqGaps;     /*!< Frames missing according to the sequence numbers */
+  uint32_t Reordered;   /*!< Frames repeated or arriving late, by 128 or more sequence numbers */
+  uint32_t Malformed;   /*!< Frames rejected because of an inconsistent length */
+  uint32_t Dropped;     /*!< Steps lost because the queue was full */
+} LAMP_STREAM_StatsTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void LAMP_STREAM_Reset(void);
+uint8_t LAMP_STREAM_PutFrame(const uint8_t *buf, uint32_t len);
+uint8_t LAMP_STREAM_Poll(uint32_t now, uint8_t *state);
+const LAMP_STREAM_StatsTypeDef *LAMP_STREAM_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LAMP_STREAM_H */
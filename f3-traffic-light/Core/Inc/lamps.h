@@ -0,0 +1,50 @@
+/**
+  ******************************************************************************
+  * @file           : lamps.h
+  * @brief          : Traffic light lamp outputs.
+  ******************************************************************************
+  * A 3-bit state (bit0 = green, bit1 = yellow, bit2 = red) is mapped to one
+  * precomputed BSRR word, so the on-board LEDs switch with a single store.
+  * The external lamps are on PWM channels and fade through lamp_fade.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LAMPS_H
+#define __LAMPS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define LAMPS_STATE_GREEN   0x01U
+#define LAMPS_STATE_YELLOW  0x02U
+#define LAMPS_STATE_RED     0x04U
+#define LAMPS_STATE_MASK    0x07U
+
+/* Exported types ------------------------------------------------------------*/
+#ifdef LAMPS_BENCHMARK
+typedef struct
+{
+  uint32_t HalCyclesMin;    /*!< HAL_GPIO_WritePin path, best case */
+  uint32_t HalCyclesMax;    /*!< HAL_GPIO_WritePin path, worst case */
+  uint32_t TableCyclesMin;  /*!< BSRR table path, best case */
+  uint32_t TableCyclesMax;  /*!< BSRR table path, worst case */
+} LAMPS_BenchTypeDef;
+#endif /* LAMPS_BENCHMARK */
+
+/* Exported functions prototypes ---------------------------------------------*/
+void Lamps_Write(uint8_t state);
+#ifdef LAMPS_BENCHMARK
+void Lamps_Benchmark(LAMPS_BenchTypeDef *result);
+#endif /* LAMPS_BENCHMARK */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LAMPS_H */
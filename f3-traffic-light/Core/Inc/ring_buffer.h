@@ -0,0 +1,117 @@
+/**
+  ******************************************************************************
+  * @file           : ring_buffer.h
+  * @brief          : Lock-free single-producer/single-consumer byte ring.
+  ******************************************************************************
+  * The producer (typically an interrupt handler) only ever writes Head, the
+  * consumer (the main loop) only ever writes Tail, so neither side needs to
+  * disable interrupts. Indexes are free-running and masked on access, which
+  * requires the storage size to be a power of two.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RING_BUFFER_H
+#define __RING_BUFFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stm32f3xx.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t           *pBuf;
+  uint32_t          Mask;
+  volatile uint32_t Head;   /*!< Written by the producer only */
+  volatile uint32_t Tail;   /*!< Written by the consumer only */
+} RING_HandleTypeDef;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Attach a storage area to the ring and empty it.
+  * @param  ring: ring handle
+  * @param  buf: storage area
+  * @param  size: storage size, must be a power of two
+  */
+static inline void RING_Init(RING_HandleTypeDef *ring, uint8_t *buf, uint32_t size)
+{
+  ring->pBuf = buf;
+  ring->Mask = size - 1U;
+  ring->Head = 0U;
+  ring->Tail = 0U;
+}
+
+/**
+  * @brief  Number of bytes waiting to be read.
+  */
+static inline uint32_t RING_Count(const RING_HandleTypeDef *ring)
+{
+  return ring->Head - ring->Tail;
+}
+
+/**
+  * @brief  Number of bytes that can be written without overwriting unread data.
+  */
+static inline uint32_t RING_Free(const RING_HandleTypeDef *ring)
+{
+  return (ring->Mask + 1U) - RING_Count(ring);
+}
+
+/**
+  * @brief  Producer side: append a block of bytes.
+  * @param  ring: ring handle
+  * @param  data: bytes to append
+  * @param  len: number of bytes
+  * @retval Number of bytes actually stored (less than len if the ring is full)
+  */
+static inline uint32_t RING_Write(RING_HandleTypeDef *ring, const uint8_t *data, uint32_t len)
+{
+  uint32_t head = ring->Head;
+  uint32_t free = RING_Free(ring);
+  uint32_t i;
+
+  if (len > free)
+  {
+    len = free;
+  }
+  for (i = 0U; i < len; i++)
+  {
+    ring->pBuf[(head + i) & ring->Mask] = data[i];
+  }
+  /* Make the payload visible before publishing the new head */
+  __DMB();
+  ring->Head = head + len;
+  return len;
+}
+
+/**
+  * @brief  Consumer side: take one byte out of the ring.
+  * @param  ring: ring handle
+  * @param  byte: destination
+  * @retval 1 if a byte was read, 0 if the ring is empty
+  */
+static inline uint8_t RING_Get(RING_HandleTypeDef *ring, uint8_t *byte)
+{
+  uint32_t tail = ring->Tail;
+
+  if (ring->Head == tail)
+  {
+    return 0U;
+  }
+  *byte = ring->pBuf[tail & ring->Mask];
+  __DMB();
+  ring->Tail = tail + 1U;
+  return 1U;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RING_BUFFER_H */
@@ -55,8 +55,11 @@ void SVC_Handler(void);
 void DebugMon_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
+void DMA1_Channel5_IRQHandler(void);
 void USB_LP_CAN_RX0_IRQHandler(void);
+void USART1_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void TIM6_DAC_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file           : telemetry.h
+  * @brief          : Device state report sent on the WinUSB IN endpoint.
+  ******************************************************************************
+  * Report layout (TELEMETRY_REPORT_SIZE bytes, multi-byte fields little endian):
+  *
+  *   offset 0   report version (TELEMETRY_VERSION)
+  *   offset 1   lamp state, bit0 = green, bit1 = yellow, bit2 = red
+  *   offset 2   B1 button, 1 = pressed
+  *   offset 3   report sequence number
+  *   offset 4   commands applied (uint32)
+  *   offset 8   commands dropped (uint32)
+  *   offset 12  event latency histogram, APP_EVT_LATENCY_BUCKETS x uint16,
+  *              saturating
+  *   offset 28  uptime in ms (uint32)
+  *
+  * A report is sent as soon as one of the fields up to offset 12 changes, at
+  * most once every TELEMETRY_MIN_INTERVAL_MS; changes in between are merged
+  * into the next report. Without changes a report still goes out every
+  * TELEMETRY_HEARTBEAT_MS.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TELEMETRY_H
+#define __TELEMETRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define TELEMETRY_VERSION           0x01U
+#define TELEMETRY_REPORT_SIZE       32U
+#define TELEMETRY_MIN_INTERVAL_MS   20U
+#define TELEMETRY_HEARTBEAT_MS      1000U
+
+/* Exported functions prototypes ---------------------------------------------*/
+void TELEMETRY_Poll(uint32_t now, uint8_t led_state, uint32_t commands);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TELEMETRY_H */
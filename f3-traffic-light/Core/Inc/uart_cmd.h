@@ -0,0 +1,42 @@
+/**
+  ******************************************************************************
+  * @file           : uart_cmd.h
+  * @brief          : DMA driven USART command receiver.
+  ******************************************************************************
+  * USART1 is received into a circular DMA buffer. Half-transfer, transfer
+  * complete and idle-line events copy the freshly arrived bytes into a
+  * lock-free ring that the main loop drains at its own pace.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_CMD_H
+#define __UART_CMD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Circular DMA area, sized for one idle-line/half-transfer period at 115200 */
+#define UART_CMD_DMA_BUF_SIZE   64U
+/* Command ring between the interrupt and the main loop, power of two */
+#define UART_CMD_RING_SIZE      256U
+
+/* Lamp state carried by a command byte: bits 0..2, the rest is ignored */
+#define UART_CMD_STATE(cmd)     ((uint8_t)((cmd) & 7U))
+
+/* Exported functions prototypes ---------------------------------------------*/
+void UART_CMD_Start(UART_HandleTypeDef *huart);
+uint8_t UART_CMD_GetByte(uint8_t *byte);
+void UART_CMD_Poll(void);
+uint32_t UART_CMD_GetOverruns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_CMD_H */
@@ -0,0 +1,152 @@
+/**
+  ******************************************************************************
+  * @file           : app_events.c
+  * @brief          : Event queue and sleep handling of the main loop.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "app_events.h"
+
+/* Private variables ---------------------------------------------------------*/
+static APP_EVT_TypeDef evt_queue[APP_EVT_QUEUE_SIZE];
+static volatile uint32_t evt_head;
+static volatile uint32_t evt_tail;
+
+static APP_EVT_StatsTypeDef evt_stats;
+
+/* Accounting of the current one second window */
+static uint32_t window_start_tick;
+static uint32_t window_wakeups;
+static uint32_t window_active_cycles;
+static uint32_t awake_since_cycle;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Reset the queue and start the DWT cycle counter used for the
+  *         active time measurement.
+  */
+void APP_EVT_Init(void)
+{
+  evt_head = 0U;
+  evt_tail = 0U;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0U;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  window_start_tick = HAL_GetTick();
+  awake_since_cycle = DWT->CYCCNT;
+}
+
+/**
+  * @brief  Queue an event. Safe to call from any interrupt priority.
+  * @param  id: event identifier
+  * @param  value: event payload
+  * @retval 1 if queued, 0 if the queue was full and the event was dropped
+  */
+uint8_t APP_EVT_Post(APP_EVT_IdTypeDef id, uint32_t value)
+{
+  uint8_t ret = 0U;
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if ((evt_head - evt_tail) < APP_EVT_QUEUE_SIZE)
+  {
+    evt_queue[evt_head & (APP_EVT_QUEUE_SIZE - 1U)].Id = id;
+    evt_queue[evt_head & (APP_EVT_QUEUE_SIZE - 1U)].Value = value;
+    evt_queue[evt_head & (APP_EVT_QUEUE_SIZE - 1U)].Stamp = DWT->CYCCNT;
+    evt_head++;
+    ret = 1U;
+  }
+  else
+  {
+    evt_stats.Dropped++;
+  }
+  __set_PRIMASK(primask);
+
+  return ret;
+}
+
+/**
+  * @brief  Take the oldest event out of the queue and account for how long
+  *         it waited. Main loop only.
+  * @param  evt: destination
+  * @retval 1 if an event was returned, 0 if the queue is empty
+  */
+uint8_t APP_EVT_Get(APP_EVT_TypeDef *evt)
+{
+  uint32_t tail = evt_tail;
+  uint32_t latency_us;
+  uint32_t bucket = 0U;
+
+  if (evt_head == tail)
+  {
+    return 0U;
+  }
+  *evt = evt_queue[tail & (APP_EVT_QUEUE_SIZE - 1U)];
+  __DMB();
+  evt_tail = tail + 1U;
+
+  latency_us = (DWT->CYCCNT - evt->Stamp) / (SystemCoreClock / 1000000U);
+  while ((latency_us != 0U) && (bucket < (APP_EVT_LATENCY_BUCKETS - 1U)))
+  {
+    latency_us >>= 1;
+    bucket++;
+  }
+  evt_stats.LatencyHist[bucket]++;
+  return 1U;
+}
+
+/**
+  * @brief  Sleep until an interrupt posts something, unless events are
+  *         already pending. Interrupts are masked around the emptiness check
+  *         so that an event posted just before WFI still wakes the core up.
+  */
+void APP_EVT_WaitForEvent(void)
+{
+  uint32_t now;
+
+  __disable_irq();
+  if (evt_head == evt_tail)
+  {
+    window_active_cycles += DWT->CYCCNT - awake_since_cycle;
+    __DSB();
+    __WFI();
+    awake_since_cycle = DWT->CYCCNT;
+    window_wakeups++;
+  }
+  __enable_irq();
+
+  now = HAL_GetTick();
+  if ((now - window_start_tick) >= 1000U)
+  {
+    uint32_t window_cycles = (SystemCoreClock / 1000U) * (now - window_start_tick);
+    uint32_t cycle = DWT->CYCCNT;
+
+    /* Close the current awake period so a loop that never sleeps still
+       counts, and the next window does not inherit it */
+    window_active_cycles += cycle - awake_since_cycle;
+    awake_since_cycle = cycle;
+    if (window_active_cycles > window_cycles)
+    {
+      /* The tick only bounds the window to the millisecond */
+      window_active_cycles = window_cycles;
+    }
+
+    evt_stats.WakeupsPerSec = (window_wakeups * 1000U) / (now - window_start_tick);
+    evt_stats.ActivePermille = (uint32_t)(((uint64_t)window_active_cycles * 1000U) / window_cycles);
+    window_start_tick = now;
+    window_wakeups = 0U;
+    window_active_cycles = 0U;
+  }
+}
+
+/**
+  * @brief  Statistics of the last complete one second window.
+  */
+const APP_EVT_StatsTypeDef *APP_EVT_GetStats(void)
+{
+  return &evt_stats;
+}
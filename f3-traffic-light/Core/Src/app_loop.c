@@ -0,0 +1,118 @@
+/**
+  ******************************************************************************
+  * @file           : app_loop.c
+  * @brief          : Command dispatch of the main loop.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "app_loop.h"
+#include "app_events.h"
+#include "uart_cmd.h"
+#include "lamps.h"
+#include "lamp_stream.h"
+#include "lamp_seq.h"
+#include "lamp_fade.h"
+#include "telemetry.h"
+#include "usbd_winusb_if.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t led_state;
+/* Commands applied from USB and UART, reported in the telemetry */
+static uint32_t cmd_count;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Switch the lamps off. The lamp modules must be initialised.
+  */
+void APP_LOOP_Init(void)
+{
+  led_state = 0U;
+  cmd_count = 0U;
+  Lamps_Write(led_state);
+}
+
+/**
+  * @brief  Handle everything that is pending, then return so the caller can
+  *         sleep until the next event.
+  */
+void APP_LOOP_Process(void)
+{
+  uint8_t applied_state = led_state;
+  uint8_t level_changed = 0U;
+  APP_EVT_TypeDef evt;
+  uint8_t uart_cmd;
+  uint8_t stream_state;
+  uint8_t *rx_buf;
+  uint32_t rx_len;
+
+  while (APP_EVT_Get(&evt))
+  {
+    switch (evt.Id)
+    {
+      case APP_EVT_SET_STATE:
+        LAMP_SEQ_Stop();
+        if (evt.Value & APP_EVT_STATE_HAS_LEVEL)
+        {
+          LAMP_FADE_SetLevel((uint8_t)(evt.Value >> 8), (uint8_t)(evt.Value >> 16));
+          level_changed = 1U;
+        }
+        led_state = (uint8_t)(evt.Value & 7U);
+        cmd_count++;
+        break;
+
+      case APP_EVT_UART_RX:
+        while (UART_CMD_GetByte(&uart_cmd))
+        {
+          LAMP_SEQ_Stop();
+          led_state = UART_CMD_STATE(uart_cmd);
+          cmd_count++;
+        }
+        break;
+
+      case APP_EVT_SEQ_LOAD:
+        LAMP_STREAM_Reset();
+        (void)LAMP_SEQ_ProcessUpload();
+        cmd_count++;
+        break;
+
+      case APP_EVT_SEQ_STEP:
+        /* The timer interrupt has already driven the lamps */
+        if (LAMP_SEQ_IsCurrent(evt.Value >> 8))
+        {
+          led_state = (uint8_t)(evt.Value & 7U);
+          applied_state = led_state;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  /* The queue has room again: repost UART data whose event was refused */
+  UART_CMD_Poll();
+
+  /* Bulk stream frames are parsed in place in the USB receive slots; the
+     USB interrupt that filled them has already woken the loop */
+  while (USBD_WINUSB_RxAcquire_FS(&rx_buf, &rx_len))
+  {
+    (void)LAMP_STREAM_PutFrame(rx_buf, rx_len);
+    USBD_WINUSB_RxRelease_FS();
+  }
+
+  /* Streamed steps are timed against SysTick, which also wakes the loop */
+  if (LAMP_STREAM_Poll(HAL_GetTick(), &stream_state))
+  {
+    LAMP_SEQ_Stop();
+    led_state = stream_state & 7;
+  }
+
+  if ((led_state != applied_state) || level_changed)
+  {
+    Lamps_Write(led_state);
+  }
+
+  TELEMETRY_Poll(HAL_GetTick(), led_state, cmd_count);
+}
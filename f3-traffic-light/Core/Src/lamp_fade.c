@@ -0,0 +1,227 @@
+/**
+  ******************************************************************************
+  * @file           : lamp_fade.c
+  * @brief          : PWM dimming and DMA driven fades of the external lamps.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "lamp_fade.h"
+#include "lamps.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  TIM_TypeDef           *Tim;
+  __IO uint32_t         *Ccr;
+  DMA_Channel_TypeDef   *Dma;
+  uint32_t              StateBit;
+} LAMP_FADE_ChannelTypeDef;
+
+/* Ramp descriptor of the fade in progress on one channel */
+typedef struct
+{
+  uint8_t  From;
+  uint8_t  To;
+  uint16_t Samples;
+} LAMP_FADE_RampTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+/* 16 MHz counter and 16000 steps: 1 kHz PWM */
+#define LAMP_FADE_COUNTER_HZ      16000000U
+#define LAMP_FADE_PWM_TOP         16000U
+/* PWM periods per DMA sample, loaded into the repetition counter */
+#define LAMP_FADE_PERIODS_PER_SAMPLE \
+  ((LAMP_FADE_COUNTER_HZ / LAMP_FADE_PWM_TOP) * LAMP_FADE_SAMPLE_MS / 1000U)
+
+/* Private variables ---------------------------------------------------------*/
+static const LAMP_FADE_ChannelTypeDef fade_channels[LAMP_FADE_CHANNEL_NBR] =
+{
+  { TIM8, &TIM8->CCR3, DMA2_Channel1, LAMPS_STATE_GREEN },
+  { TIM1, &TIM1->CCR1, DMA1_Channel2, LAMPS_STATE_YELLOW },
+  { TIM1, &TIM1->CCR3, DMA1_Channel6, LAMPS_STATE_RED },
+};
+
+/* Compare value of each level, round(16000 * (level / 255) ^ 2.2) */
+static const uint16_t fade_gamma[LAMP_FADE_LEVEL_MAX + 1U] =
+{
+      0,     0,     0,     1,     2,     3,     4,     6,     8,    10,    13,    16,    19,    23,    27,    31,
+     36,    41,    47,    53,    59,    66,    73,    80,    88,    97,   105,   114,   124,   134,   144,   155,
+    166,   178,   190,   203,   216,   229,   243,   257,   272,   287,   303,   319,   335,   352,   370,   388,
+    406,   425,   444,   464,   484,   505,   526,   548,   570,   592,   616,   639,   663,   688,   713,   738,
+    764,   791,   818,   845,   873,   902,   931,   961,   991,  1021,  1052,  1084,  1116,  1148,  1181,  1215,
+   1249,  1284,  1319,  1354,  1390,  1427,  1464,  1502,  1540,  1579,  1618,  1658,  1698,  1739,  1781,  1823,
+   1865,  1908,  1952,  1996,  2040,  2086,  2131,  2178,  2224,  2272,  2320,  2368,  2417,  2466,  2516,  2567,
+   2618,  2670,  2722,  2775,  2828,  2882,  2937,  2992,  3047,  3104,  3160,  3218,  3275,  3334,  3393,  3452,
+   3512,  3573,  3634,  3696,  3758,  3821,  3885,  3949,  4013,  4079,  4144,  4211,  4278,  4345,  4413,  4482,
+   4551,  4621,  4691,  4762,  4834,  4906,  4979,  5052,  5126,  5201,  5276,  5351,  5428,  5504,  5582,  5660,
+   5738,  5818,  5897,  5978,  6059,  6140,  6223,  6305,  6389,  6473,  6557,  6642,  6728,  6814,  6901,  6989,
+   7077,  7166,  7255,  7345,  7436,  7527,  7619,  7711,  7804,  7898,  7992,  8087,  8182,  8278,  8375,  8472,
+   8570,  8669,  8768,  8868,  8968,  9069,  9171,  9273,  9376,  9479,  9583,  9688,  9793,  9899, 10006, 10113,
+  10220, 10329, 10438, 10548, 10658, 10769, 10880, 10992, 11105, 11219, 11333, 11447, 11563, 11679, 11795, 11912,
+  12030, 12149, 12268, 12388, 12508, 12629, 12751, 12873, 12996, 13119, 13244, 13368, 13494, 13620, 13747, 13874,
+  14002, 14131, 14260, 14390, 14521, 14652, 14784, 14916, 15050, 15183, 15318, 15453, 15589, 15725, 15862, 16000
+};
+
+static LAMP_FADE_RampTypeDef fade_ramp[LAMP_FADE_CHANNEL_NBR];
+static uint16_t fade_buf[LAMP_FADE_CHANNEL_NBR][LAMP_FADE_MAX_SAMPLES];
+
+/* Level of a lit lamp and fade time in samples for the next state change */
+static volatile uint8_t fade_level = LAMP_FADE_LEVEL_MAX;
+static volatile uint8_t fade_samples;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Set a timer up for 1 kHz PWM with preloaded compare registers and
+  *         compare DMA requests issued on the (repetition counted) update.
+  * @param  tim: TIM1 or TIM8
+  * @param  timclk: timer kernel clock
+  */
+static void LAMP_FADE_TimerInit(TIM_TypeDef *tim, uint32_t timclk)
+{
+  tim->CR1 = 0U;
+  tim->PSC = (timclk / LAMP_FADE_COUNTER_HZ) - 1U;
+  tim->ARR = LAMP_FADE_PWM_TOP - 1U;
+  tim->RCR = LAMP_FADE_PERIODS_PER_SAMPLE - 1U;
+  /* PWM mode 1 with preload on channels 1 and 3 */
+  tim->CCMR1 = TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1PE;
+  tim->CCMR2 = TIM_CCMR2_OC3M_2 | TIM_CCMR2_OC3M_1 | TIM_CCMR2_OC3PE;
+  tim->CCR1 = 0U;
+  tim->CCR3 = 0U;
+  tim->CR2 = TIM_CR2_CCDS;
+  tim->BDTR = TIM_BDTR_MOE;
+  tim->EGR = TIM_EGR_UG;
+  tim->CR1 = TIM_CR1_ARPE | TIM_CR1_CEN;
+}
+
+/**
+  * @brief  Level a channel is showing right now, part way through a fade.
+  * @param  ch: channel index
+  * @retval level 0..LAMP_FADE_LEVEL_MAX
+  */
+static uint8_t LAMP_FADE_Current(uint32_t ch)
+{
+  const LAMP_FADE_RampTypeDef *ramp = &fade_ramp[ch];
+  int32_t done;
+
+  if (((fade_channels[ch].Dma->CCR & DMA_CCR_EN) == 0U) || (ramp->Samples == 0U))
+  {
+    return ramp->To;
+  }
+  done = (int32_t)ramp->Samples - (int32_t)fade_channels[ch].Dma->CNDTR;
+  return (uint8_t)(ramp->From + ((int32_t)ramp->To - ramp->From) * done / ramp->Samples);
+}
+
+/**
+  * @brief  Fade one channel to a new level.
+  * @param  ch: channel index
+  * @param  to: target level
+  * @param  samples: fade time in samples, 0 to switch at once
+  */
+static void LAMP_FADE_Start(uint32_t ch, uint8_t to, uint32_t samples)
+{
+  const LAMP_FADE_ChannelTypeDef *c = &fade_channels[ch];
+  LAMP_FADE_RampTypeDef *ramp = &fade_ramp[ch];
+  uint8_t from = LAMP_FADE_Current(ch);
+  uint32_t i;
+
+  c->Dma->CCR = 0U;
+
+  if ((samples == 0U) || (from == to))
+  {
+    ramp->From = to;
+    ramp->To = to;
+    ramp->Samples = 0U;
+    *c->Ccr = fade_gamma[to];
+    return;
+  }
+
+  for (i = 0U; i < samples; i++)
+  {
+    fade_buf[ch][i] = fade_gamma[from + ((int32_t)to - from) * (int32_t)(i + 1U) / (int32_t)samples];
+  }
+  ramp->From = from;
+  ramp->To = to;
+  ramp->Samples = (uint16_t)samples;
+
+  c->Dma->CPAR = (uint32_t)c->Ccr;
+  c->Dma->CMAR = (uint32_t)fade_buf[ch];
+  c->Dma->CNDTR = samples;
+  /* Half words from memory, zero extended into the 32-bit compare register */
+  c->Dma->CCR = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_MSIZE_0 | DMA_CCR_PSIZE_1 |
+                DMA_CCR_PL_1 | DMA_CCR_EN;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Move the external lamp pins to their timer channels and start the
+  *         PWM with all lamps off.
+  */
+void LAMP_FADE_Init(void)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+  uint32_t timclk = HAL_RCC_GetPCLK2Freq();
+
+  /* Timer clocks run at twice PCLK2 whenever APB2 is divided */
+  if ((RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1)
+  {
+    timclk *= 2U;
+  }
+
+  __HAL_RCC_TIM1_CLK_ENABLE();
+  __HAL_RCC_TIM8_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  LAMP_FADE_TimerInit(TIM1, timclk);
+  LAMP_FADE_TimerInit(TIM8, timclk);
+  TIM1->DIER = TIM_DIER_CC1DE | TIM_DIER_CC3DE;
+  TIM1->CCER = TIM_CCER_CC1E | TIM_CCER_CC3E;
+  TIM8->DIER = TIM_DIER_CC3DE;
+  TIM8->CCER = TIM_CCER_CC3E;
+
+  GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+  GPIO_InitStruct.Pin = EXT_TRAFFIC_GR_Pin;
+  GPIO_InitStruct.Alternate = GPIO_AF4_TIM8;
+  HAL_GPIO_Init(EXT_TRAFFIC_GR_GPIO_Port, &GPIO_InitStruct);
+  GPIO_InitStruct.Pin = EXT_TRAFFIC_YL_Pin | EXT_TRAFFIC_RED_Pin;
+  GPIO_InitStruct.Alternate = GPIO_AF6_TIM1;
+  HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+}
+
+/**
+  * @brief  Set the brightness and fade time used from the next state change on.
+  * @param  level: brightness of a lit lamp, 0..255 before gamma correction
+  * @param  fade: fade time in 10 ms samples, 0 to switch at once
+  */
+void LAMP_FADE_SetLevel(uint8_t level, uint8_t fade)
+{
+  fade_level = level;
+  fade_samples = fade;
+}
+
+/**
+  * @brief  Fade every external lamp towards the given state. Lamps already
+  *         heading for their new level are left alone.
+  * @param  state: bit0 = green, bit1 = yellow, bit2 = red
+  */
+void LAMP_FADE_Write(uint8_t state)
+{
+  uint8_t level = fade_level;
+  uint8_t samples = fade_samples;
+  uint8_t to;
+  uint32_t ch;
+
+  for (ch = 0U; ch < LAMP_FADE_CHANNEL_NBR; ch++)
+  {
+    to = (state & fade_channels[ch].StateBit) ? level : 0U;
+    if (to != fade_ramp[ch].To)
+    {
+      LAMP_FADE_Start(ch, to, samples);
+    }
+  }
+}
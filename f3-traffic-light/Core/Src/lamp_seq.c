@@ -0,0 +1,319 @@
+/**
+  ******************************************************************************
+  * @file           : lamp_seq.c
+  * @brief          : Preloaded lamp sequences played back from TIM6.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "lamp_seq.h"
+#include "lamps.h"
+#include "app_events.h"
+
+/* Private define ------------------------------------------------------------*/
+/* TIM6 counts milliseconds; one update period covers at most 2^16 ms */
+#define LAMP_SEQ_TIMER_HZ       1000U
+#define LAMP_SEQ_MAX_PERIOD_MS  0x10000U
+
+/* Private variables ---------------------------------------------------------*/
+/* Upload handed over by LAMP_SEQ_Submit (USB interrupt) to
+   LAMP_SEQ_ProcessUpload (main loop); non-zero length while pending */
+static uint8_t seq_upload[LAMP_SEQ_MAX_SIZE];
+static volatile uint32_t seq_upload_len;
+
+/* Active sequence, written by the main loop only while TIM6 is stopped */
+static uint16_t seq_steps[LAMP_SEQ_MAX_STEPS];
+static uint32_t seq_count;
+static uint8_t seq_loop;
+
+/* Playback position, owned by the timer interrupt while it runs */
+static uint32_t seq_index;
+static uint32_t seq_remaining_ms;
+
+/* Bumped on every stop so step events of an old sequence can be told apart */
+static volatile uint32_t seq_generation;
+
+static LAMP_SEQ_StatsTypeDef seq_stats;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Load the next timer period; steps longer than the 16-bit counter
+  *         are split and the rest is kept in seq_remaining_ms.
+  * @param  ms: time until the next step
+  */
+static void LAMP_SEQ_ArmPeriod(uint32_t ms)
+{
+  if (ms > LAMP_SEQ_MAX_PERIOD_MS)
+  {
+    seq_remaining_ms = ms - LAMP_SEQ_MAX_PERIOD_MS;
+    ms = LAMP_SEQ_MAX_PERIOD_MS;
+  }
+  else
+  {
+    seq_remaining_ms = 0U;
+  }
+  /* ARR is not preloaded: the new period applies to the one just started */
+  TIM6->ARR = ms - 1U;
+}
+
+/**
+  * @brief  Drive the lamps and tell the main loop about the new state.
+  * @param  state: lamp state
+  */
+static void LAMP_SEQ_Apply(uint8_t state)
+{
+  Lamps_Write(state);
+  seq_stats.Steps++;
+  (void)APP_EVT_Post(APP_EVT_SEQ_STEP, (uint32_t)state | (seq_generation << 8));
+}
+
+/**
+  * @brief  Stop TIM6 and discard a pending update interrupt.
+  */
+static void LAMP_SEQ_TimerHalt(void)
+{
+  TIM6->DIER = 0U;
+  TIM6->CR1 &= ~TIM_CR1_CEN;
+  TIM6->SR = 0U;
+  NVIC_ClearPendingIRQ(TIM6_DAC_IRQn);
+}
+
+/**
+  * @brief  Start the active sequence at the given phase. TIM6 must be stopped.
+  * @param  phase_ms: offset into the sequence
+  */
+static void LAMP_SEQ_Start(uint32_t phase_ms)
+{
+  uint32_t total_ms = 0U;
+  uint32_t step_ms;
+  uint32_t i;
+
+  for (i = 0U; i < seq_count; i++)
+  {
+    total_ms += LAMP_SEQ_STEP_UNITS(seq_steps[i]) * LAMP_SEQ_TIME_UNIT_MS;
+  }
+
+  if (phase_ms >= total_ms)
+  {
+    if (!seq_loop)
+    {
+      /* Already past the end: just hold the final state */
+      seq_index = seq_count - 1U;
+      LAMP_SEQ_Apply(LAMP_SEQ_STEP_STATE(seq_steps[seq_index]));
+      return;
+    }
+    phase_ms %= total_ms;
+  }
+
+  for (i = 0U; ; i++)
+  {
+    step_ms = LAMP_SEQ_STEP_UNITS(seq_steps[i]) * LAMP_SEQ_TIME_UNIT_MS;
+    if (phase_ms < step_ms)
+    {
+      break;
+    }
+    phase_ms -= step_ms;
+  }
+
+  seq_index = i;
+  TIM6->CNT = 0U;
+  LAMP_SEQ_ArmPeriod(step_ms - phase_ms);
+  LAMP_SEQ_Apply(LAMP_SEQ_STEP_STATE(seq_steps[i]));
+  TIM6->SR = 0U;
+  TIM6->DIER = TIM_DIER_UIE;
+  TIM6->CR1 |= TIM_CR1_CEN;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Set TIM6 up as a millisecond counter. The timer stays stopped
+  *         until a sequence is loaded.
+  */
+void LAMP_SEQ_Init(void)
+{
+  uint32_t timclk = HAL_RCC_GetPCLK1Freq();
+
+  /* Timer clocks run at twice PCLK1 whenever APB1 is divided */
+  if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+  {
+    timclk *= 2U;
+  }
+
+  __HAL_RCC_TIM6_CLK_ENABLE();
+  TIM6->CR1 = TIM_CR1_URS;
+  TIM6->PSC = (timclk / LAMP_SEQ_TIMER_HZ) - 1U;
+  TIM6->ARR = 0xFFFFU;
+  /* Load the prescaler; URS keeps this from raising an update interrupt */
+  TIM6->EGR = TIM_EGR_UG;
+  LAMP_SEQ_TimerHalt();
+
+  HAL_NVIC_SetPriority(TIM6_DAC_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(TIM6_DAC_IRQn);
+}
+
+/**
+  * @brief  Validate an uploaded sequence and keep a copy for the main loop.
+  *         Meant for the USB interrupt; post APP_EVT_SEQ_LOAD on success.
+  * @param  buf: packed sequence
+  * @param  len: its length
+  * @retval 1 if the upload was taken, 0 if it was malformed or the previous
+  *         one is still pending
+  */
+uint8_t LAMP_SEQ_Submit(const uint8_t *buf, uint32_t len)
+{
+  uint32_t count, i;
+
+  if ((seq_upload_len != 0U) || (len < LAMP_SEQ_HEADER_SIZE))
+  {
+    seq_stats.Rejected++;
+    return 0U;
+  }
+  count = buf[1];
+  if ((count > LAMP_SEQ_MAX_STEPS) ||
+      (len != LAMP_SEQ_HEADER_SIZE + count * LAMP_SEQ_STEP_SIZE))
+  {
+    seq_stats.Rejected++;
+    return 0U;
+  }
+  for (i = 0U; i < count; i++)
+  {
+    /* Zero length steps would stall the timer */
+    if (LAMP_SEQ_STEP_UNITS(buf[LAMP_SEQ_HEADER_SIZE + 2U * i] |
+                            (buf[LAMP_SEQ_HEADER_SIZE + 2U * i + 1U] << 8)) == 0U)
+    {
+      seq_stats.Rejected++;
+      return 0U;
+    }
+  }
+
+  for (i = 0U; i < len; i++)
+  {
+    seq_upload[i] = buf[i];
+  }
+  seq_upload_len = len;
+  return 1U;
+}
+
+/**
+  * @brief  Give up a submitted upload the main loop could not be told about.
+  *         Same context as LAMP_SEQ_Submit.
+  */
+void LAMP_SEQ_DropUpload(void)
+{
+  if (seq_upload_len != 0U)
+  {
+    seq_upload_len = 0U;
+    seq_stats.Rejected++;
+  }
+}
+
+/**
+  * @brief  Replace the running sequence with the pending upload. Main loop
+  *         only.
+  * @retval 1 if a new sequence started, 0 if there was none or it was empty
+  */
+uint8_t LAMP_SEQ_ProcessUpload(void)
+{
+  uint32_t i;
+  uint32_t phase_ms;
+  uint32_t primask;
+
+  if (seq_upload_len == 0U)
+  {
+    return 0U;
+  }
+
+  LAMP_SEQ_Stop();
+
+  seq_loop = (uint8_t)(seq_upload[0] & LAMP_SEQ_FLAG_LOOP);
+  seq_count = seq_upload[1];
+  phase_ms = (uint32_t)(seq_upload[2] | (seq_upload[3] << 8)) * LAMP_SEQ_TIME_UNIT_MS;
+  for (i = 0U; i < seq_count; i++)
+  {
+    seq_steps[i] = (uint16_t)(seq_upload[LAMP_SEQ_HEADER_SIZE + 2U * i] |
+                              (seq_upload[LAMP_SEQ_HEADER_SIZE + 2U * i + 1U] << 8));
+  }
+  /* Free the staging buffer for the next upload */
+  seq_upload_len = 0U;
+
+  if (seq_count == 0U)
+  {
+    return 0U;
+  }
+
+  seq_stats.Uploads++;
+  primask = __get_PRIMASK();
+  __disable_irq();
+  LAMP_SEQ_Start(phase_ms);
+  __set_PRIMASK(primask);
+  return 1U;
+}
+
+/**
+  * @brief  Stop the running sequence, leaving the lamps as they are. Step
+  *         events already queued become stale. Main loop only.
+  */
+void LAMP_SEQ_Stop(void)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  LAMP_SEQ_TimerHalt();
+  seq_generation++;
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Check whether a step event belongs to the running sequence.
+  * @param  generation: Value of the APP_EVT_SEQ_STEP event shifted right by 8
+  * @retval 1 if the event is current, 0 if the sequence was stopped since
+  */
+uint8_t LAMP_SEQ_IsCurrent(uint32_t generation)
+{
+  return (uint8_t)(generation == (seq_generation & 0x00FFFFFFU));
+}
+
+/**
+  * @brief  TIM6 update interrupt: advance to the next step.
+  */
+void LAMP_SEQ_IRQHandler(void)
+{
+  uint32_t next;
+
+  if ((TIM6->SR & TIM_SR_UIF) == 0U)
+  {
+    return;
+  }
+  TIM6->SR = ~TIM_SR_UIF;
+
+  if (seq_remaining_ms != 0U)
+  {
+    LAMP_SEQ_ArmPeriod(seq_remaining_ms);
+    return;
+  }
+
+  next = seq_index + 1U;
+  if (next >= seq_count)
+  {
+    if (!seq_loop)
+    {
+      LAMP_SEQ_TimerHalt();
+      return;
+    }
+    next = 0U;
+    seq_stats.Loops++;
+  }
+  seq_index = next;
+  LAMP_SEQ_ArmPeriod(LAMP_SEQ_STEP_UNITS(seq_steps[next]) * LAMP_SEQ_TIME_UNIT_MS);
+  LAMP_SEQ_Apply(LAMP_SEQ_STEP_STATE(seq_steps[next]));
+}
+
+/**
+  * @brief  Sequence counters.
+  */
+const LAMP_SEQ_StatsTypeDef *LAMP_SEQ_GetStats(void)
+{
+  return &seq_stats;
+}
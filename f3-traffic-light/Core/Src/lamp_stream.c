@@ -0,0 +1,164 @@
+/**
+  ******************************************************************************
+  * @file           : lamp_stream.c
+  * @brief          : Timed lamp steps streamed over the WinUSB bulk endpoint.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "lamp_stream.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint8_t  State;
+  uint16_t HoldMs;
+} LAMP_STREAM_StepTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+/* Filled and emptied by the main loop */
+static LAMP_STREAM_StepTypeDef stream_queue[LAMP_STREAM_QUEUE_SIZE];
+static uint32_t stream_head;
+static uint32_t stream_tail;
+/* Set by LAMP_STREAM_Reset, which may run in the USB interrupt */
+static volatile uint8_t stream_reset_pending;
+
+static LAMP_STREAM_StatsTypeDef stream_stats;
+static uint8_t stream_next_seq;
+static uint8_t stream_synced;
+
+/* Playback of the current step */
+static uint8_t stream_playing;
+static uint32_t stream_step_start;
+static uint32_t stream_step_hold;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Carry out a reset requested by LAMP_STREAM_Reset.
+  */
+static void LAMP_STREAM_ApplyReset(void)
+{
+  if (stream_reset_pending != 0U)
+  {
+    stream_reset_pending = 0U;
+    stream_tail = stream_head;
+    stream_synced = 0U;
+    stream_playing = 0U;
+  }
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Drop all queued steps and resynchronise on the next sequence number.
+  *         Safe to call from an interrupt; takes effect on the next
+  *         LAMP_STREAM_PutFrame or LAMP_STREAM_Poll.
+  */
+void LAMP_STREAM_Reset(void)
+{
+  stream_reset_pending = 1U;
+}
+
+/**
+  * @brief  Queue the steps of one received frame. Main loop only; the frame
+  *         is read in place from the USB receive slot.
+  * @param  buf: frame
+  * @param  len: frame length
+  * @retval 1 if the frame was accepted, 0 if it was malformed
+  */
+uint8_t LAMP_STREAM_PutFrame(const uint8_t *buf, uint32_t len)
+{
+  uint32_t count, i;
+  uint32_t head;
+  uint8_t seq_diff;
+
+  LAMP_STREAM_ApplyReset();
+  head = stream_head;
+
+  if ((len < LAMP_STREAM_HEADER_SIZE) ||
+      (len < LAMP_STREAM_HEADER_SIZE + (uint32_t)buf[1] * LAMP_STREAM_STEP_SIZE))
+  {
+    stream_stats.Malformed++;
+    return 0U;
+  }
+
+  seq_diff = (uint8_t)(buf[0] - stream_next_seq);
+  if (stream_synced && (seq_diff != 0U))
+  {
+    /* A frame behind the expected one wraps to a large difference: it is a
+       repeat or a late frame, not 255 lost ones. Either way the stream
+       resynchronises on it */
+    if (seq_diff < 128U)
+    {
+      stream_stats.SeqGaps += seq_diff;
+    }
+    else
+    {
+      stream_stats.Reordered++;
+    }
+  }
+  stream_next_seq = (uint8_t)(buf[0] + 1U);
+  stream_synced = 1U;
+  stream_stats.Frames++;
+
+  count = buf[1];
+  buf += LAMP_STREAM_HEADER_SIZE;
+  for (i = 0U; i < count; i++, buf += LAMP_STREAM_STEP_SIZE)
+  {
+    if ((head - stream_tail) >= LAMP_STREAM_QUEUE_SIZE)
+    {
+      stream_stats.Dropped += count - i;
+      break;
+    }
+    stream_queue[head & (LAMP_STREAM_QUEUE_SIZE - 1U)].State = buf[0];
+    stream_queue[head & (LAMP_STREAM_QUEUE_SIZE - 1U)].HoldMs = (uint16_t)(buf[1] | (buf[2] << 8));
+    head++;
+  }
+  stream_head = head;
+
+  return 1U;
+}
+
+/**
+  * @brief  Advance the playback. Main loop only.
+  * @param  now: current time in ms (HAL_GetTick)
+  * @param  state: receives the lamp state of a newly started step
+  * @retval 1 if a new step started and *state is valid, 0 otherwise
+  */
+uint8_t LAMP_STREAM_Poll(uint32_t now, uint8_t *state)
+{
+  uint32_t tail;
+  LAMP_STREAM_StepTypeDef step;
+
+  LAMP_STREAM_ApplyReset();
+  tail = stream_tail;
+
+  if (stream_playing && ((now - stream_step_start) < stream_step_hold))
+  {
+    return 0U;
+  }
+  if (stream_head == tail)
+  {
+    stream_playing = 0U;
+    return 0U;
+  }
+
+  step = stream_queue[tail & (LAMP_STREAM_QUEUE_SIZE - 1U)];
+  stream_tail = tail + 1U;
+
+  /* Chain steps back to back so rounding does not accumulate */
+  stream_step_start = stream_playing ? (stream_step_start + stream_step_hold) : now;
+  stream_step_hold = step.HoldMs;
+  stream_playing = 1U;
+  *state = step.State;
+  return 1U;
+}
+
+/**
+  * @brief  Stream counters.
+  */
+const LAMP_STREAM_StatsTypeDef *LAMP_STREAM_GetStats(void)
+{
+  return &stream_stats;
+}
@@ -0,0 +1,146 @@
+/**
+  ******************************************************************************
+  * @file           : lamps.c
+  * @brief          : Traffic light lamp outputs.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "lamps.h"
+#include "lamp_fade.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Ports carrying lamps, in the order they are written */
+#define LAMPS_PORT_NBR      1U
+
+/* Private macro -------------------------------------------------------------*/
+/* Pin mask of a main.h pin if it lives on the given port, 0 otherwise */
+#define LAMPS_PIN(port, name) \
+  ((((name##_GPIO_Port) == (port))) ? (uint32_t)(name##_Pin) : 0U)
+
+#define LAMPS_GREEN(port)   (LAMPS_PIN(port, LD6) | LAMPS_PIN(port, LD7))
+#define LAMPS_YELLOW(port)  (LAMPS_PIN(port, LD5) | LAMPS_PIN(port, LD8))
+#define LAMPS_RED(port)     (LAMPS_PIN(port, LD3) | LAMPS_PIN(port, LD10))
+#define LAMPS_ALL(port)     (LAMPS_GREEN(port) | LAMPS_YELLOW(port) | LAMPS_RED(port))
+
+#define LAMPS_SET(port, state)                                   \
+  ((((state) & LAMPS_STATE_GREEN) ? LAMPS_GREEN(port) : 0U) |    \
+   (((state) & LAMPS_STATE_YELLOW) ? LAMPS_YELLOW(port) : 0U) |  \
+   (((state) & LAMPS_STATE_RED) ? LAMPS_RED(port) : 0U))
+
+/* BSRR: low half sets, high half resets the lamps that must be off */
+#define LAMPS_BSRR(port, state) \
+  (LAMPS_SET(port, state) | ((LAMPS_ALL(port) & ~LAMPS_SET(port, state)) << 16))
+
+#define LAMPS_BSRR_ROW(port)                                  \
+  { LAMPS_BSRR(port, 0U), LAMPS_BSRR(port, 1U),               \
+    LAMPS_BSRR(port, 2U), LAMPS_BSRR(port, 3U),               \
+    LAMPS_BSRR(port, 4U), LAMPS_BSRR(port, 5U),               \
+    LAMPS_BSRR(port, 6U), LAMPS_BSRR(port, 7U) }
+
+/* Private variables ---------------------------------------------------------*/
+static const uint32_t lamps_bsrr[LAMPS_PORT_NBR][LAMPS_STATE_MASK + 1U] =
+{
+  LAMPS_BSRR_ROW(GPIOE),
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Switch the on-board LEDs.
+  * @param  state: bit0 = green, bit1 = yellow, bit2 = red
+  */
+static void Lamps_WriteBoard(uint8_t state)
+{
+  GPIOE->BSRR = lamps_bsrr[0][state & LAMPS_STATE_MASK];
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Drive the on-board and external lamps from a 3-bit state. The
+  *         external lamps fade with the lamp_fade brightness settings.
+  * @param  state: bit0 = green, bit1 = yellow, bit2 = red
+  */
+void Lamps_Write(uint8_t state)
+{
+  state &= LAMPS_STATE_MASK;
+  Lamps_WriteBoard(state);
+  LAMP_FADE_Write(state);
+}
+
+#ifdef LAMPS_BENCHMARK
+/**
+  * @brief  Reference implementation: one HAL_GPIO_WritePin call per lamp.
+  * @param  state: bit0 = green, bit1 = yellow, bit2 = red
+  */
+static void Lamps_WriteHal(uint8_t state)
+{
+  GPIO_PinState green = (state & 1) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+  GPIO_PinState yellow = (state & 2) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+  GPIO_PinState red = (state & 4) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+  HAL_GPIO_WritePin(LD6_GPIO_Port,LD6_Pin, green);
+  HAL_GPIO_WritePin(LD7_GPIO_Port,LD7_Pin, green);
+
+  HAL_GPIO_WritePin(LD5_GPIO_Port,LD5_Pin, yellow);
+  HAL_GPIO_WritePin(LD8_GPIO_Port,LD8_Pin, yellow);
+
+  HAL_GPIO_WritePin(LD3_GPIO_Port,LD3_Pin, red);
+  HAL_GPIO_WritePin(LD10_GPIO_Port,LD10_Pin, red);
+}
+
+/**
+  * @brief  Measure both output paths with the DWT cycle counter over every
+  *         state transition. Interrupts are masked during each measurement.
+  * @param  result: min/max cycles per call of each path
+  */
+void Lamps_Benchmark(LAMPS_BenchTypeDef *result)
+{
+  uint32_t from, to, start, cycles;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  result->HalCyclesMin = UINT32_MAX;
+  result->HalCyclesMax = 0U;
+  result->TableCyclesMin = UINT32_MAX;
+  result->TableCyclesMax = 0U;
+
+  for (from = 0U; from <= LAMPS_STATE_MASK; from++)
+  {
+    for (to = 0U; to <= LAMPS_STATE_MASK; to++)
+    {
+      __disable_irq();
+      Lamps_WriteHal((uint8_t)from);
+      start = DWT->CYCCNT;
+      Lamps_WriteHal((uint8_t)to);
+      cycles = DWT->CYCCNT - start;
+      __enable_irq();
+      if (cycles < result->HalCyclesMin)
+      {
+        result->HalCyclesMin = cycles;
+      }
+      if (cycles > result->HalCyclesMax)
+      {
+        result->HalCyclesMax = cycles;
+      }
+
+      __disable_irq();
+      Lamps_WriteBoard((uint8_t)from);
+      start = DWT->CYCCNT;
+      Lamps_WriteBoard((uint8_t)to);
+      cycles = DWT->CYCCNT - start;
+      __enable_irq();
+      if (cycles < result->TableCyclesMin)
+      {
+        result->TableCyclesMin = cycles;
+      }
+      if (cycles > result->TableCyclesMax)
+      {
+        result->TableCyclesMax = cycles;
+      }
+    }
+  }
+  Lamps_WriteBoard(0U);
+}
+#endif /* LAMPS_BENCHMARK */
@@ -22,6 +22,12 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "usb_device.h"
+#include "uart_cmd.h"
+#include "app_events.h"
+#include "lamps.h"
+#include "lamp_seq.h"
+#include "lamp_fade.h"
+#include "app_loop.h"
 
 /* USER CODE END Includes */
 
@@ -42,6 +48,7 @@
 
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_rx;
 
 PCD_HandleTypeDef hpcd_USB_FS;
 
@@ -52,6 +59,7 @@ PCD_HandleTypeDef hpcd_USB_FS;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART1_UART_Init(void);
 static void MX_USB_PCD_Init(void);
 /* USER CODE BEGIN PFP */
@@ -60,7 +68,10 @@ static void MX_USB_PCD_Init(void);
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-uint8_t led_state = 0;
+#ifdef LAMPS_BENCHMARK
+/* Inspect with the debugger after start-up */
+LAMPS_BenchTypeDef lamps_bench;
+#endif /* LAMPS_BENCHMARK */
 /* USER CODE END 0 */
 
 /**
@@ -92,10 +103,19 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART1_UART_Init();
   MX_USB_PCD_Init();
   /* USER CODE BEGIN 2 */
+#ifdef LAMPS_BENCHMARK
+  Lamps_Benchmark(&lamps_bench);
+#endif /* LAMPS_BENCHMARK */
+  APP_EVT_Init();
+  LAMP_SEQ_Init();
   MX_USB_DEVICE_Init();
+  UART_CMD_Start(&huart1);
+  LAMP_FADE_Init();
+  APP_LOOP_Init();
 
   /* USER CODE END 2 */
 
@@ -103,25 +123,9 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-    unsigned char uart_cmd = 0;
-    if (HAL_UART_Receive(&huart1, &uart_cmd, 1, 1) == HAL_OK)
-    {
-       led_state = uart_cmd & 7;
-    }
-    GPIO_PinState green = (led_state & 1) ? GPIO_PIN_SET : GPIO_PIN_RESET;
-    GPIO_PinState yellow = (led_state & 2) ? GPIO_PIN_SET : GPIO_PIN_RESET;
-    GPIO_PinState red = (led_state & 4) ? GPIO_PIN_SET : GPIO_PIN_RESET;
-    HAL_GPIO_WritePin(LD6_GPIO_Port,LD6_Pin, green);
-    HAL_GPIO_WritePin(LD7_GPIO_Port,LD7_Pin, green);
-    HAL_GPIO_WritePin(EXT_TRAFFIC_GR_GPIO_Port,EXT_TRAFFIC_GR_Pin, green);
-
-    HAL_GPIO_WritePin(LD5_GPIO_Port,LD5_Pin, yellow);
-    HAL_GPIO_WritePin(LD8_GPIO_Port,LD8_Pin, yellow);
-    HAL_GPIO_WritePin(EXT_TRAFFIC_YL_GPIO_Port,EXT_TRAFFIC_YL_Pin, yellow);
-
-    HAL_GPIO_WritePin(LD3_GPIO_Port,LD3_Pin, red);
-    HAL_GPIO_WritePin(LD10_GPIO_Port,LD10_Pin, red);
-    HAL_GPIO_WritePin(EXT_TRAFFIC_RED_GPIO_Port,EXT_TRAFFIC_RED_Pin, red);
+    APP_LOOP_Process();
+
+    APP_EVT_WaitForEvent();
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
@@ -242,6 +246,22 @@ static void MX_USB_PCD_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Channel5_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
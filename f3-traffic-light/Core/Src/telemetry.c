@@ -0,0 +1,97 @@
+/**
+  ******************************************************************************
+  * @file           : telemetry.c
+  * @brief          : Device state report sent on the WinUSB IN endpoint.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "telemetry.h"
+#include "app_events.h"
+#include "uart_cmd.h"
+#include "usbd_winusb_if.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Fields compared to detect a change worth reporting */
+#define TELEMETRY_STATE_SIZE        12U
+#define TELEMETRY_HIST_OFFSET       12U
+#define TELEMETRY_UPTIME_OFFSET     28U
+
+/* Private variables ---------------------------------------------------------*/
+/* Two reports: the USB stack owns the one in flight while the next is built */
+static uint8_t telemetry_report[2][TELEMETRY_REPORT_SIZE];
+static uint8_t telemetry_idx;
+static uint8_t telemetry_sent_state[TELEMETRY_STATE_SIZE];
+static uint8_t telemetry_seq;
+static uint32_t telemetry_last_tick;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Store a 32-bit value little endian.
+  */
+static void TELEMETRY_Put32(uint8_t *dst, uint32_t value)
+{
+  dst[0] = (uint8_t)value;
+  dst[1] = (uint8_t)(value >> 8);
+  dst[2] = (uint8_t)(value >> 16);
+  dst[3] = (uint8_t)(value >> 24);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Send a report if something changed or the heartbeat is due.
+  *         Main loop only; cheap enough to call on every iteration.
+  * @param  now: current time in ms (HAL_GetTick)
+  * @param  led_state: lamp state currently applied
+  * @param  commands: number of commands applied so far
+  */
+void TELEMETRY_Poll(uint32_t now, uint8_t led_state, uint32_t commands)
+{
+  uint8_t state[TELEMETRY_STATE_SIZE];
+  const APP_EVT_StatsTypeDef *stats;
+  uint32_t elapsed = now - telemetry_last_tick;
+  uint8_t *report = telemetry_report[telemetry_idx];
+  uint32_t i, count;
+
+  if (elapsed < TELEMETRY_MIN_INTERVAL_MS)
+  {
+    return;
+  }
+
+  stats = APP_EVT_GetStats();
+  state[0] = TELEMETRY_VERSION;
+  state[1] = led_state;
+  state[2] = (HAL_GPIO_ReadPin(B1_GPIO_Port, B1_Pin) == GPIO_PIN_SET) ? 1U : 0U;
+  state[3] = 0U;
+  TELEMETRY_Put32(&state[4], commands);
+  TELEMETRY_Put32(&state[8], stats->Dropped + UART_CMD_GetOverruns());
+
+  if ((elapsed < TELEMETRY_HEARTBEAT_MS) &&
+      (memcmp(state, telemetry_sent_state, TELEMETRY_STATE_SIZE) == 0))
+  {
+    return;
+  }
+
+  memcpy(report, state, TELEMETRY_STATE_SIZE);
+  report[3] = telemetry_seq;
+  for (i = 0U; i < APP_EVT_LATENCY_BUCKETS; i++)
+  {
+    count = (stats->LatencyHist[i] > 0xFFFFU) ? 0xFFFFU : stats->LatencyHist[i];
+    report[TELEMETRY_HIST_OFFSET + 2U * i] = (uint8_t)count;
+    report[TELEMETRY_HIST_OFFSET + 2U * i + 1U] = (uint8_t)(count >> 8);
+  }
+  TELEMETRY_Put32(&report[TELEMETRY_UPTIME_OFFSET], now);
+
+  if (USBD_WINUSB_SendReport_FS(report, TELEMETRY_REPORT_SIZE) == USBD_OK)
+  {
+    memcpy(telemetry_sent_state, state, TELEMETRY_STATE_SIZE);
+    telemetry_seq++;
+    telemetry_idx ^= 1U;
+  }
+  /* Not configured or previous report still pending: the change stays
+     pending and is retried after the minimum interval */
+  telemetry_last_tick = now;
+}
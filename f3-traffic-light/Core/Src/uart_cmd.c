@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * @file           : uart_cmd.c
+  * @brief          : DMA driven USART command receiver.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "uart_cmd.h"
+#include "ring_buffer.h"
+#include "app_events.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t uart_dma_buf[UART_CMD_DMA_BUF_SIZE];
+static uint8_t uart_ring_buf[UART_CMD_RING_SIZE];
+static RING_HandleTypeDef uart_ring;
+static UART_HandleTypeDef *uart_handle;
+
+/* Position in uart_dma_buf up to which data was already moved to the ring */
+static uint16_t uart_dma_pos;
+/* Bytes lost because the main loop did not drain the ring in time */
+static volatile uint32_t uart_overruns;
+/* Set while an APP_EVT_UART_RX event is queued and not yet fully drained */
+static volatile uint8_t uart_rx_posted;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Move a chunk of the DMA area into the command ring.
+  * @param  from: first byte offset in uart_dma_buf
+  * @param  to: offset one past the last byte
+  */
+static void UART_CMD_Push(uint16_t from, uint16_t to)
+{
+  uint32_t len = (uint32_t)to - from;
+
+  if (len != 0U)
+  {
+    uart_overruns += len - RING_Write(&uart_ring, &uart_dma_buf[from], len);
+  }
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Start circular DMA reception with idle-line detection.
+  * @param  huart: UART handle, its RX DMA channel must be in circular mode
+  */
+void UART_CMD_Start(UART_HandleTypeDef *huart)
+{
+  uart_handle = huart;
+  uart_dma_pos = 0U;
+  RING_Init(&uart_ring, uart_ring_buf, UART_CMD_RING_SIZE);
+
+  if (HAL_UARTEx_ReceiveToIdle_DMA(huart, uart_dma_buf, UART_CMD_DMA_BUF_SIZE) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
+/**
+  * @brief  Fetch the next received command byte.
+  * @param  byte: destination
+  * @retval 1 if a byte was available, 0 otherwise
+  */
+uint8_t UART_CMD_GetByte(uint8_t *byte)
+{
+  if (RING_Get(&uart_ring, byte))
+  {
+    return 1U;
+  }
+
+  /* Ring drained: let the next reception post a new event. Look again after
+     clearing the flag in case bytes arrived in between. */
+  uart_rx_posted = 0U;
+  __DMB();
+  if (RING_Get(&uart_ring, byte))
+  {
+    uart_rx_posted = 1U;
+    return 1U;
+  }
+  return 0U;
+}
+
+/**
+  * @brief  Post the event the reception interrupt could not queue. Main loop
+  *         only, after draining the event queue: bytes left in the ring by a
+  *         refused post would otherwise wait for the next received byte.
+  */
+void UART_CMD_Poll(void)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if ((uart_rx_posted == 0U) && (RING_Count(&uart_ring) != 0U))
+  {
+    uart_rx_posted = APP_EVT_Post(APP_EVT_UART_RX, 0U);
+  }
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Number of bytes dropped because the ring was full.
+  */
+uint32_t UART_CMD_GetOverruns(void)
+{
+  return uart_overruns;
+}
+
+/**
+  * @brief  Reception event: called by HAL on half-transfer, transfer complete
+  *         and idle line. In circular mode Size is the current write position
+  *         of the DMA inside uart_dma_buf.
+  * @param  huart: UART handle
+  * @param  Size: DMA write position
+  */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  if (huart != uart_handle)
+  {
+    return;
+  }
+
+  if (Size >= uart_dma_pos)
+  {
+    UART_CMD_Push(uart_dma_pos, Size);
+  }
+  else
+  {
+    /* DMA wrapped around since the last event */
+    UART_CMD_Push(uart_dma_pos, UART_CMD_DMA_BUF_SIZE);
+    UART_CMD_Push(0U, Size);
+  }
+  uart_dma_pos = (Size == UART_CMD_DMA_BUF_SIZE) ? 0U : Size;
+
+  if ((RING_Count(&uart_ring) != 0U) && (uart_rx_posted == 0U))
+  {
+    uart_rx_posted = APP_EVT_Post(APP_EVT_UART_RX, 0U);
+  }
+}
+
+/**
+  * @brief  Reception error. Blocking errors (overrun) make HAL abort the DMA
+  *         transfer, so restart it from the beginning of the buffer; noise
+  *         and framing errors leave the reception running.
+  * @param  huart: UART handle
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  if ((huart != uart_handle) || (huart->RxState != HAL_UART_STATE_READY))
+  {
+    return;
+  }
+
+  uart_dma_pos = 0U;
+  (void)HAL_UARTEx_ReceiveToIdle_DMA(huart, uart_dma_buf, UART_CMD_DMA_BUF_SIZE);
+}
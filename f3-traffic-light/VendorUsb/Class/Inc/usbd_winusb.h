@@ -42,12 +42,23 @@ extern "C" {
   * @{
   */
 #define WINUSB_EPIN_ADDR                 0x81U
-#define WINUSB_EPIN_SIZE                 0x02U
+#define WINUSB_EPIN_SIZE                 0x20U
 
 #define WINUSB_EPOUT_ADDR                0x01U
-#define WINUSB_EPOUT_SIZE                0x02U
+#define WINUSB_EPOUT_SIZE                0x04U
 
-#define USB_WINUSB_CONFIG_DESC_SIZ       32U
+/* Alternate setting 1: bulk endpoints for framed command streaming */
+#define WINUSB_BULK_EPIN_ADDR            0x82U
+#define WINUSB_BULK_EPOUT_ADDR           0x02U
+#define WINUSB_BULK_EP_SIZE              0x40U
+
+/* Receive slots of the bulk OUT endpoint, power of two */
+#define WINUSB_RX_SLOT_NBR               4U
+
+#define WINUSB_ALT_INTERRUPT             0x00U
+#define WINUSB_ALT_STREAM                0x01U
+
+#define USB_WINUSB_CONFIG_DESC_SIZ       55U
 #define USB_WINUSB_DESC_SIZ              9U
 
 #ifndef WINUSB_HS_BINTERVAL
@@ -59,8 +70,12 @@ extern "C" {
 #endif /* WINUSB_FS_BINTERVAL */
 
 #ifndef USBD_WINUSB_OUTREPORT_BUF_SIZE
-#define USBD_WINUSB_OUTREPORT_BUF_SIZE  0x02U
+#define USBD_WINUSB_OUTREPORT_BUF_SIZE  0x04U
 #endif /* USBD_WINUSB_OUTREPORT_BUF_SIZE */
+/* Largest packed lamp sequence accepted by WINUSB_REQ_SET_SEQUENCE */
+#ifndef USBD_WINUSB_SEQUENCE_BUF_SIZE
+#define USBD_WINUSB_SEQUENCE_BUF_SIZE  132U
+#endif /* USBD_WINUSB_SEQUENCE_BUF_SIZE */
 #ifndef USBD_WINUSB_REPORT_DESC_SIZE
 #define USBD_WINUSB_REPORT_DESC_SIZE   163U
 #endif /* USBD_WINUSB_REPORT_DESC_SIZE */
@@ -78,6 +93,9 @@ extern "C" {
 #define WINUSB_REQ_GET_REPORT            0x01U
 
 #define WEBUSB_REQ_GET_URL_INDEX   0x02u    /* wIndex value for WebUSB GET_URL request */
+
+/* Vendor OUT request carrying a packed lamp sequence in its data stage */
+#define WINUSB_REQ_SET_SEQUENCE          0x30U
   /**
   * @}
   */
@@ -98,17 +116,29 @@ typedef struct _USBD_WINUSB_Itf
   uint8_t                  *pReport;
   int8_t (* Init)(void);
   int8_t (* DeInit)(void);
-  int8_t (* OutEvent)(uint8_t event_idx, uint8_t state);
+  int8_t (* OutEvent)(uint8_t *report, uint32_t len);
+  int8_t (* SequenceEvent)(uint8_t *buf, uint32_t len);
 
 } USBD_WINUSB_ItfTypeDef;
 
 typedef struct
 {
   uint8_t              Report_buf[USBD_WINUSB_OUTREPORT_BUF_SIZE];
+  uint32_t             ReportLen;
+  uint8_t              Sequence_buf[USBD_WINUSB_SEQUENCE_BUF_SIZE];
+  uint32_t             SequenceLen;
+  /* Bulk OUT packets land in the slot at RxHead; slots from RxTail up to
+     RxHead belong to the application until released */
+  uint8_t              Rx_buf[WINUSB_RX_SLOT_NBR][WINUSB_BULK_EP_SIZE];
+  uint32_t             Rx_len[WINUSB_RX_SLOT_NBR];
+  volatile uint32_t    RxHead;
+  volatile uint32_t    RxTail;
+  volatile uint32_t    RxArmed;
   uint32_t             Protocol;
   uint32_t             IdleState;
   uint32_t             AltSetting;
   uint32_t             IsReportAvailable;
+  uint32_t             IsSequenceAvailable;
   WINUSB_StateTypeDef     state;
 }
 USBD_WINUSB_HandleTypeDef;
@@ -148,6 +178,10 @@ uint8_t USBD_WINUSB_SendReport(USBD_HandleTypeDef *pdev,
 uint8_t  USBD_WINUSB_RegisterInterface(USBD_HandleTypeDef   *pdev,
                                            USBD_WINUSB_ItfTypeDef *fops);
 
+uint8_t USBD_WINUSB_RxAcquire(USBD_HandleTypeDef *pdev, uint8_t **buf,
+                              uint32_t *len);
+void USBD_WINUSB_RxRelease(USBD_HandleTypeDef *pdev);
+
 /**
   * @}
   */
@@ -148,6 +148,9 @@ static uint8_t  USBD_WINUSB_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
 
 static uint8_t  USBD_WINUSB_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
 static uint8_t  USBD_WINUSB_EP0_RxReady(USBD_HandleTypeDef  *pdev);
+
+static void USBD_WINUSB_OpenAlt(USBD_HandleTypeDef *pdev, uint8_t alt);
+static void USBD_WINUSB_CloseAlt(USBD_HandleTypeDef *pdev, uint8_t alt);
 /**
   * @}
   */
@@ -207,7 +210,7 @@ __ALIGN_BEGIN static uint8_t USBD_WINUSB_CfgFSDesc[USB_WINUSB_CONFIG_DESC_SIZ] _
 
   WINUSB_EPIN_ADDR,     /*bEndpointAddress: Endpoint Address (IN)*/
   0x03,          /*bmAttributes: Interrupt endpoint*/
-  WINUSB_EPIN_SIZE, /*wMaxPacketSize: 2 Byte max */
+  WINUSB_EPIN_SIZE, /*wMaxPacketSize: telemetry report */
   0x00,
   WINUSB_FS_BINTERVAL,          /*bInterval: Polling Interval */
   /* 25 */
@@ -216,10 +219,37 @@ __ALIGN_BEGIN static uint8_t USBD_WINUSB_CfgFSDesc[USB_WINUSB_CONFIG_DESC_SIZ] _
   USB_DESC_TYPE_ENDPOINT, /* bDescriptorType: */
   WINUSB_EPOUT_ADDR,  /*bEndpointAddress: Endpoint Address (OUT)*/
   0x03, /* bmAttributes: Interrupt endpoint */
-  WINUSB_EPOUT_SIZE,  /* wMaxPacketSize: 2 Bytes max  */
+  WINUSB_EPOUT_SIZE,  /* wMaxPacketSize: 4 Bytes max  */
   0x00,
   WINUSB_FS_BINTERVAL,  /* bInterval: Polling Interval */
+  /************** Alternate setting 1: bulk streaming ****************/
   /* 32 */
+  0x09,         /*bLength: Interface Descriptor size*/
+  USB_DESC_TYPE_INTERFACE,/*bDescriptorType: Interface descriptor type*/
+  0x00,         /*bInterfaceNumber: Number of Interface*/
+  WINUSB_ALT_STREAM, /*bAlternateSetting: Alternate setting*/
+  0x02,         /*bNumEndpoints*/
+  0xFF,         /*bInterfaceClass: Vendor Specific */
+  0xFF,         /*bInterfaceSubClass */
+  0x00,         /*nInterfaceProtocol */
+  0,            /*iInterface: Index of string descriptor*/
+  /* 41 */
+  0x07,          /*bLength: Endpoint Descriptor size*/
+  USB_DESC_TYPE_ENDPOINT, /*bDescriptorType:*/
+  WINUSB_BULK_EPIN_ADDR, /*bEndpointAddress: Endpoint Address (IN)*/
+  0x02,          /*bmAttributes: Bulk endpoint*/
+  LOBYTE(WINUSB_BULK_EP_SIZE), /*wMaxPacketSize*/
+  HIBYTE(WINUSB_BULK_EP_SIZE),
+  0x00,          /*bInterval: ignored for Bulk transfer*/
+  /* 48 */
+  0x07,          /*bLength: Endpoint Descriptor size*/
+  USB_DESC_TYPE_ENDPOINT, /*bDescriptorType:*/
+  WINUSB_BULK_EPOUT_ADDR, /*bEndpointAddress: Endpoint Address (OUT)*/
+  0x02,          /*bmAttributes: Bulk endpoint*/
+  LOBYTE(WINUSB_BULK_EP_SIZE), /*wMaxPacketSize*/
+  HIBYTE(WINUSB_BULK_EP_SIZE),
+  0x00,          /*bInterval: ignored for Bulk transfer*/
+  /* 55 */
 };
 
 /* USB WINUSB device HS Configuration Descriptor */
@@ -255,7 +285,7 @@ __ALIGN_BEGIN static uint8_t USBD_WINUSB_CfgHSDesc[USB_WINUSB_CONFIG_DESC_SIZ] _
 
   WINUSB_EPIN_ADDR,     /*bEndpointAddress: Endpoint Address (IN)*/
   0x03,          /*bmAttributes: Interrupt endpoint*/
-  WINUSB_EPIN_SIZE, /*wMaxPacketSize: 2 Byte max */
+  WINUSB_EPIN_SIZE, /*wMaxPacketSize: telemetry report */
   0x00,
   WINUSB_HS_BINTERVAL,          /*bInterval: Polling Interval */
   /* 25 */
@@ -264,10 +294,37 @@ __ALIGN_BEGIN static uint8_t USBD_WINUSB_CfgHSDesc[USB_WINUSB_CONFIG_DESC_SIZ] _
   USB_DESC_TYPE_ENDPOINT, /* bDescriptorType: */
   WINUSB_EPOUT_ADDR,  /*bEndpointAddress: Endpoint Address (OUT)*/
   0x03, /* bmAttributes: Interrupt endpoint */
-  WINUSB_EPOUT_SIZE,  /* wMaxPacketSize: 2 Bytes max  */
+  WINUSB_EPOUT_SIZE,  /* wMaxPacketSize: 4 Bytes max  */
   0x00,
   WINUSB_HS_BINTERVAL,  /* bInterval: Polling Interval */
+  /************** Alternate setting 1: bulk streaming ****************/
   /* 32 */
+  0x09,         /*bLength: Interface Descriptor size*/
+  USB_DESC_TYPE_INTERFACE,/*bDescriptorType: Interface descriptor type*/
+  0x00,         /*bInterfaceNumber: Number of Interface*/
+  WINUSB_ALT_STREAM, /*bAlternateSetting: Alternate setting*/
+  0x02,         /*bNumEndpoints*/
+  0xFF,         /*bInterfaceClass: Vendor Specific */
+  0xFF,         /*bInterfaceSubClass */
+  0x00,         /*nInterfaceProtocol */
+  0,            /*iInterface: Index of string descriptor*/
+  /* 41 */
+  0x07,          /*bLength: Endpoint Descriptor size*/
+  USB_DESC_TYPE_ENDPOINT, /*bDescriptorType:*/
+  WINUSB_BULK_EPIN_ADDR, /*bEndpointAddress: Endpoint Address (IN)*/
+  0x02,          /*bmAttributes: Bulk endpoint*/
+  LOBYTE(WINUSB_BULK_EP_SIZE), /*wMaxPacketSize*/
+  HIBYTE(WINUSB_BULK_EP_SIZE),
+  0x00,          /*bInterval: ignored for Bulk transfer*/
+  /* 48 */
+  0x07,          /*bLength: Endpoint Descriptor size*/
+  USB_DESC_TYPE_ENDPOINT, /*bDescriptorType:*/
+  WINUSB_BULK_EPOUT_ADDR, /*bEndpointAddress: Endpoint Address (OUT)*/
+  0x02,          /*bmAttributes: Bulk endpoint*/
+  LOBYTE(WINUSB_BULK_EP_SIZE), /*wMaxPacketSize*/
+  HIBYTE(WINUSB_BULK_EP_SIZE),
+  0x00,          /*bInterval: ignored for Bulk transfer*/
+  /* 55 */
 };
 
 /* USB WINUSB device Other Speed Configuration Descriptor */
@@ -303,7 +360,7 @@ __ALIGN_BEGIN static uint8_t USBD_WINUSB_OtherSpeedCfgDesc[USB_WINUSB_CONFIG_DES
 
   WINUSB_EPIN_ADDR,     /*bEndpointAddress: Endpoint Address (IN)*/
   0x03,          /*bmAttributes: Interrupt endpoint*/
-  WINUSB_EPIN_SIZE, /*wMaxPacketSize: 2 Byte max */
+  WINUSB_EPIN_SIZE, /*wMaxPacketSize: telemetry report */
   0x00,
   WINUSB_FS_BINTERVAL,          /*bInterval: Polling Interval */
   /* 25 */
@@ -312,10 +369,37 @@ __ALIGN_BEGIN static uint8_t USBD_WINUSB_OtherSpeedCfgDesc[USB_WINUSB_CONFIG_DES
   USB_DESC_TYPE_ENDPOINT, /* bDescriptorType: */
   WINUSB_EPOUT_ADDR,  /*bEndpointAddress: Endpoint Address (OUT)*/
   0x03, /* bmAttributes: Interrupt endpoint */
-  WINUSB_EPOUT_SIZE,  /* wMaxPacketSize: 2 Bytes max  */
+  WINUSB_EPOUT_SIZE,  /* wMaxPacketSize: 4 Bytes max  */
   0x00,
   WINUSB_FS_BINTERVAL,  /* bInterval: Polling Interval */
+  /************** Alternate setting 1: bulk streaming ****************/
   /* 32 */
+  0x09,         /*bLength: Interface Descriptor size*/
+  USB_DESC_TYPE_INTERFACE,/*bDescriptorType: Interface descriptor type*/
+  0x00,         /*bInterfaceNumber: Number of Interface*/
+  WINUSB_ALT_STREAM, /*bAlternateSetting: Alternate setting*/
+  0x02,         /*bNumEndpoints*/
+  0xFF,         /*bInterfaceClass: Vendor Specific */
+  0xFF,         /*bInterfaceSubClass */
+  0x00,         /*nInterfaceProtocol */
+  0,            /*iInterface: Index of string descriptor*/
+  /* 41 */
+  0x07,          /*bLength: Endpoint Descriptor size*/
+  USB_DESC_TYPE_ENDPOINT, /*bDescriptorType:*/
+  WINUSB_BULK_EPIN_ADDR, /*bEndpointAddress: Endpoint Address (IN)*/
+  0x02,          /*bmAttributes: Bulk endpoint*/
+  LOBYTE(WINUSB_BULK_EP_SIZE), /*wMaxPacketSize*/
+  HIBYTE(WINUSB_BULK_EP_SIZE),
+  0x00,          /*bInterval: ignored for Bulk transfer*/
+  /* 48 */
+  0x07,          /*bLength: Endpoint Descriptor size*/
+  USB_DESC_TYPE_ENDPOINT, /*bDescriptorType:*/
+  WINUSB_BULK_EPOUT_ADDR, /*bEndpointAddress: Endpoint Address (OUT)*/
+  0x02,          /*bmAttributes: Bulk endpoint*/
+  LOBYTE(WINUSB_BULK_EP_SIZE), /*wMaxPacketSize*/
+  HIBYTE(WINUSB_BULK_EP_SIZE),
+  0x00,          /*bInterval: ignored for Bulk transfer*/
+  /* 55 */
 };
 
 /* USB WINUSB device Configuration Descriptor */
@@ -369,18 +453,6 @@ static uint8_t  USBD_WINUSB_Init(USBD_HandleTypeDef *pdev,
   uint8_t ret = 0U;
   USBD_WINUSB_HandleTypeDef     *hhid;
 
-  /* Open EP IN */
-  USBD_LL_OpenEP(pdev, WINUSB_EPIN_ADDR, USBD_EP_TYPE_INTR,
-                 WINUSB_EPIN_SIZE);
-
-  pdev->ep_in[WINUSB_EPIN_ADDR & 0xFU].is_used = 1U;
-
-  /* Open EP OUT */
-  USBD_LL_OpenEP(pdev, WINUSB_EPOUT_ADDR, USBD_EP_TYPE_INTR,
-                 WINUSB_EPOUT_SIZE);
-
-  pdev->ep_out[WINUSB_EPOUT_ADDR & 0xFU].is_used = 1U;
-
   pdev->pClassData = USBD_malloc(sizeof(USBD_WINUSB_HandleTypeDef));
 
   if (pdev->pClassData == NULL)
@@ -392,11 +464,12 @@ static uint8_t  USBD_WINUSB_Init(USBD_HandleTypeDef *pdev,
     hhid = (USBD_WINUSB_HandleTypeDef *) pdev->pClassData;
 
     hhid->state = WINUSB_IDLE;
+    hhid->AltSetting = WINUSB_ALT_INTERRUPT;
+    hhid->IsSequenceAvailable = 0U;
     ((USBD_WINUSB_ItfTypeDef *)pdev->pUserData)->Init();
 
-    /* Prepare Out endpoint to receive 1st packet */
-    USBD_LL_PrepareReceive(pdev, WINUSB_EPOUT_ADDR, hhid->Report_buf,
-                           USBD_WINUSB_OUTREPORT_BUF_SIZE);
+    /* Open endpoints of the default setting and prepare the 1st reception */
+    USBD_WINUSB_OpenAlt(pdev, WINUSB_ALT_INTERRUPT);
   }
 
   return ret;
@@ -412,17 +485,10 @@ static uint8_t  USBD_WINUSB_Init(USBD_HandleTypeDef *pdev,
 static uint8_t  USBD_WINUSB_DeInit(USBD_HandleTypeDef *pdev,
                                        uint8_t cfgidx)
 {
-  /* Close WINUSB EP IN */
-  USBD_LL_CloseEP(pdev, WINUSB_EPIN_ADDR);
-  pdev->ep_in[WINUSB_EPIN_ADDR & 0xFU].is_used = 0U;
-
-  /* Close WINUSB EP OUT */
-  USBD_LL_CloseEP(pdev, WINUSB_EPOUT_ADDR);
-  pdev->ep_out[WINUSB_EPOUT_ADDR & 0xFU].is_used = 0U;
-
   /* FRee allocated memory */
   if (pdev->pClassData != NULL)
   {
+    USBD_WINUSB_CloseAlt(pdev, (uint8_t)((USBD_WINUSB_HandleTypeDef *)pdev->pClassData)->AltSetting);
     ((USBD_WINUSB_ItfTypeDef *)pdev->pUserData)->DeInit();
     USBD_free(pdev->pClassData);
     pdev->pClassData = NULL;
@@ -430,6 +496,71 @@ static uint8_t  USBD_WINUSB_DeInit(USBD_HandleTypeDef *pdev,
   return USBD_OK;
 }
 
+/**
+  * @brief  USBD_WINUSB_OpenAlt
+  *         Open the endpoints of an alternate setting and arm the OUT one
+  * @param  pdev: device instance
+  * @param  alt: alternate setting
+  * @retval None
+  */
+static void USBD_WINUSB_OpenAlt(USBD_HandleTypeDef *pdev, uint8_t alt)
+{
+  USBD_WINUSB_HandleTypeDef *hhid = (USBD_WINUSB_HandleTypeDef *)pdev->pClassData;
+
+  hhid->state = WINUSB_IDLE;
+
+  if (alt == WINUSB_ALT_STREAM)
+  {
+    USBD_LL_OpenEP(pdev, WINUSB_BULK_EPIN_ADDR, USBD_EP_TYPE_BULK,
+                   WINUSB_BULK_EP_SIZE);
+    pdev->ep_in[WINUSB_BULK_EPIN_ADDR & 0xFU].is_used = 1U;
+
+    USBD_LL_OpenEP(pdev, WINUSB_BULK_EPOUT_ADDR, USBD_EP_TYPE_BULK,
+                   WINUSB_BULK_EP_SIZE);
+    pdev->ep_out[WINUSB_BULK_EPOUT_ADDR & 0xFU].is_used = 1U;
+
+    hhid->RxHead = 0U;
+    hhid->RxTail = 0U;
+    hhid->RxArmed = 1U;
+    USBD_LL_PrepareReceive(pdev, WINUSB_BULK_EPOUT_ADDR, hhid->Rx_buf[0],
+                           WINUSB_BULK_EP_SIZE);
+  }
+  else
+  {
+    USBD_LL_OpenEP(pdev, WINUSB_EPIN_ADDR, USBD_EP_TYPE_INTR,
+                   WINUSB_EPIN_SIZE);
+    pdev->ep_in[WINUSB_EPIN_ADDR & 0xFU].is_used = 1U;
+
+    USBD_LL_OpenEP(pdev, WINUSB_EPOUT_ADDR, USBD_EP_TYPE_INTR,
+                   WINUSB_EPOUT_SIZE);
+    pdev->ep_out[WINUSB_EPOUT_ADDR & 0xFU].is_used = 1U;
+
+    USBD_LL_PrepareReceive(pdev, WINUSB_EPOUT_ADDR, hhid->Report_buf,
+                           USBD_WINUSB_OUTREPORT_BUF_SIZE);
+  }
+}
+
+/**
+  * @brief  USBD_WINUSB_CloseAlt
+  *         Close the endpoints of an alternate setting
+  * @param  pdev: device instance
+  * @param  alt: alternate setting
+  * @retval None
+  */
+static void USBD_WINUSB_CloseAlt(USBD_HandleTypeDef *pdev, uint8_t alt)
+{
+  uint8_t in_addr = (alt == WINUSB_ALT_STREAM) ? WINUSB_BULK_EPIN_ADDR : WINUSB_EPIN_ADDR;
+  uint8_t out_addr = (alt == WINUSB_ALT_STREAM) ? WINUSB_BULK_EPOUT_ADDR : WINUSB_EPOUT_ADDR;
+
+  /* Close WINUSB EP IN */
+  USBD_LL_CloseEP(pdev, in_addr);
+  pdev->ep_in[in_addr & 0xFU].is_used = 0U;
+
+  /* Close WINUSB EP OUT */
+  USBD_LL_CloseEP(pdev, out_addr);
+  pdev->ep_out[out_addr & 0xFU].is_used = 0U;
+}
+
 /**
   * @brief  USBD_WINUSB_Setup
   *         Handle the WINUSB specific requests
@@ -478,6 +609,17 @@ static uint8_t  USBD_WINUSB_Setup(USBD_HandleTypeDef *pdev,
         USBD_CtlSendData(pdev, (uint8_t*)MS_OS_20_DESCRIPTOR_SET, send_len);
         return USBD_OK;
       }
+      /* Receive a lamp sequence; it is handed over in EP0_RxReady */
+      if (req->bRequest == WINUSB_REQ_SET_SEQUENCE &&
+          (req->bmRequest & 0x80U) == 0U && /* Host-to-device */
+          req->wLength != 0U &&
+          req->wLength <= USBD_WINUSB_SEQUENCE_BUF_SIZE)
+      {
+        hhid->IsSequenceAvailable = 1U;
+        hhid->SequenceLen = req->wLength;
+        USBD_CtlPrepareRx(pdev, hhid->Sequence_buf, req->wLength);
+        return USBD_OK;
+      }
       USBD_CtlError(pdev, req);
       ret = USBD_FAIL;
       break;
@@ -502,7 +644,8 @@ static uint8_t  USBD_WINUSB_Setup(USBD_HandleTypeDef *pdev,
 
         case WINUSB_REQ_SET_REPORT:
           hhid->IsReportAvailable = 1U;
-          USBD_CtlPrepareRx(pdev, hhid->Report_buf, req->wLength);
+          hhid->ReportLen = MIN(req->wLength, USBD_WINUSB_OUTREPORT_BUF_SIZE);
+          USBD_CtlPrepareRx(pdev, hhid->Report_buf, hhid->ReportLen);
           break;
 
         default:
@@ -558,9 +701,15 @@ static uint8_t  USBD_WINUSB_Setup(USBD_HandleTypeDef *pdev,
           break;
 
         case USB_REQ_SET_INTERFACE :
-          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          if ((pdev->dev_state == USBD_STATE_CONFIGURED) &&
+              ((uint8_t)(req->wValue) <= WINUSB_ALT_STREAM))
           {
-            hhid->AltSetting = (uint8_t)(req->wValue);
+            if ((uint8_t)(req->wValue) != hhid->AltSetting)
+            {
+              USBD_WINUSB_CloseAlt(pdev, (uint8_t)hhid->AltSetting);
+              hhid->AltSetting = (uint8_t)(req->wValue);
+              USBD_WINUSB_OpenAlt(pdev, (uint8_t)hhid->AltSetting);
+            }
           }
           else
           {
@@ -602,7 +751,8 @@ uint8_t USBD_WINUSB_SendReport(USBD_HandleTypeDef  *pdev,
     if (hhid->state == WINUSB_IDLE)
     {
       hhid->state = WINUSB_BUSY;
-      USBD_LL_Transmit(pdev, WINUSB_EPIN_ADDR, report, len);
+      USBD_LL_Transmit(pdev, (hhid->AltSetting == WINUSB_ALT_STREAM) ?
+                       WINUSB_BULK_EPIN_ADDR : WINUSB_EPIN_ADDR, report, len);
     }
     else
     {
@@ -612,6 +762,68 @@ uint8_t USBD_WINUSB_SendReport(USBD_HandleTypeDef  *pdev,
   return USBD_OK;
 }
 
+/**
+  * @brief  USBD_WINUSB_RxAcquire
+  *         Get the oldest bulk OUT packet not yet released. The data stays
+  *         in the class receive slot and may be processed in place.
+  *         Single consumer, not to be called from the USB interrupt.
+  * @param  pdev: device instance
+  * @param  buf: receives the packet address
+  * @param  len: receives the packet length
+  * @retval 1 if a packet is available, 0 otherwise
+  */
+uint8_t USBD_WINUSB_RxAcquire(USBD_HandleTypeDef *pdev, uint8_t **buf,
+                              uint32_t *len)
+{
+  USBD_WINUSB_HandleTypeDef     *hhid = (USBD_WINUSB_HandleTypeDef *)pdev->pClassData;
+  uint32_t tail;
+
+  if ((hhid == NULL) || (hhid->AltSetting != WINUSB_ALT_STREAM))
+  {
+    return 0U;
+  }
+
+  tail = hhid->RxTail;
+  if (hhid->RxHead == tail)
+  {
+    return 0U;
+  }
+  __DMB();
+  *buf = hhid->Rx_buf[tail & (WINUSB_RX_SLOT_NBR - 1U)];
+  *len = hhid->Rx_len[tail & (WINUSB_RX_SLOT_NBR - 1U)];
+  return 1U;
+}
+
+/**
+  * @brief  USBD_WINUSB_RxRelease
+  *         Give the packet returned by USBD_WINUSB_RxAcquire back to the
+  *         class and resume reception if it was stopped for lack of slots.
+  * @param  pdev: device instance
+  * @retval None
+  */
+void USBD_WINUSB_RxRelease(USBD_HandleTypeDef *pdev)
+{
+  USBD_WINUSB_HandleTypeDef     *hhid = (USBD_WINUSB_HandleTypeDef *)pdev->pClassData;
+  uint32_t primask = __get_PRIMASK();
+
+  /* Keep the USB interrupt from switching settings or filling slots while
+     the ring is updated */
+  __disable_irq();
+  if ((hhid != NULL) && (hhid->AltSetting == WINUSB_ALT_STREAM) &&
+      (hhid->RxHead != hhid->RxTail))
+  {
+    hhid->RxTail++;
+    if (hhid->RxArmed == 0U)
+    {
+      hhid->RxArmed = 1U;
+      USBD_LL_PrepareReceive(pdev, WINUSB_BULK_EPOUT_ADDR,
+                             hhid->Rx_buf[hhid->RxHead & (WINUSB_RX_SLOT_NBR - 1U)],
+                             WINUSB_BULK_EP_SIZE);
+    }
+  }
+  __set_PRIMASK(primask);
+}
+
 /**
   * @brief  USBD_WINUSB_GetFSCfgDesc
   *         return FS configuration descriptor
@@ -680,13 +892,45 @@ static uint8_t  USBD_WINUSB_DataOut(USBD_HandleTypeDef *pdev,
 {
 
   USBD_WINUSB_HandleTypeDef     *hhid = (USBD_WINUSB_HandleTypeDef *)pdev->pClassData;
+  uint8_t report[USBD_WINUSB_OUTREPORT_BUF_SIZE];
+  uint32_t head;
+  uint32_t len, i;
+
+  /* The packet is already in its slot: publish it and arm the next free
+     slot. With all slots held by the application the endpoint NAKs until
+     USBD_WINUSB_RxRelease frees one. */
+  if (epnum == (WINUSB_BULK_EPOUT_ADDR & 0xFU))
+  {
+    head = hhid->RxHead;
+    hhid->Rx_len[head & (WINUSB_RX_SLOT_NBR - 1U)] = USBD_LL_GetRxDataSize(pdev, epnum);
+    head++;
+    hhid->RxHead = head;
 
-  ((USBD_WINUSB_ItfTypeDef *)pdev->pUserData)->OutEvent(hhid->Report_buf[0],
-                                                            hhid->Report_buf[1]);
+    if ((head - hhid->RxTail) < WINUSB_RX_SLOT_NBR)
+    {
+      USBD_LL_PrepareReceive(pdev, WINUSB_BULK_EPOUT_ADDR,
+                             hhid->Rx_buf[head & (WINUSB_RX_SLOT_NBR - 1U)],
+                             WINUSB_BULK_EP_SIZE);
+    }
+    else
+    {
+      hhid->RxArmed = 0U;
+    }
+    return USBD_OK;
+  }
 
+  /* Re-arm the endpoint before handing the data over, so the next packet is
+     accepted while the interface callback runs */
+  len = MIN(USBD_LL_GetRxDataSize(pdev, epnum), USBD_WINUSB_OUTREPORT_BUF_SIZE);
+  for (i = 0U; i < len; i++)
+  {
+    report[i] = hhid->Report_buf[i];
+  }
   USBD_LL_PrepareReceive(pdev, WINUSB_EPOUT_ADDR, hhid->Report_buf,
                          USBD_WINUSB_OUTREPORT_BUF_SIZE);
 
+  ((USBD_WINUSB_ItfTypeDef *)pdev->pUserData)->OutEvent(report, len);
+
   return USBD_OK;
 }
 
@@ -694,20 +938,30 @@ static uint8_t  USBD_WINUSB_DataOut(USBD_HandleTypeDef *pdev,
   * @brief  USBD_WINUSB_EP0_RxReady
   *         Handles control request data.
   * @param  pdev: device instance
-  * @retval status
+  * @retval status, USBD_FAIL makes the core stall the status stage
   */
 static uint8_t USBD_WINUSB_EP0_RxReady(USBD_HandleTypeDef *pdev)
 {
   USBD_WINUSB_HandleTypeDef     *hhid = (USBD_WINUSB_HandleTypeDef *)pdev->pClassData;
+  uint8_t ret = USBD_OK;
 
   if (hhid->IsReportAvailable == 1U)
   {
-    ((USBD_WINUSB_ItfTypeDef *)pdev->pUserData)->OutEvent(hhid->Report_buf[0],
-                                                              hhid->Report_buf[1]);
+    ((USBD_WINUSB_ItfTypeDef *)pdev->pUserData)->OutEvent(hhid->Report_buf,
+                                                              hhid->ReportLen);
     hhid->IsReportAvailable = 0U;
   }
+  if (hhid->IsSequenceAvailable == 1U)
+  {
+    if (((USBD_WINUSB_ItfTypeDef *)pdev->pUserData)->SequenceEvent(hhid->Sequence_buf,
+                                                                       hhid->SequenceLen) != USBD_OK)
+    {
+      ret = USBD_FAIL;
+    }
+    hhid->IsSequenceAvailable = 0U;
+  }
 
-  return USBD_OK;
+  return ret;
 }
 
 /**
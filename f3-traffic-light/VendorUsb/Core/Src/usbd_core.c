@@ -318,11 +318,16 @@ USBD_StatusTypeDef USBD_LL_DataOutStage(USBD_HandleTypeDef *pdev,
       else
       {
         if ((pdev->pClass->EP0_RxReady != NULL) &&
-            (pdev->dev_state == USBD_STATE_CONFIGURED))
+            (pdev->dev_state == USBD_STATE_CONFIGURED) &&
+            (pdev->pClass->EP0_RxReady(pdev) != (uint8_t)USBD_OK))
         {
-          pdev->pClass->EP0_RxReady(pdev);
+          /* Data refused by the class: stall the status stage */
+          USBD_CtlError(pdev, &pdev->request);
+        }
+        else
+        {
+          USBD_CtlSendStatus(pdev);
         }
-        USBD_CtlSendStatus(pdev);
       }
     }
     else
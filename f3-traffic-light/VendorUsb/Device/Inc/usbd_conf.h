@@ -72,7 +72,7 @@
 /*---------- -----------*/
 #define USBD_SELF_POWERED     1U
 /*---------- -----------*/
-#define USBD_WINUSB_OUTREPORT_BUF_SIZE     2U
+#define USBD_WINUSB_OUTREPORT_BUF_SIZE     4U
 /*---------- -----------*/
 #define USBD_WINUSB_REPORT_DESC_SIZE     27U
 /*---------- -----------*/
@@ -104,6 +104,9 @@ extern USBD_WINUSB_ItfTypeDef USBD_WinUSB_fops_FS;
   */
 
 /* USER CODE BEGIN EXPORTED_FUNCTIONS */
+int8_t USBD_WINUSB_SendReport_FS(uint8_t *report, uint16_t len);
+uint8_t USBD_WINUSB_RxAcquire_FS(uint8_t **buf, uint32_t *len);
+void USBD_WINUSB_RxRelease_FS(void);
 
 /* USER CODE END EXPORTED_FUNCTIONS */
 
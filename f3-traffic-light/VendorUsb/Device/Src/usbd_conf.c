@@ -42,7 +42,86 @@ extern PCD_HandleTypeDef hpcd_USB_FS;
 void Error_Handler(void);
 
 /* USER CODE BEGIN 0 */
+/* Packet memory of the USB peripheral (STM32F303xC) */
+#define USBD_PMA_SIZE           512U
+/* One buffer descriptor table entry per endpoint number */
+#define USBD_PMA_BTABLE_ENTRY   8U
 
+/**
+  * @brief  Size of an endpoint buffer in packet memory. Receive counters
+  *         count in 2-byte blocks up to 62 bytes and in 32-byte blocks above.
+  * @param  mps: endpoint max packet size
+  * @retval buffer size in bytes
+  */
+static uint16_t USBD_LL_PMABufSize(uint16_t mps)
+{
+  if (mps > 62U)
+  {
+    return (uint16_t)((mps + 31U) & ~31U);
+  }
+  return (uint16_t)((mps + 1U) & ~1U);
+}
+
+/**
+  * @brief  Lay out the packet memory from a configuration descriptor: the
+  *         buffer descriptor table sized for the highest endpoint number,
+  *         then EP0 and every endpoint of every alternate setting in
+  *         descriptor order. Bulk endpoints are double buffered so the
+  *         peripheral keeps accepting packets while the previous one is
+  *         being processed; interrupt endpoints stay single buffered, the
+  *         hardware only double buffers bulk and isochronous endpoints.
+  * @param  hpcd: PCD handle
+  * @param  pdesc: configuration descriptor
+  * @param  len: configuration descriptor length
+  * @retval HAL status, HAL_ERROR if the endpoints do not fit
+  */
+static HAL_StatusTypeDef USBD_LL_PMAConfigFromDesc(PCD_HandleTypeDef *hpcd,
+                                                   const uint8_t *pdesc, uint16_t len)
+{
+  uint32_t pos;
+  uint32_t ep_nbr = 1U;
+  uint32_t addr;
+  uint16_t size;
+  const uint8_t *ep;
+
+  for (pos = 0U; ((pos + 1U) < len) && (pdesc[pos] != 0U); pos += pdesc[pos])
+  {
+    if ((pdesc[pos + 1U] == USB_DESC_TYPE_ENDPOINT) &&
+        ((pdesc[pos + 2U] & EP_ADDR_MSK) >= ep_nbr))
+    {
+      ep_nbr = (pdesc[pos + 2U] & EP_ADDR_MSK) + 1U;
+    }
+  }
+
+  addr = BTABLE_ADDRESS + (ep_nbr * USBD_PMA_BTABLE_ENTRY);
+  HAL_PCDEx_PMAConfig(hpcd, 0x00U, PCD_SNG_BUF, addr);
+  addr += USB_MAX_EP0_SIZE;
+  HAL_PCDEx_PMAConfig(hpcd, 0x80U, PCD_SNG_BUF, addr);
+  addr += USB_MAX_EP0_SIZE;
+
+  for (pos = 0U; ((pos + 1U) < len) && (pdesc[pos] != 0U); pos += pdesc[pos])
+  {
+    if (pdesc[pos + 1U] != USB_DESC_TYPE_ENDPOINT)
+    {
+      continue;
+    }
+    ep = &pdesc[pos];
+    size = USBD_LL_PMABufSize((uint16_t)((ep[4] | (ep[5] << 8)) & 0x7FFU));
+
+    if ((ep[3] & 0x03U) == USBD_EP_TYPE_BULK)
+    {
+      HAL_PCDEx_PMAConfig(hpcd, ep[2], PCD_DBL_BUF, addr | ((addr + size) << 16));
+      addr += 2U * size;
+    }
+    else
+    {
+      HAL_PCDEx_PMAConfig(hpcd, ep[2], PCD_SNG_BUF, addr);
+      addr += size;
+    }
+  }
+
+  return (addr <= USBD_PMA_SIZE) ? HAL_OK : HAL_ERROR;
+}
 /* USER CODE END 0 */
 
 /* USER CODE BEGIN PFP */
@@ -292,12 +371,16 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
   HAL_PCD_RegisterIsoInIncpltCallback(&hpcd_USB_FS, PCD_ISOINIncompleteCallback);
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
   /* USER CODE BEGIN EndPoint_Configuration */
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x00 , PCD_SNG_BUF, 0x18);
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x80 , PCD_SNG_BUF, 0x58);
   /* USER CODE END EndPoint_Configuration */
   /* USER CODE BEGIN EndPoint_Configuration_WINUSB */
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , WINUSB_EPIN_ADDR , PCD_SNG_BUF, 0x98);
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , WINUSB_EPOUT_ADDR , PCD_SNG_BUF, 0xD8);
+  /* The class is registered after USBD_LL_Init, take its descriptor directly */
+  uint16_t cfg_len;
+  uint8_t *cfg_desc = USBD_WINUSB.GetFSConfigDescriptor(&cfg_len);
+
+  if (USBD_LL_PMAConfigFromDesc((PCD_HandleTypeDef*)pdev->pData, cfg_desc, cfg_len) != HAL_OK)
+  {
+    Error_Handler( );
+  }
   /* USER CODE END EndPoint_Configuration_WINUSB */
   return USBD_OK;
 }
@@ -22,6 +22,9 @@
 #include "../Inc/usbd_winusb_if.h"
 
 /* USER CODE BEGIN INCLUDE */
+#include "app_events.h"
+#include "lamp_stream.h"
+#include "lamp_seq.h"
 
 /* USER CODE END INCLUDE */
 
@@ -62,6 +65,9 @@
   */
 
 /* USER CODE BEGIN PRIVATE_DEFINES */
+#if USBD_WINUSB_SEQUENCE_BUF_SIZE < LAMP_SEQ_MAX_SIZE
+#error "USBD_WINUSB_SEQUENCE_BUF_SIZE cannot hold the longest lamp sequence"
+#endif
 
 /* USER CODE END PRIVATE_DEFINES */
 
@@ -91,17 +97,17 @@
 __ALIGN_BEGIN static uint8_t WINUSB_ReportDesc_FS[USBD_WINUSB_REPORT_DESC_SIZE] __ALIGN_END =
 {
   /* USER CODE BEGIN 0 */
-  // Minimal valid WinUSB descriptor with 2-byte IN and 2-byte OUT reports
+  // Minimal valid WinUSB descriptor: 32-byte IN (telemetry) and 4-byte OUT reports
   0x06, 0x00, 0xFF,       /* USAGE_PAGE (Vendor Defined 0xFF00) */
   0x09, 0x01,             /* USAGE (0x01) */
   0xA1, 0x01,             /* COLLECTION (Application) */
   0x15, 0x00,             /*   LOGICAL_MINIMUM (0) */
   0x26, 0xFF, 0x00,       /*   LOGICAL_MAXIMUM (255) */
   0x75, 0x08,             /*   REPORT_SIZE (8) */
-  0x95, 0x02,             /*   REPORT_COUNT (2 bytes) */
+  0x95, 0x20,             /*   REPORT_COUNT (32 bytes, TELEMETRY_REPORT_SIZE) */
   0x09, 0x01,             /*   USAGE (0x01) */
   0x81, 0x02,             /*   INPUT (Data,Var,Abs) */
-  0x95, 0x02,             /*   REPORT_COUNT (2 bytes) */
+  0x95, 0x04,             /*   REPORT_COUNT (4 bytes) */
   0x09, 0x01,             /*   USAGE (0x01) */
   0x91, 0x02,             /*   OUTPUT (Data,Var,Abs) */
   /* USER CODE END 0 */
@@ -123,7 +129,6 @@ __ALIGN_BEGIN static uint8_t WINUSB_ReportDesc_FS[USBD_WINUSB_REPORT_DESC_SIZE]
 extern USBD_HandleTypeDef hUsbDeviceFS;
 
 /* USER CODE BEGIN EXPORTED_VARIABLES */
-extern  uint8_t led_state;
 
 /* USER CODE END EXPORTED_VARIABLES */
 /**
@@ -137,7 +142,8 @@ extern  uint8_t led_state;
 
 static int8_t WINUSB_Init_FS(void);
 static int8_t WINUSB_DeInit_FS(void);
-static int8_t WINUSB_OutEvent_FS(uint8_t event_idx, uint8_t state);
+static int8_t WINUSB_OutEvent_FS(uint8_t *report, uint32_t len);
+static int8_t WINUSB_SequenceEvent_FS(uint8_t *buf, uint32_t len);
 
 /**
   * @}
@@ -148,7 +154,8 @@ USBD_WINUSB_ItfTypeDef USBD_WinUSB_fops_FS =
   WINUSB_ReportDesc_FS,
   WINUSB_Init_FS,
   WINUSB_DeInit_FS,
-  WINUSB_OutEvent_FS
+  WINUSB_OutEvent_FS,
+  WINUSB_SequenceEvent_FS
 };
 
 /** @defgroup USBD_WINUSB_Private_Functions USBD_WINUSB_Private_Functions
@@ -165,6 +172,7 @@ USBD_WINUSB_ItfTypeDef USBD_WinUSB_fops_FS =
 static int8_t WINUSB_Init_FS(void)
 {
   /* USER CODE BEGIN 4 */
+  LAMP_STREAM_Reset();
   return (USBD_OK);
   /* USER CODE END 4 */
 }
@@ -182,33 +190,97 @@ static int8_t WINUSB_DeInit_FS(void)
 
 /**
   * @brief  Manage the WinUSB class events
-  * @param  event_idx: Event index
-  * @param  state: Event state
+  * @param  report: OUT report, valid only during the call
+  * @param  len: report length
   * @retval USBD_OK if all operations are OK else USBD_FAIL
   */
-static int8_t WINUSB_OutEvent_FS(uint8_t event_idx, uint8_t state)
+static int8_t WINUSB_OutEvent_FS(uint8_t *report, uint32_t len)
 {
   /* USER CODE BEGIN 6 */
-  USBD_WINUSB_HandleTypeDef *hhid = (USBD_WINUSB_HandleTypeDef*)hUsbDeviceFS.pClassData;
-  led_state = hhid->Report_buf[0] | hhid->Report_buf[1];
+  uint32_t value;
+
+  if (len == 0U)
+  {
+    return (USBD_FAIL);
+  }
+  /* Bytes 0 and 1 are OR-ed into the lamp state; 4-byte reports also carry
+     the brightness and the fade time */
+  value = report[0];
+  if (len >= 2U)
+  {
+    value |= report[1];
+  }
+  if (len >= 4U)
+  {
+    value |= APP_EVT_STATE_HAS_LEVEL | ((uint32_t)report[2] << 8) | ((uint32_t)report[3] << 16);
+  }
+  (void)APP_EVT_Post(APP_EVT_SET_STATE, value);
 
   return (USBD_OK);
   /* USER CODE END 6 */
 }
 
+/**
+  * @brief  Manage a lamp sequence received on the control endpoint
+  * @param  buf: packed sequence, valid only during the call
+  * @param  len: sequence length
+  * @retval USBD_OK if the sequence was taken, USBD_FAIL if it was rejected;
+  *         the host then sees the control transfer stall
+  */
+static int8_t WINUSB_SequenceEvent_FS(uint8_t *buf, uint32_t len)
+{
+  /* USER CODE BEGIN 8 */
+  if (!LAMP_SEQ_Submit(buf, len))
+  {
+    return (USBD_FAIL);
+  }
+  if (!APP_EVT_Post(APP_EVT_SEQ_LOAD, 0U))
+  {
+    /* Nobody would pick it up, and it would block the next upload */
+    LAMP_SEQ_DropUpload();
+    return (USBD_FAIL);
+  }
+
+  return (USBD_OK);
+  /* USER CODE END 8 */
+}
+
 /* USER CODE BEGIN 7 */
 /**
   * @brief  Send the report to the Host
-  * @param  report: The report to be sent
+  * @param  report: The report to be sent, must stay valid until sent
   * @param  len: The report length
-  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  * @retval USBD_OK if the transfer was started, USBD_BUSY if the previous
+  *         one is still pending, USBD_FAIL if the device is not configured
+  */
+int8_t USBD_WINUSB_SendReport_FS(uint8_t *report, uint16_t len)
+{
+  if (hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED)
+  {
+    return (USBD_FAIL);
+  }
+  return (int8_t)USBD_WINUSB_SendReport(&hUsbDeviceFS, report, len);
+}
+
+/**
+  * @brief  Get the oldest packet received on the bulk streaming endpoint.
+  *         It stays in the class buffer until USBD_WINUSB_RxRelease_FS.
+  * @param  buf: receives the packet address
+  * @param  len: receives the packet length
+  * @retval 1 if a packet is available, 0 otherwise
+  */
+uint8_t USBD_WINUSB_RxAcquire_FS(uint8_t **buf, uint32_t *len)
+{
+  return USBD_WINUSB_RxAcquire(&hUsbDeviceFS, buf, len);
+}
+
+/**
+  * @brief  Release the packet returned by USBD_WINUSB_RxAcquire_FS.
   */
-/*
-static int8_t USBD_WINUSB_SendReport_FS(uint8_t *report, uint16_t len)
+void USBD_WINUSB_RxRelease_FS(void)
 {
-  return USBD_WINUSB_SendReport(&hUsbDeviceFS, report, len);
+  USBD_WINUSB_RxRelease(&hUsbDeviceFS);
 }
-*/
 /* USER CODE END 7 */
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
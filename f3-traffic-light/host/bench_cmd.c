@@ -0,0 +1,867 @@
+/**
+  ******************************************************************************
+  * @file           : bench_cmd.c
+  * @brief          : Host simulation and benchmark of the command path.
+  ******************************************************************************
+  * The main loop (app_loop.c), the event queue, the UART command receiver,
+  * the lamp modules, the telemetry, the USB device core and the WinUSB class
+  * with its interface are compiled unchanged. This file plays the PCD
+  * driver, the USART DMA and the lamp PWM, and a simulated host that
+  * enumerates the device and then sends a random mix of commands:
+  *
+  *   - OUT reports of 1, 2 or 4 bytes on the interrupt endpoint 0x01
+  *   - SET_REPORT control transfers (SETUP, DATA OUT, status IN)
+  *   - SET_SEQUENCE control transfers, a few of them malformed
+  *   - UART bursts of 1 to 8 command bytes through the DMA events
+  *
+  * Every BENCH_ALT_BLOCK transactions the host switches the interface
+  * between alternate setting 0 and 1 (SET_INTERFACE). In the streaming
+  * setting, bursts of 1 to 3 lamp_stream frames on the bulk endpoint 0x02
+  * take the place of the interrupt OUT reports. Their steps are played out
+  * by advancing the tick, and every step must show up at the millisecond it
+  * is due, not one earlier. Some frames skip or repeat a sequence number;
+  * the stream counters must tell the gaps from the repeats.
+  *
+  * Every command is followed by one main loop pass, as after the interrupt
+  * on the target. The lamp state written to GPIOE and lamp_fade must then be
+  * the one the command asked for, malformed sequences must stall, and each
+  * telemetry report completed on 0x81, or 0x82 while streaming, must carry
+  * the current state and command count. The simulated millisecond tick
+  * advances by one per command.
+  *
+  * The benchmark result is the host time from the first interrupt side call
+  * to the end of the main loop pass: commands per second, and per command
+  * kind the mean and 99th percentile; stream frames count as commands and
+  * include their playback. Only the relative numbers mean anything for the
+  * target.
+  *
+  * Usage: bench_cmd [transactions]
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+#include "app_events.h"
+#include "app_loop.h"
+#include "uart_cmd.h"
+#include "lamps.h"
+#include "lamp_fade.h"
+#include "lamp_seq.h"
+#include "lamp_stream.h"
+#include "telemetry.h"
+#include "usb_device.h"
+#include "usbd_core.h"
+#include "usbd_winusb.h"
+
+/* Private define ------------------------------------------------------------*/
+#define BENCH_TRANSACTIONS  2000000U
+#define EP_NBR              8U
+#define EP0_SIZE            USB_MAX_EP0_SIZE
+#define UART_BURST_MAX      8U
+#define BENCH_ALT_BLOCK     4096U
+#define STREAM_FRAMES_MAX   3U
+#define STREAM_STEPS_MAX    8U
+#define STREAM_HOLD_MAX_MS  4U
+
+#define CHECK(cond)                                                            \
+  do                                                                           \
+  {                                                                            \
+    if (!(cond))                                                               \
+    {                                                                          \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);          \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef enum
+{
+  KIND_INT_OUT = 0U,
+  KIND_SET_REPORT,
+  KIND_SET_SEQUENCE,
+  KIND_UART,
+  KIND_STREAM,
+  KIND_NBR
+} Kind_t;
+
+typedef struct
+{
+  uint8_t  *buf;
+  uint32_t size;
+  uint32_t len;       /* OUT: bytes of the last packet */
+  uint8_t  pending;   /* IN: transfer started; OUT: reception armed */
+} SimEp_t;
+
+typedef struct
+{
+  uint32_t *ns;
+  uint32_t count;
+  uint32_t commands;
+  uint64_t total_ns;
+} KindStats_t;
+
+/* Private variables ---------------------------------------------------------*/
+uint32_t host_primask;
+DWT_Type host_dwt;
+CoreDebug_Type host_coredebug;
+TIM_TypeDef host_tim6;
+RCC_TypeDef host_rcc;
+GPIO_TypeDef host_gpio[6];
+uint32_t host_uid[3] = {0x00280041U, 0x3236470FU, 0x20363346U};
+uint32_t SystemCoreClock = 72000000U;
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+static uint32_t failures;
+static uint32_t sim_tick;
+
+/* Simulated PCD */
+static SimEp_t sim_in[EP_NBR];
+static SimEp_t sim_out[EP_NBR];
+static uint32_t usbd_class_mem[(sizeof(USBD_WINUSB_HandleTypeDef) / 4U) + 1U];
+
+/* Simulated USART1 DMA, as in test_uart_cmd.c */
+static UART_HandleTypeDef huart1;
+static uint8_t *dma_area;
+static uint16_t dma_size;
+static uint16_t dma_pos;
+
+/* lamp_fade stand-in */
+static uint8_t fade_state;
+static uint8_t fade_level;
+static uint8_t fade_time;
+
+/* What the device should show */
+static uint8_t expect_state;
+static uint32_t expect_commands;
+static uint32_t reports;
+
+/* Host side of the bulk stream */
+static uint8_t host_alt;
+static uint8_t stream_seq;
+static uint8_t stream_synced;
+static uint32_t stream_frames;
+static uint32_t stream_gaps;
+static uint32_t stream_reordered;
+
+static const char *const kind_name[KIND_NBR] =
+{
+  "int OUT", "SET_REPORT", "SET_SEQUENCE", "UART", "bulk stream"
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+void Error_Handler(void)
+{
+  printf("Error_Handler called\n");
+  exit(1);
+}
+
+uint32_t HAL_GetTick(void)
+{
+  return sim_tick;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+  sim_tick += Delay;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  return ((GPIOx->IDR & GPIO_Pin) != 0U) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+  return SystemCoreClock / 2U;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+  huart->RxState = HAL_UART_STATE_BUSY_RX;
+  dma_area = pData;
+  dma_size = Size;
+  dma_pos = 0U;
+  return HAL_OK;
+}
+
+void LAMP_FADE_Init(void)
+{
+}
+
+void LAMP_FADE_SetLevel(uint8_t level, uint8_t fade)
+{
+  fade_level = level;
+  fade_time = fade;
+}
+
+void LAMP_FADE_Write(uint8_t state)
+{
+  fade_state = state;
+}
+
+/* USB low level driver: the class and core see a PCD that accepts every
+   transfer at once; the simulated host completes them */
+
+USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
+{
+  memset(sim_in, 0, sizeof(sim_in));
+  memset(sim_out, 0, sizeof(sim_out));
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_DeInit(USBD_HandleTypeDef *pdev)
+{
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Start(USBD_HandleTypeDef *pdev)
+{
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Stop(USBD_HandleTypeDef *pdev)
+{
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_OpenEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t ep_type, uint16_t ep_mps)
+{
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  SimEp_t *ep = ((ep_addr & 0x80U) != 0U) ? &sim_in[ep_addr & 0xFU] : &sim_out[ep_addr & 0xFU];
+
+  ep->pending = 0U;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_FlushEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_StallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  /* The core also stalls EP0 at the end of every control transfer; the
+     host tells a refused transfer by the missing status stage */
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_ClearStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  return USBD_OK;
+}
+
+uint8_t USBD_LL_IsStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  return 0U;
+}
+
+USBD_StatusTypeDef USBD_LL_SetUSBAddress(USBD_HandleTypeDef *pdev, uint8_t dev_addr)
+{
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint16_t size)
+{
+  SimEp_t *ep = &sim_in[ep_addr & 0xFU];
+
+  /* The class must wait for DataIn before it starts the next report */
+  CHECK(((ep_addr & 0xFU) == 0U) || (ep->pending == 0U));
+  ep->buf = pbuf;
+  ep->size = size;
+  ep->pending = 1U;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint16_t size)
+{
+  SimEp_t *ep = &sim_out[ep_addr & 0xFU];
+
+  ep->buf = pbuf;
+  ep->size = size;
+  ep->pending = 1U;
+  return USBD_OK;
+}
+
+uint32_t USBD_LL_GetRxDataSize(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  return sim_out[ep_addr & 0xFU].len;
+}
+
+void USBD_LL_Delay(uint32_t Delay)
+{
+}
+
+void *USBD_static_malloc(uint32_t size)
+{
+  return (size <= sizeof(usbd_class_mem)) ? usbd_class_mem : NULL;
+}
+
+void USBD_static_free(void *p)
+{
+}
+
+/**
+  * @brief  Deliver one OUT packet into the buffer armed on the endpoint.
+  */
+static void host_packet_out(uint8_t epnum, const uint8_t *data, uint32_t len)
+{
+  SimEp_t *ep = &sim_out[epnum];
+
+  CHECK(ep->pending && (len <= ep->size));
+  if ((len != 0U) && (ep->buf != NULL))
+  {
+    memcpy(ep->buf, data, len);
+  }
+  ep->len = len;
+  ep->pending = 0U;
+  USBD_LL_DataOutStage(&hUsbDeviceFS, epnum, (ep->buf != NULL) ? (ep->buf + len) : NULL);
+}
+
+static void host_setup(uint8_t bmRequest, uint8_t bRequest, uint16_t wValue,
+                       uint16_t wIndex, uint16_t wLength)
+{
+  uint8_t setup[8];
+
+  setup[0] = bmRequest;
+  setup[1] = bRequest;
+  setup[2] = (uint8_t)wValue;
+  setup[3] = (uint8_t)(wValue >> 8);
+  setup[4] = (uint8_t)wIndex;
+  setup[5] = (uint8_t)(wIndex >> 8);
+  setup[6] = (uint8_t)wLength;
+  setup[7] = (uint8_t)(wLength >> 8);
+  sim_in[0].pending = 0U;
+  USBD_LL_SetupStage(&hUsbDeviceFS, setup);
+}
+
+/**
+  * @brief  Control write: SETUP, DATA OUT in EP0 sized packets, status IN.
+  * @retval 1 if the device acknowledged the status stage, 0 if it stalled
+  */
+static uint8_t host_ctrl_out(uint8_t bmRequest, uint8_t bRequest, uint16_t wValue,
+                             uint16_t wIndex, const uint8_t *data, uint16_t len)
+{
+  uint16_t done = 0U;
+  uint16_t chunk;
+
+  host_setup(bmRequest, bRequest, wValue, wIndex, len);
+  while ((done < len) && sim_out[0].pending && !sim_in[0].pending)
+  {
+    chunk = (uint16_t)MIN((uint32_t)(len - done), EP0_SIZE);
+    host_packet_out(0U, &data[done], chunk);
+    done += chunk;
+  }
+  if (!sim_in[0].pending || (sim_in[0].size != 0U))
+  {
+    return 0U;
+  }
+  sim_in[0].pending = 0U;
+  USBD_LL_DataInStage(&hUsbDeviceFS, 0U, NULL);
+  return 1U;
+}
+
+/**
+  * @brief  Control read: SETUP, DATA IN in EP0 sized packets, status OUT.
+  * @retval bytes received
+  */
+static uint16_t host_ctrl_in(uint8_t bmRequest, uint8_t bRequest, uint16_t wValue,
+                             uint16_t wIndex, uint8_t *data, uint16_t len)
+{
+  uint16_t done = 0U;
+  uint16_t chunk;
+
+  host_setup(bmRequest, bRequest, wValue, wIndex, len);
+  while ((hUsbDeviceFS.ep0_state == USBD_EP0_DATA_IN) && sim_in[0].pending)
+  {
+    chunk = (uint16_t)MIN(sim_in[0].size, EP0_SIZE);
+    CHECK((done + chunk) <= len);
+    memcpy(&data[done], sim_in[0].buf, chunk);
+    done += chunk;
+    sim_in[0].pending = 0U;
+    USBD_LL_DataInStage(&hUsbDeviceFS, 0U, sim_in[0].buf + chunk);
+  }
+  CHECK(hUsbDeviceFS.ep0_state == USBD_EP0_STATUS_OUT);
+  host_packet_out(0U, NULL, 0U);
+  return done;
+}
+
+/**
+  * @brief  Reset, read the descriptors the host driver asks for and select
+  *         the configuration.
+  */
+static void host_enumerate(void)
+{
+  uint8_t desc[256];
+
+  USBD_LL_SetSpeed(&hUsbDeviceFS, USBD_SPEED_FULL);
+  USBD_LL_Reset(&hUsbDeviceFS);
+
+  CHECK(host_ctrl_in(0x80U, USB_REQ_GET_DESCRIPTOR, USB_DESC_TYPE_DEVICE << 8, 0U, desc, 64U) == USB_LEN_DEV_DESC);
+  CHECK(desc[1] == USB_DESC_TYPE_DEVICE);
+  CHECK(host_ctrl_out(0x00U, USB_REQ_SET_ADDRESS, 7U, 0U, NULL, 0U));
+  CHECK(host_ctrl_in(0x80U, USB_REQ_GET_DESCRIPTOR, USB_DESC_TYPE_CONFIGURATION << 8, 0U, desc, 255U) == USB_WINUSB_CONFIG_DESC_SIZ);
+  CHECK(host_ctrl_in(0x80U, USB_REQ_GET_DESCRIPTOR, USB_DESC_TYPE_BOS << 8, 0U, desc, 255U) > 5U);
+  /* Microsoft OS 2.0 descriptor set: more than two EP0 packets */
+  CHECK(host_ctrl_in(0xC0U, 0x20U, 0U, 7U, desc, 255U) == 0xA2U);
+  CHECK(host_ctrl_out(0x00U, USB_REQ_SET_CONFIGURATION, 1U, 0U, NULL, 0U));
+  CHECK(hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED);
+  CHECK(sim_out[WINUSB_EPOUT_ADDR].pending);
+}
+
+/**
+  * @brief  Select an alternate setting; its OUT endpoint must be armed.
+  */
+static void host_set_alt(uint8_t alt)
+{
+  uint8_t current = 0xFFU;
+
+  CHECK(host_ctrl_out(0x01U, USB_REQ_SET_INTERFACE, alt, 0U, NULL, 0U));
+  CHECK(host_ctrl_in(0x81U, USB_REQ_GET_INTERFACE, 0U, 0U, &current, 1U) == 1U);
+  CHECK(current == alt);
+  host_alt = alt;
+  CHECK(sim_out[(alt == WINUSB_ALT_STREAM) ? WINUSB_BULK_EPOUT_ADDR : WINUSB_EPOUT_ADDR].pending);
+}
+
+/**
+  * @brief  Lamp state last written to the on-board LEDs.
+  */
+static uint8_t lamps_board_state(void)
+{
+  uint32_t bsrr = GPIOE->BSRR;
+
+  return (uint8_t)(((bsrr & LD6_Pin) ? LAMPS_STATE_GREEN : 0U) |
+                   ((bsrr & LD5_Pin) ? LAMPS_STATE_YELLOW : 0U) |
+                   ((bsrr & LD3_Pin) ? LAMPS_STATE_RED : 0U));
+}
+
+/**
+  * @brief  One main loop pass, then whatever the host sees on the IN
+  *         endpoint.
+  */
+static void device_run(void)
+{
+  uint8_t report[TELEMETRY_REPORT_SIZE];
+  uint8_t epnum = ((host_alt == WINUSB_ALT_STREAM) ? WINUSB_BULK_EPIN_ADDR : WINUSB_EPIN_ADDR) & 0xFU;
+  uint32_t commands;
+
+  APP_LOOP_Process();
+  APP_EVT_WaitForEvent();
+
+  if (sim_in[epnum].pending)
+  {
+    CHECK(sim_in[epnum].size == TELEMETRY_REPORT_SIZE);
+    memcpy(report, sim_in[epnum].buf, TELEMETRY_REPORT_SIZE);
+    sim_in[epnum].pending = 0U;
+    USBD_LL_DataInStage(&hUsbDeviceFS, epnum, NULL);
+
+    commands = report[4] | (report[5] << 8) | (report[6] << 16) | ((uint32_t)report[7] << 24);
+    CHECK(report[0] == TELEMETRY_VERSION);
+    CHECK(report[1] == expect_state);
+    CHECK(commands == expect_commands);
+    reports++;
+  }
+}
+
+/**
+  * @brief  One burst on the line, as in test_uart_cmd.c.
+  */
+static void sim_burst(const uint8_t *data, uint32_t len)
+{
+  uint32_t i;
+
+  for (i = 0U; i < len; i++)
+  {
+    dma_area[dma_pos++] = data[i];
+    if (dma_pos == (dma_size / 2U))
+    {
+      HAL_UARTEx_RxEventCallback(&huart1, dma_pos);
+    }
+    else if (dma_pos == dma_size)
+    {
+      HAL_UARTEx_RxEventCallback(&huart1, dma_size);
+      dma_pos = 0U;
+    }
+  }
+  if ((len != 0U) && (dma_pos != 0U))
+  {
+    HAL_UARTEx_RxEventCallback(&huart1, dma_pos);
+  }
+}
+
+static void cmd_int_out(void)
+{
+  uint8_t report[USBD_WINUSB_OUTREPORT_BUF_SIZE] = {0};
+  static const uint8_t lengths[] = {1U, 2U, 4U, 4U};
+  uint32_t len = lengths[rand() % 4];
+  uint32_t i;
+
+  for (i = 0U; i < len; i++)
+  {
+    report[i] = (uint8_t)rand();
+  }
+  expect_state = report[0] & LAMPS_STATE_MASK;
+  if (len >= 2U)
+  {
+    expect_state |= report[1] & LAMPS_STATE_MASK;
+  }
+  expect_commands++;
+
+  host_packet_out(WINUSB_EPOUT_ADDR, report, len);
+  device_run();
+
+  CHECK(sim_out[WINUSB_EPOUT_ADDR].pending);
+  if (len == 4U)
+  {
+    CHECK((fade_level == report[2]) && (fade_time == report[3]));
+  }
+}
+
+static void cmd_set_report(void)
+{
+  uint8_t report[USBD_WINUSB_OUTREPORT_BUF_SIZE] = {0};
+  uint16_t len = ((rand() % 2) == 0) ? 1U : 4U;
+  uint32_t i;
+
+  for (i = 0U; i < len; i++)
+  {
+    report[i] = (uint8_t)rand();
+  }
+  expect_state = report[0] & LAMPS_STATE_MASK;
+  if (len >= 2U)
+  {
+    expect_state |= report[1] & LAMPS_STATE_MASK;
+  }
+  expect_commands++;
+
+  CHECK(host_ctrl_out(0x21U, WINUSB_REQ_SET_REPORT, 0x0200U, 0U, report, len));
+  device_run();
+
+  if (len == 4U)
+  {
+    CHECK((fade_level == report[2]) && (fade_time == report[3]));
+  }
+}
+
+/**
+  * @brief  Upload a random sequence; one in sixteen has a zero length step
+  *         and must be refused. TIM6 is not simulated, so a started
+  *         sequence stays on the step its phase points at.
+  * @retval 1 if the sequence was valid, 0 otherwise
+  */
+static uint32_t cmd_set_sequence(void)
+{
+  uint8_t seq[LAMP_SEQ_MAX_SIZE];
+  uint32_t count = 1U + ((uint32_t)rand() % LAMP_SEQ_MAX_STEPS);
+  uint32_t phase = (uint32_t)rand() % 0x400U;
+  uint32_t total = 0U;
+  uint8_t malformed = ((rand() % 16) == 0);
+  uint16_t step;
+  uint32_t i;
+
+  seq[0] = (uint8_t)(rand() % 2);
+  seq[1] = (uint8_t)count;
+  seq[2] = (uint8_t)phase;
+  seq[3] = (uint8_t)(phase >> 8);
+  for (i = 0U; i < count; i++)
+  {
+    step = (uint16_t)((((1U + (uint32_t)rand() % 20U)) << 3) | ((uint32_t)rand() & 7U));
+    seq[LAMP_SEQ_HEADER_SIZE + 2U * i] = (uint8_t)step;
+    seq[LAMP_SEQ_HEADER_SIZE + 2U * i + 1U] = (uint8_t)(step >> 8);
+    total += LAMP_SEQ_STEP_UNITS(step);
+  }
+  if (malformed)
+  {
+    seq[LAMP_SEQ_HEADER_SIZE + 2U * (count - 1U)] &= 7U;
+    seq[LAMP_SEQ_HEADER_SIZE + 2U * (count - 1U) + 1U] = 0U;
+  }
+  else
+  {
+    if (phase >= total)
+    {
+      phase = (seq[0] & LAMP_SEQ_FLAG_LOOP) ? (phase % total) : (total - 1U);
+    }
+    for (i = 0U; phase >= LAMP_SEQ_STEP_UNITS(seq[LAMP_SEQ_HEADER_SIZE + 2U * i] |
+                                               (seq[LAMP_SEQ_HEADER_SIZE + 2U * i + 1U] << 8)); i++)
+    {
+      phase -= LAMP_SEQ_STEP_UNITS(seq[LAMP_SEQ_HEADER_SIZE + 2U * i] |
+                                   (seq[LAMP_SEQ_HEADER_SIZE + 2U * i + 1U] << 8));
+    }
+    expect_state = LAMP_SEQ_STEP_STATE(seq[LAMP_SEQ_HEADER_SIZE + 2U * i]);
+    expect_commands++;
+    /* The loaded sequence resets the stream, which resynchronises */
+    stream_synced = 0U;
+  }
+
+  CHECK(host_ctrl_out(0x40U, WINUSB_REQ_SET_SEQUENCE, 0U, 0U, seq,
+                      (uint16_t)(LAMP_SEQ_HEADER_SIZE + count * LAMP_SEQ_STEP_SIZE)) == !malformed);
+  device_run();
+  return malformed ? 0U : 1U;
+}
+
+/**
+  * @retval number of command bytes sent
+  */
+static uint32_t cmd_uart(void)
+{
+  uint8_t burst[UART_BURST_MAX];
+  uint32_t len = 1U + ((uint32_t)rand() % UART_BURST_MAX);
+  uint32_t i;
+
+  for (i = 0U; i < len; i++)
+  {
+    burst[i] = (uint8_t)rand();
+  }
+  expect_state = UART_CMD_STATE(burst[len - 1U]);
+  expect_commands += len;
+
+  sim_burst(burst, len);
+  device_run();
+  return len;
+}
+
+/**
+  * @brief  Send a burst of stream frames on the bulk endpoint and play them
+  *         out. Once synchronised, one frame in 32 skips up to three
+  *         sequence numbers and one in 32 repeats the previous one.
+  * @retval number of frames sent
+  */
+static uint32_t cmd_stream(void)
+{
+  uint8_t frame[WINUSB_BULK_EP_SIZE];
+  uint8_t state[STREAM_FRAMES_MAX * STREAM_STEPS_MAX];
+  uint8_t hold[STREAM_FRAMES_MAX * STREAM_STEPS_MAX];
+  uint32_t frames = 1U + ((uint32_t)rand() % STREAM_FRAMES_MAX);
+  uint32_t steps = 0U;
+  uint32_t f, count, i, r;
+
+  for (f = 0U; f < frames; f++)
+  {
+    r = (uint32_t)rand() % 32U;
+    if (stream_synced && (r == 0U))
+    {
+      frame[0] = (uint8_t)(stream_seq - 1U);
+      stream_reordered++;
+    }
+    else
+    {
+      if (stream_synced && (r == 1U))
+      {
+        r = 1U + ((uint32_t)rand() % 3U);
+        stream_seq += (uint8_t)r;
+        stream_gaps += r;
+      }
+      frame[0] = stream_seq++;
+    }
+    stream_synced = 1U;
+
+    count = 1U + ((uint32_t)rand() % STREAM_STEPS_MAX);
+    frame[1] = (uint8_t)count;
+    for (i = 0U; i < count; i++, steps++)
+    {
+      state[steps] = (uint8_t)rand();
+      hold[steps] = (uint8_t)((uint32_t)rand() % (STREAM_HOLD_MAX_MS + 1U));
+      frame[LAMP_STREAM_HEADER_SIZE + LAMP_STREAM_STEP_SIZE * i] = state[steps];
+      frame[LAMP_STREAM_HEADER_SIZE + LAMP_STREAM_STEP_SIZE * i + 1U] = hold[steps];
+      frame[LAMP_STREAM_HEADER_SIZE + LAMP_STREAM_STEP_SIZE * i + 2U] = 0U;
+    }
+    host_packet_out(WINUSB_BULK_EPOUT_ADDR, frame, LAMP_STREAM_HEADER_SIZE + LAMP_STREAM_STEP_SIZE * count);
+  }
+  stream_frames += frames;
+
+  /* One step starts per loop pass, at the end of the previous step's hold */
+  for (i = 0U; i < steps; i++)
+  {
+    if ((i != 0U) && (hold[i - 1U] != 0U))
+    {
+      sim_tick += hold[i - 1U] - 1U;
+      device_run();
+      CHECK(lamps_board_state() == expect_state);
+      sim_tick++;
+    }
+    expect_state = state[i] & LAMPS_STATE_MASK;
+    device_run();
+    CHECK(lamps_board_state() == expect_state);
+  }
+
+  /* Let the last step run out so the next burst starts from idle */
+  sim_tick += hold[steps - 1U];
+  device_run();
+  CHECK(sim_out[WINUSB_BULK_EPOUT_ADDR].pending);
+  return frames;
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_ns(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+/**
+  * @brief  99th percentile: the host maximum is set by preemption, not by
+  *         the firmware
+  */
+static uint32_t stats_p99(KindStats_t *stats)
+{
+  if (stats->count == 0U)
+  {
+    return 0U;
+  }
+  qsort(stats->ns, stats->count, sizeof(stats->ns[0]), compare_ns);
+  return stats->ns[(stats->count * 99U) / 100U];
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+  KindStats_t stats[KIND_NBR] = {0};
+  uint32_t transactions = BENCH_TRANSACTIONS;
+  uint32_t commands = 0U;
+  uint64_t total_ns = 0U;
+  uint64_t t0, t1;
+  uint32_t n, k, r, cmds, sample;
+
+  srand(1U);
+  if (argc > 1)
+  {
+    transactions = (uint32_t)strtoul(argv[1], NULL, 0);
+  }
+  for (k = 0U; k < KIND_NBR; k++)
+  {
+    stats[k].ns = malloc(transactions * sizeof(uint32_t));
+    if (stats[k].ns == NULL)
+    {
+      printf("out of memory\n");
+      return 1;
+    }
+  }
+
+  /* Start-up as in main() */
+  host_rcc.CFGR = 0x00000400U;
+  APP_EVT_Init();
+  LAMP_SEQ_Init();
+  MX_USB_DEVICE_Init();
+  UART_CMD_Start(&huart1);
+  LAMP_FADE_Init();
+  APP_LOOP_Init();
+  host_enumerate();
+  device_run();
+
+  for (n = 0U; n < transactions; n++)
+  {
+    if ((n % BENCH_ALT_BLOCK) == 0U)
+    {
+      host_set_alt(((n / BENCH_ALT_BLOCK) % 2U) ? WINUSB_ALT_STREAM : WINUSB_ALT_INTERRUPT);
+      device_run();
+    }
+
+    sim_tick++;
+    r = (uint32_t)rand() % 10U;
+    k = (r < 4U) ? KIND_INT_OUT : (r < 6U) ? KIND_SET_REPORT : (r < 7U) ? KIND_SET_SEQUENCE : KIND_UART;
+    if ((k == KIND_INT_OUT) && (host_alt == WINUSB_ALT_STREAM))
+    {
+      k = KIND_STREAM;
+    }
+
+    t0 = now_ns();
+    switch (k)
+    {
+      case KIND_INT_OUT:
+        cmd_int_out();
+        cmds = 1U;
+        break;
+
+      case KIND_SET_REPORT:
+        cmd_set_report();
+        cmds = 1U;
+        break;
+
+      case KIND_SET_SEQUENCE:
+        cmds = cmd_set_sequence();
+        break;
+
+      case KIND_STREAM:
+        cmds = cmd_stream();
+        break;
+
+      default:
+        cmds = cmd_uart();
+        break;
+    }
+    t1 = now_ns();
+
+    CHECK(fade_state == expect_state);
+    CHECK(lamps_board_state() == expect_state);
+    if (failures > 20U)
+    {
+      break;
+    }
+
+    /* Refused sequences are timed like commands but not counted */
+    sample = (uint32_t)((t1 - t0) / ((cmds != 0U) ? cmds : 1U));
+    stats[k].ns[stats[k].count++] = sample;
+    stats[k].commands += cmds;
+    stats[k].total_ns += sample;
+    commands += cmds;
+    total_ns += t1 - t0;
+  }
+
+  /* Heartbeat: the final count must reach the host */
+  sim_tick += TELEMETRY_HEARTBEAT_MS;
+  r = reports;
+  device_run();
+  CHECK(reports == (r + 1U));
+  CHECK(APP_EVT_GetStats()->Dropped == 0U);
+  CHECK(UART_CMD_GetOverruns() == 0U);
+  CHECK(LAMP_STREAM_GetStats()->Frames == stream_frames);
+  CHECK(LAMP_STREAM_GetStats()->SeqGaps == stream_gaps);
+  CHECK(LAMP_STREAM_GetStats()->Reordered == stream_reordered);
+  CHECK(LAMP_STREAM_GetStats()->Malformed == 0U);
+  CHECK(LAMP_STREAM_GetStats()->Dropped == 0U);
+
+  printf("%u transactions, %u commands, %u telemetry reports\n",
+         (unsigned)n, (unsigned)commands, (unsigned)reports);
+  printf("%.0f commands/s\n", (total_ns != 0U) ? (commands * 1e9 / total_ns) : 0.0);
+  printf("%u stream frames, %u sequence gaps, %u repeated\n",
+         (unsigned)stream_frames, (unsigned)stream_gaps, (unsigned)stream_reordered);
+  printf("\nkind            transactions   commands    ns/cmd    p99\n");
+  for (k = 0U; k < KIND_NBR; k++)
+  {
+    printf("%-14s %13u %10u %9.1f %6u\n", kind_name[k], (unsigned)stats[k].count,
+           (unsigned)stats[k].commands,
+           (stats[k].count != 0U) ? ((double)stats[k].total_ns / stats[k].count) : 0.0,
+           (unsigned)stats_p99(&stats[k]));
+    free(stats[k].ns);
+  }
+
+  printf("%s\n", (failures == 0U) ? "PASS" : "FAIL");
+  return (failures == 0U) ? 0 : 1;
+}
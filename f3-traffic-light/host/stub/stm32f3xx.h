@@ -0,0 +1,123 @@
+/**
+  ******************************************************************************
+  * @file           : stm32f3xx.h
+  * @brief          : Host stand-in for the CMSIS device header.
+  ******************************************************************************
+  * Only what the host builds of the application modules use. Barriers map
+  * to a full compiler and CPU barrier, interrupt masking to a flag that the
+  * tests can inspect. Peripheral registers are plain variables defined by
+  * the test programs.
+  ******************************************************************************
+  */
+
+#ifndef __STM32F3xx_H
+#define __STM32F3xx_H
+
+#include <stdint.h>
+
+#define __IO                volatile
+
+#define __DMB()             __sync_synchronize()
+#define __DSB()             __sync_synchronize()
+#define __ISB()             __sync_synchronize()
+#define __WFI()             do { } while (0)
+
+typedef enum
+{
+  TIM6_DAC_IRQn = 54
+} IRQn_Type;
+
+typedef struct
+{
+  __IO uint32_t CTRL;
+  __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+  __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct
+{
+  __IO uint32_t CR1;
+  __IO uint32_t DIER;
+  __IO uint32_t SR;
+  __IO uint32_t EGR;
+  __IO uint32_t CNT;
+  __IO uint32_t PSC;
+  __IO uint32_t ARR;
+} TIM_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t CFGR;
+} RCC_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t IDR;
+  __IO uint32_t ODR;
+  __IO uint32_t BSRR;
+} GPIO_TypeDef;
+
+extern DWT_Type host_dwt;
+extern CoreDebug_Type host_coredebug;
+extern TIM_TypeDef host_tim6;
+extern RCC_TypeDef host_rcc;
+extern GPIO_TypeDef host_gpio[6];
+extern uint32_t host_uid[3];
+extern uint32_t SystemCoreClock;
+
+#define DWT                 (&host_dwt)
+#define CoreDebug           (&host_coredebug)
+#define TIM6                (&host_tim6)
+#define RCC                 (&host_rcc)
+#define GPIOA               (&host_gpio[0])
+#define GPIOB               (&host_gpio[1])
+#define GPIOC               (&host_gpio[2])
+#define GPIOD               (&host_gpio[3])
+#define GPIOE               (&host_gpio[4])
+#define GPIOF               (&host_gpio[5])
+#define UID_BASE            ((uintptr_t)host_uid)
+
+#define DWT_CTRL_CYCCNTENA_Msk          0x00000001U
+#define CoreDebug_DEMCR_TRCENA_Msk      0x01000000U
+
+#define TIM_CR1_CEN         0x0001U
+#define TIM_CR1_URS         0x0004U
+#define TIM_DIER_UIE        0x0001U
+#define TIM_SR_UIF          0x0001U
+#define TIM_EGR_UG          0x0001U
+
+#define RCC_CFGR_PPRE1      0x00000700U
+#define RCC_CFGR_PPRE1_DIV1 0x00000000U
+
+extern uint32_t host_primask;
+
+static inline uint32_t __get_PRIMASK(void)
+{
+  return host_primask;
+}
+
+static inline void __set_PRIMASK(uint32_t primask)
+{
+  host_primask = primask;
+}
+
+static inline void __disable_irq(void)
+{
+  host_primask = 1U;
+}
+
+static inline void __enable_irq(void)
+{
+  host_primask = 0U;
+}
+
+static inline void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+  (void)IRQn;
+}
+
+#endif /* __STM32F3xx_H */
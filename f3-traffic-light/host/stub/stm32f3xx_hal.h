@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * @file           : stm32f3xx_hal.h
+  * @brief          : Host stand-in for the STM32F3 HAL.
+  ******************************************************************************
+  * Declares the HAL types and calls used by the modules built on the host.
+  * The test programs provide the implementations.
+  ******************************************************************************
+  */
+
+#ifndef __STM32F3xx_HAL_H
+#define __STM32F3xx_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stm32f3xx.h"
+
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+#define UNUSED(X)           (void)(X)
+
+typedef enum
+{
+  GPIO_PIN_RESET = 0U,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0          ((uint16_t)0x0001U)
+#define GPIO_PIN_1          ((uint16_t)0x0002U)
+#define GPIO_PIN_3          ((uint16_t)0x0008U)
+#define GPIO_PIN_8          ((uint16_t)0x0100U)
+#define GPIO_PIN_9          ((uint16_t)0x0200U)
+#define GPIO_PIN_10         ((uint16_t)0x0400U)
+#define GPIO_PIN_11         ((uint16_t)0x0800U)
+#define GPIO_PIN_12         ((uint16_t)0x1000U)
+#define GPIO_PIN_13         ((uint16_t)0x2000U)
+#define GPIO_PIN_14         ((uint16_t)0x4000U)
+#define GPIO_PIN_15         ((uint16_t)0x8000U)
+
+#define __HAL_RCC_TIM6_CLK_ENABLE()     do { } while (0)
+
+typedef enum
+{
+  HAL_UART_STATE_RESET   = 0x00U,
+  HAL_UART_STATE_READY   = 0x20U,
+  HAL_UART_STATE_BUSY_RX = 0x22U
+} HAL_UART_StateTypeDef;
+
+typedef struct
+{
+  uint8_t                        *pRxBuffPtr;
+  uint16_t                       RxXferSize;
+  volatile HAL_UART_StateTypeDef RxState;
+} UART_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+
+#endif /* __STM32F3xx_HAL_H */
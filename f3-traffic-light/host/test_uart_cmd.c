@@ -0,0 +1,387 @@
+/**
+  ******************************************************************************
+  * @file           : test_uart_cmd.c
+  * @brief          : Host test of the UART command path.
+  ******************************************************************************
+  * Replays byte streams through uart_cmd.c the way the circular DMA and HAL
+  * deliver them: bytes land in the DMA area, half-transfer and transfer
+  * complete events fire at the fixed positions and an idle-line event ends
+  * every burst. Burst lengths and the points where the main loop drains the
+  * ring are random. The bytes taken out must be the ones sent, in order,
+  * and the last command must give the expected lamp state.
+  *
+  * Usage: test_uart_cmd <captures directory>
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "uart_cmd.h"
+#include "app_events.h"
+
+/* Private define ------------------------------------------------------------*/
+#define CAPTURE_MAX         4096U
+#define REPLAY_ROUNDS       200U
+
+#define CHECK(cond)                                                            \
+  do                                                                           \
+  {                                                                            \
+    if (!(cond))                                                               \
+    {                                                                          \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);          \
+      failures++;                                                              \
+    }                                                                          \
+  } while (0)
+
+/* Private variables ---------------------------------------------------------*/
+uint32_t host_primask;
+
+static UART_HandleTypeDef huart1;
+static uint32_t failures;
+
+/* Simulated DMA: area given to HAL_UARTEx_ReceiveToIdle_DMA and write position */
+static uint8_t *dma_area;
+static uint16_t dma_size;
+static uint16_t dma_pos;
+static uint32_t dma_starts;
+
+/* APP_EVT stand-in */
+static uint32_t evt_posts;
+static uint8_t evt_pending;
+static uint8_t evt_queue_full;
+
+/* Private functions ---------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+  huart->RxState = HAL_UART_STATE_BUSY_RX;
+  dma_area = pData;
+  dma_size = Size;
+  dma_pos = 0U;
+  dma_starts++;
+  return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void)
+{
+  return 0U;
+}
+
+void Error_Handler(void)
+{
+  printf("Error_Handler called\n");
+  exit(1);
+}
+
+uint8_t APP_EVT_Post(APP_EVT_IdTypeDef id, uint32_t value)
+{
+  (void)value;
+  if ((id != APP_EVT_UART_RX) || evt_queue_full)
+  {
+    return 0U;
+  }
+  evt_posts++;
+  evt_pending = 1U;
+  return 1U;
+}
+
+/**
+  * @brief  One burst on the line: the DMA stores the bytes, HAL reports the
+  *         half and full transfer points, then the idle line.
+  */
+static void sim_burst(const uint8_t *data, uint32_t len)
+{
+  uint32_t i;
+
+  for (i = 0U; i < len; i++)
+  {
+    dma_area[dma_pos++] = data[i];
+    if (dma_pos == (dma_size / 2U))
+    {
+      HAL_UARTEx_RxEventCallback(&huart1, dma_pos);
+    }
+    else if (dma_pos == dma_size)
+    {
+      HAL_UARTEx_RxEventCallback(&huart1, dma_size);
+      dma_pos = 0U;
+    }
+  }
+  /* HAL skips the idle event when the DMA stands at the start of the area */
+  if ((len != 0U) && (dma_pos != 0U))
+  {
+    HAL_UARTEx_RxEventCallback(&huart1, dma_pos);
+  }
+}
+
+/**
+  * @brief  Main loop side: dispatch the UART event, applying every byte.
+  * @retval bytes taken out
+  */
+static uint32_t sim_drain(uint8_t *out, uint8_t *state)
+{
+  uint32_t n = 0U;
+  uint8_t byte;
+
+  if (!evt_pending)
+  {
+    return 0U;
+  }
+  evt_pending = 0U;
+  while (UART_CMD_GetByte(&byte))
+  {
+    out[n++] = byte;
+    *state = UART_CMD_STATE(byte);
+  }
+  return n;
+}
+
+static uint32_t load_capture(const char *path, uint8_t *buf, int *expect)
+{
+  FILE *f = fopen(path, "r");
+  char line[256];
+  char *p, *end;
+  uint32_t n = 0U;
+
+  *expect = -1;
+  if (f == NULL)
+  {
+    return 0U;
+  }
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    if (line[0] == '#')
+    {
+      continue;
+    }
+    if (strncmp(line, "expect", 6) == 0)
+    {
+      *expect = (int)strtol(&line[6], NULL, 0);
+      continue;
+    }
+    for (p = line; ; p = end)
+    {
+      unsigned long v = strtoul(p, &end, 16);
+      if ((end == p) || (n == CAPTURE_MAX))
+      {
+        break;
+      }
+      buf[n++] = (uint8_t)v;
+    }
+  }
+  fclose(f);
+  return n;
+}
+
+static void start(void)
+{
+  evt_pending = 0U;
+  evt_queue_full = 0U;
+  UART_CMD_Start(&huart1);
+}
+
+/**
+  * @brief  Replay a capture with random bursts, draining often enough for
+  *         the ring never to overflow.
+  */
+static void test_replay(const char *name, const uint8_t *data, uint32_t len, int expect)
+{
+  static uint8_t out[CAPTURE_MAX];
+  uint32_t round, sent, got, since_drain, burst;
+  uint8_t state = 0U;
+
+  for (round = 0U; round < REPLAY_ROUNDS; round++)
+  {
+    uint32_t overruns = UART_CMD_GetOverruns();
+
+    start();
+    sent = 0U;
+    got = 0U;
+    since_drain = 0U;
+    while (sent < len)
+    {
+      burst = 1U + (uint32_t)rand() % 100U;
+      if (burst > (len - sent))
+      {
+        burst = len - sent;
+      }
+      if ((since_drain + burst) > UART_CMD_RING_SIZE)
+      {
+        got += sim_drain(&out[got], &state);
+        since_drain = 0U;
+      }
+      sim_burst(&data[sent], burst);
+      sent += burst;
+      since_drain += burst;
+      if ((rand() % 3) == 0)
+      {
+        got += sim_drain(&out[got], &state);
+        since_drain = 0U;
+      }
+    }
+    got += sim_drain(&out[got], &state);
+
+    CHECK(got == len);
+    CHECK(memcmp(out, data, len) == 0);
+    CHECK(UART_CMD_GetOverruns() == overruns);
+    if (expect >= 0)
+    {
+      CHECK(state == (uint8_t)expect);
+    }
+  }
+  printf("replay %s: %u bytes x %u rounds\n", name, (unsigned)len, (unsigned)REPLAY_ROUNDS);
+}
+
+/**
+  * @brief  The main loop falls behind: what does not fit the ring is counted
+  *         and the bytes that were kept come out in order.
+  */
+static void test_overrun(void)
+{
+  uint8_t data[UART_CMD_RING_SIZE + 100U];
+  uint8_t out[sizeof(data)];
+  uint32_t overruns, got, i;
+  uint8_t state;
+
+  for (i = 0U; i < sizeof(data); i++)
+  {
+    data[i] = (uint8_t)i;
+  }
+  start();
+  overruns = UART_CMD_GetOverruns();
+  for (i = 0U; i < sizeof(data); i += 20U)
+  {
+    sim_burst(&data[i], ((sizeof(data) - i) < 20U) ? (sizeof(data) - i) : 20U);
+  }
+  got = sim_drain(out, &state);
+
+  CHECK(got == UART_CMD_RING_SIZE);
+  CHECK(memcmp(out, data, UART_CMD_RING_SIZE) == 0);
+  CHECK((UART_CMD_GetOverruns() - overruns) == (sizeof(data) - UART_CMD_RING_SIZE));
+}
+
+/**
+  * @brief  One event per batch of bytes, and a new one once drained. A post
+  *         refused by a full queue is retried on the next reception, or by
+  *         the main loop poll when nothing more is received.
+  */
+static void test_event_posting(void)
+{
+  uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 0};
+  uint8_t out[16];
+  uint8_t state;
+
+  start();
+  evt_posts = 0U;
+  sim_burst(data, 3U);
+  sim_burst(&data[3], 3U);
+  CHECK(evt_posts == 1U);
+  CHECK(sim_drain(out, &state) == 6U);
+
+  sim_burst(data, 1U);
+  CHECK(evt_posts == 2U);
+  CHECK(sim_drain(out, &state) == 1U);
+
+  evt_queue_full = 1U;
+  sim_burst(data, 2U);
+  CHECK(evt_posts == 2U);
+  evt_queue_full = 0U;
+  sim_burst(&data[2], 2U);
+  CHECK(evt_posts == 3U);
+  CHECK(sim_drain(out, &state) == 4U);
+
+  evt_queue_full = 1U;
+  sim_burst(data, 2U);
+  UART_CMD_Poll();
+  CHECK(evt_posts == 3U);
+  evt_queue_full = 0U;
+  UART_CMD_Poll();
+  CHECK(evt_posts == 4U);
+  UART_CMD_Poll();
+  CHECK(evt_posts == 4U);
+  CHECK(sim_drain(out, &state) == 2U);
+  UART_CMD_Poll();
+  CHECK(evt_posts == 4U);
+}
+
+/**
+  * @brief  A blocking error stops the DMA; reception restarts at the start
+  *         of the area and nothing received before is lost.
+  */
+static void test_error_restart(void)
+{
+  uint8_t data[40];
+  uint8_t out[sizeof(data)];
+  uint32_t starts, i;
+  uint8_t state;
+
+  for (i = 0U; i < sizeof(data); i++)
+  {
+    data[i] = (uint8_t)(i * 7U);
+  }
+  start();
+  starts = dma_starts;
+  sim_burst(data, 10U);
+
+  /* Noise error: reception keeps running */
+  HAL_UART_ErrorCallback(&huart1);
+  CHECK(dma_starts == starts);
+
+  /* Overrun: HAL aborted the DMA */
+  huart1.RxState = HAL_UART_STATE_READY;
+  HAL_UART_ErrorCallback(&huart1);
+  CHECK(dma_starts == (starts + 1U));
+  CHECK(dma_pos == 0U);
+
+  sim_burst(&data[10], 30U);
+  CHECK(sim_drain(out, &state) == sizeof(data));
+  CHECK(memcmp(out, data, sizeof(data)) == 0);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+  static uint8_t capture[CAPTURE_MAX];
+  char path[1024];
+  struct dirent *entry;
+  uint32_t len, captures = 0U;
+  DIR *dir;
+  int expect;
+
+  srand(1U);
+
+  if (argc > 1)
+  {
+    dir = opendir(argv[1]);
+    if (dir == NULL)
+    {
+      printf("cannot open %s\n", argv[1]);
+      return 1;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+      if (strstr(entry->d_name, ".hex") == NULL)
+      {
+        continue;
+      }
+      snprintf(path, sizeof(path), "%s/%s", argv[1], entry->d_name);
+      len = load_capture(path, capture, &expect);
+      CHECK(len != 0U);
+      test_replay(entry->d_name, capture, len, expect);
+      captures++;
+    }
+    closedir(dir);
+    CHECK(captures != 0U);
+  }
+
+  test_overrun();
+  test_event_posting();
+  test_error_restart();
+
+  printf("%s\n", (failures == 0U) ? "PASS" : "FAIL");
+  return (failures == 0U) ? 0 : 1;
+}